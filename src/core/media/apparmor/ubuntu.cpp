@@ -24,11 +24,15 @@
 #include <QDBusPendingCall>
 #include <QDBusPendingCallWatcher>
 #include <QDBusReply>
+#include <QDBusServiceWatcher>
 #include <QDebug>
+#include <QHash>
 #include <QString>
+#include <QStringMatcher>
 #include <QUrl>
 #include <QVariantList>
 #include <QVariantMap>
+#include <QVector>
 
 #include <sys/apparmor.h>
 #include <unistd.h> // geteuid()
@@ -116,88 +120,262 @@ QString apparmor::ubuntu::Context::profile_name() const
         str() : (app_id_parts[index_package] + "-" + app_id_parts[index_app]);
 }
 
-apparmor::ubuntu::DBusDaemonRequestContextResolver::DBusDaemonRequestContextResolver():
-    m_connection(QDBusConnection::sessionBus())
+namespace core {
+namespace ubuntu {
+namespace media {
+namespace apparmor {
+namespace ubuntu {
+
+class DBusDaemonRequestContextResolverPrivate
+{
+public:
+    typedef RequestContextResolver::ResolveCallback ResolveCallback;
+
+    struct Lookup
+    {
+        QVector<ResolveCallback> callbacks;
+        // Set if the name changed owner while the lookup was in flight
+        bool stale = false;
+    };
+
+    DBusDaemonRequestContextResolverPrivate();
+
+    void start_lookup(const QString &name);
+    void on_lookup_finished(const QString &name,
+                            QDBusPendingCallWatcher *callWatcher);
+    void forget(const QString &name);
+
+    QDBusConnection m_connection;
+    QString m_dbusServiceName;
+    QDBusServiceWatcher m_watcher;
+    QHash<QString, QSharedPointer<const Context>> m_contexts;
+    QHash<QString, Lookup> m_lookups;
+};
+
+}}}}} // namespace
+
+apparmor::ubuntu::DBusDaemonRequestContextResolverPrivate::DBusDaemonRequestContextResolverPrivate():
+    m_connection(QDBusConnection::sessionBus()),
+    m_dbusServiceName(qEnvironmentVariable("MEDIA_HUB_MOCKED_DBUS",
+                                           "org.freedesktop.DBus"))
 {
+    /* Unique names are never reused, but well-known names can move to a
+     * different client */
+    m_watcher.setWatchMode(QDBusServiceWatcher::WatchForOwnerChange);
+    m_watcher.setConnection(m_connection);
+    QObject::connect(&m_watcher, &QDBusServiceWatcher::serviceOwnerChanged,
+                     &m_watcher, [this](const QString &name) {
+        forget(name);
+    });
 }
 
-void apparmor::ubuntu::DBusDaemonRequestContextResolver::resolve_context_for_dbus_name_async(
-        const QString &name,
-        apparmor::ubuntu::RequestContextResolver::ResolveCallback cb)
+void apparmor::ubuntu::DBusDaemonRequestContextResolverPrivate::start_lookup(
+        const QString &name)
 {
-    const QString dbusServiceName =
-        qEnvironmentVariable("MEDIA_HUB_MOCKED_DBUS", "org.freedesktop.DBus");
+    // Start watching before asking, so that no owner change can be missed
+    m_watcher.addWatchedService(name);
+
     QDBusMessage msg =
-        QDBusMessage::createMethodCall(dbusServiceName,
+        QDBusMessage::createMethodCall(m_dbusServiceName,
                                        "/org/freedesktop/DBus",
                                        "org.freedesktop.DBus",
                                        "GetConnectionCredentials");
     msg.setArguments({ name });
-    QDBusPendingCall call = QDBusConnection::sessionBus().asyncCall(msg);
+    QDBusPendingCall call = m_connection.asyncCall(msg);
     QDBusPendingCallWatcher *callWatcher = new QDBusPendingCallWatcher(call);
     QObject::connect(callWatcher, &QDBusPendingCallWatcher::finished,
-                     [cb](QDBusPendingCallWatcher *callWatcher) {
-        QDBusReply<QVariantMap> reply(*callWatcher);
-        QString appId;
-        if (reply.isValid()) {
-            QVariantMap map = reply.value();
-            QByteArray context = map.value("LinuxSecurityLabel").toByteArray();
-            if (!context.isEmpty()) {
-                aa_splitcon(context.data(), NULL);
-                appId = QString::fromUtf8(context);
-            }
-        } else {
-            QDBusError error = reply.error();
-            qWarning() << "Error getting app ID:" << error.name() <<
-                error.message();
-        }
-        cb(apparmor::ubuntu::Context(appId));
-        callWatcher->deleteLater();
+                     &m_watcher, [this, name](QDBusPendingCallWatcher *w) {
+        on_lookup_finished(name, w);
     });
 }
 
-apparmor::ubuntu::RequestAuthenticator::Result apparmor::ubuntu::ExistingAuthenticator::authenticate_open_uri_request(const apparmor::ubuntu::Context& context, const QUrl &uri)
+void apparmor::ubuntu::DBusDaemonRequestContextResolverPrivate::on_lookup_finished(
+        const QString &name,
+        QDBusPendingCallWatcher *callWatcher)
 {
-    if (context.is_unconfined())
-        return Result{true, "Client allowed access since it's unconfined"};
+    callWatcher->deleteLater();
+    // The callbacks might resolve more names
+    const Lookup lookup = m_lookups.take(name);
 
-    QString path = uri.path();
-    MH_DEBUG("context.profile_name(): %s", qUtf8Printable(context.profile_name()));
-    MH_DEBUG("parsed_uri.path: %s", qUtf8Printable(path));
+    QDBusReply<QVariantMap> reply(*callWatcher);
+    QString appId;
+    if (reply.isValid()) {
+        QVariantMap map = reply.value();
+        QByteArray context = map.value("LinuxSecurityLabel").toByteArray();
+        if (!context.isEmpty()) {
+            aa_splitcon(context.data(), NULL);
+            appId = QString::fromUtf8(context);
+        }
+    } else {
+        QDBusError error = reply.error();
+        qWarning() << "Error getting app ID:" << error.name() <<
+            error.message();
+    }
 
-    // All confined apps can access their own files
-    if (path.contains(".local/share/" + context.package_name() + "/") ||
-        path.contains(".cache/" + context.package_name() + "/") ||
-        path.contains("/run/user/" + QString::number(geteuid()) + "/confined/" + context.package_name()))
+    const QSharedPointer<const Context> context(new Context(appId));
+    if (reply.isValid() && !lookup.stale) {
+        m_contexts.insert(name, context);
+    } else if (!m_contexts.contains(name) && !m_lookups.contains(name)) {
+        m_watcher.removeWatchedService(name);
+    }
+
+    MH_DEBUG("Resolved %s for %d requests", qUtf8Printable(name),
+             lookup.callbacks.count());
+    for (const ResolveCallback &cb: lookup.callbacks) {
+        cb(*context);
+    }
+}
+
+void apparmor::ubuntu::DBusDaemonRequestContextResolverPrivate::forget(
+        const QString &name)
+{
+    m_contexts.remove(name);
+
+    auto i = m_lookups.find(name);
+    if (i != m_lookups.end()) {
+        // Let the lookup complete, but don't cache its result
+        i.value().stale = true;
+    } else {
+        m_watcher.removeWatchedService(name);
+    }
+}
+
+apparmor::ubuntu::DBusDaemonRequestContextResolver::DBusDaemonRequestContextResolver():
+    d_ptr(new DBusDaemonRequestContextResolverPrivate())
+{
+}
+
+apparmor::ubuntu::DBusDaemonRequestContextResolver::~DBusDaemonRequestContextResolver() = default;
+
+void apparmor::ubuntu::DBusDaemonRequestContextResolver::resolve_context_for_dbus_name_async(
+        const QString &name,
+        apparmor::ubuntu::RequestContextResolver::ResolveCallback cb)
+{
+    Q_D(DBusDaemonRequestContextResolver);
+
+    const auto cached = d->m_contexts.find(name);
+    if (cached != d->m_contexts.end()) {
+        cb(*cached.value());
+        return;
+    }
+
+    auto i = d->m_lookups.find(name);
+    if (i != d->m_lookups.end()) {
+        i.value().callbacks.append(cb);
+        return;
+    }
+
+    d->m_lookups[name].callbacks.append(cb);
+    d->start_lookup(name);
+}
+
+namespace core {
+namespace ubuntu {
+namespace media {
+namespace apparmor {
+namespace ubuntu {
+
+/* The rules of ExistingAuthenticator, specialized for a given context: all
+ * the strings the URI path is matched against are built only once. */
+class AuthorizationPolicy
+{
+public:
+    typedef RequestAuthenticator::Result Result;
+
+    AuthorizationPolicy(const Context &context);
+
+    Result authorize(const QUrl &uri);
+
+private:
+    struct Rule
     {
-        return Result
-        {
-            true,
-            "Client can access content in ~/.local/share/" + context.package_name() + " or ~/.cache/" + context.package_name()
-        };
+        // The path must contain at least one of these (if any)...
+        QVector<QStringMatcher> any_of;
+        // ...and all of these
+        QVector<QStringMatcher> all_of;
+        QString reason;
+
+        bool matches(const QString &path) const;
+    };
+
+    int match(const QString &path) const;
+
+    bool m_unconfined;
+    QVector<Rule> m_rules;
+    /* Maps a directory to the rule which allows access to it; since
+     * the rules look for substrings, a rule matching a directory also
+     * matches all the files in it. */
+    QHash<QString, int> m_allowedDirectories;
+};
+
+}}}}} // namespace
+
+bool apparmor::ubuntu::AuthorizationPolicy::Rule::matches(
+        const QString &path) const
+{
+    for (const QStringMatcher &m: all_of) {
+        if (m.indexIn(path) < 0) return false;
+    }
+
+    if (any_of.isEmpty()) return true;
+    for (const QStringMatcher &m: any_of) {
+        if (m.indexIn(path) >= 0) return true;
     }
+    return false;
+}
+
+apparmor::ubuntu::AuthorizationPolicy::AuthorizationPolicy(
+        const apparmor::ubuntu::Context &context):
+    m_unconfined(context.is_unconfined())
+{
+    if (m_unconfined) return;
+
+    const QString pkg = context.package_name();
+    const QString profile = context.profile_name();
+    MH_DEBUG("Building authorization policy for %s (%s)",
+             qUtf8Printable(profile), qUtf8Printable(pkg));
+
+    auto matchers = [](const QStringList &needles) {
+        QVector<QStringMatcher> ret;
+        for (const QString &needle: needles) {
+            // An empty needle is contained in any path
+            if (!needle.isEmpty()) ret.append(QStringMatcher(needle));
+        }
+        return ret;
+    };
+
+    // All confined apps can access their own files
+    m_rules.append({
+        matchers({
+            ".local/share/" + pkg + "/",
+            ".cache/" + pkg + "/",
+            "/run/user/" + QString::number(geteuid()) + "/confined/" + pkg,
+        }), {},
+        "Client can access content in ~/.local/share/" + pkg + " or ~/.cache/" + pkg,
+    });
+
     // Check for trust-store compatible path name using full messaging-app profile_name
-    else if (context.package_name() == "messaging-app" &&
-             /* Since the full APP_ID is not available yet (see aa_query_file_path()), add an exception: */
-             (path.contains(".local/share/com.ubuntu." + context.profile_name() + "/") ||
-             path.contains(".cache/com.ubuntu." + context.profile_name() + "/")))
-    {
-        return Result
-        {
-            true,
-            "Client can access content in ~/.local/share/" + context.profile_name() + " or ~/.cache/" + context.profile_name()
-        };
-    }
-    else if (path.contains("opt/click.ubuntu.com/") &&
-             path.contains(context.package_name()))
-    {
-        return Result{true, "Client can access content in own opt directory"};
+    if (pkg == "messaging-app") {
+        /* Since the full APP_ID is not available yet (see aa_query_file_path()), add an exception: */
+        m_rules.append({
+            matchers({
+                ".local/share/com.ubuntu." + profile + "/",
+                ".cache/com.ubuntu." + profile + "/",
+            }), {},
+            "Client can access content in ~/.local/share/" + profile + " or ~/.cache/" + profile,
+        });
     }
-    else if ((path.contains("/system/media/audio/ui/") ||
-              path.contains("/android/system/media/audio/ui/")) &&
-              context.package_name() == "com.ubuntu.camera")
-    {
-        return Result{true, "Camera app can access ui sounds"};
+
+    m_rules.append({
+        {}, matchers({ "opt/click.ubuntu.com/", pkg }),
+        "Client can access content in own opt directory",
+    });
+
+    if (pkg == "com.ubuntu.camera") {
+        m_rules.append({
+            matchers({ "/system/media/audio/ui/" }), {},
+            "Camera app can access ui sounds",
+        });
     }
 
     // TODO: Check if the trust store previously allowed direct access to uri
@@ -205,25 +383,74 @@ apparmor::ubuntu::RequestAuthenticator::Result apparmor::ubuntu::ExistingAuthent
     // Check in ~/Music and ~/Videos
     // TODO: when the trust store lands, check it to see if this app can access the dirs and
     // then remove the explicit whitelist of the music-app, and gallery-app
-    else if ((context.package_name() == "com.ubuntu.music" || context.package_name() == "com.ubuntu.gallery" ||
-              context.profile_name() == unity_name || context.profile_name() == unity8_snap_name ||
-              context.profile_name() == mediaplayer_snap_name || context.profile_name() == music_snap_name) &&
-            (path.contains("Music/") ||
-             path.contains("Videos/") ||
-             path.contains("/media")))
-    {
-        return Result{true, "Client can access content in ~/Music or ~/Videos"};
+    if (pkg == "com.ubuntu.music" || pkg == "com.ubuntu.gallery" ||
+        profile == unity_name || profile == unity8_snap_name ||
+        profile == mediaplayer_snap_name || profile == music_snap_name) {
+        m_rules.append({
+            matchers({ "Music/", "Videos/", "/media" }), {},
+            "Client can access content in ~/Music or ~/Videos",
+        });
     }
-    else if (path.contains("/usr/share/sounds"))
-    {
-        return Result{true, "Client can access content in /usr/share/sounds"};
+
+    m_rules.append({
+        matchers({ "/usr/share/sounds" }), {},
+        "Client can access content in /usr/share/sounds",
+    });
+}
+
+int apparmor::ubuntu::AuthorizationPolicy::match(const QString &path) const
+{
+    for (int i = 0; i < m_rules.count(); i++) {
+        if (m_rules[i].matches(path)) return i;
+    }
+    return -1;
+}
+
+apparmor::ubuntu::AuthorizationPolicy::Result
+apparmor::ubuntu::AuthorizationPolicy::authorize(const QUrl &uri)
+{
+    static const int maxCachedDirectories = 256;
+
+    if (m_unconfined)
+        return Result{true, "Client allowed access since it's unconfined"};
+
+    const QString path = uri.path();
+    const QString dir = path.left(path.lastIndexOf('/') + 1);
+
+    int rule = m_allowedDirectories.value(dir, -1);
+    if (rule < 0) {
+        rule = match(dir);
+        if (rule >= 0) {
+            if (m_allowedDirectories.count() >= maxCachedDirectories) {
+                m_allowedDirectories.clear();
+            }
+            m_allowedDirectories.insert(dir, rule);
+        } else {
+            // The file name might still match some rule
+            rule = match(path);
+        }
     }
-    else if (uri.scheme() == "http" ||
-             uri.scheme() == "https" ||
-             uri.scheme() == "rtsp")
+    if (rule >= 0) return Result{true, m_rules[rule].reason};
+
+    if (uri.scheme() == "http" ||
+        uri.scheme() == "https" ||
+        uri.scheme() == "rtsp")
     {
         return Result{true, "Client can access streaming content"};
     }
 
     return Result{false, "Client is not allowed to access: " + uri.toString()};
 }
+
+apparmor::ubuntu::ExistingAuthenticator::ExistingAuthenticator() = default;
+
+apparmor::ubuntu::ExistingAuthenticator::~ExistingAuthenticator() = default;
+
+apparmor::ubuntu::RequestAuthenticator::Result apparmor::ubuntu::ExistingAuthenticator::authenticate_open_uri_request(const apparmor::ubuntu::Context& context, const QUrl &uri)
+{
+    QSharedPointer<AuthorizationPolicy> &policy = m_policies[context.str()];
+    if (!policy) {
+        policy.reset(new AuthorizationPolicy(context));
+    }
+    return policy->authorize(uri);
+}
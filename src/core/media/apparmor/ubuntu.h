@@ -21,6 +21,8 @@
 #include <core/media/apparmor/context.h>
 
 #include <QDBusConnection>
+#include <QHash>
+#include <QScopedPointer>
 #include <QSharedPointer>
 #include <QStringList>
 
@@ -101,17 +103,25 @@ protected:
 
 // An implementation of RequestContextResolver that queries the dbus
 // daemon to resolve the apparmor context.
+//
+// Resolved contexts are cached per bus name, until the name changes owner;
+// requests for a name whose lookup is still in flight wait for its result
+// instead of starting a new one. Therefore, the callback might be invoked
+// before resolve_context_for_dbus_name_async() returns.
+class DBusDaemonRequestContextResolverPrivate;
 class DBusDaemonRequestContextResolver : public RequestContextResolver
 {
 public:
     // Constructs a new instance for the given bus connection.
     DBusDaemonRequestContextResolver();
+    ~DBusDaemonRequestContextResolver();
 
     // From RequestContextResolver
     void resolve_context_for_dbus_name_async(const QString &name, ResolveCallback) override;
 
 private:
-    QDBusConnection m_connection;
+    Q_DECLARE_PRIVATE(DBusDaemonRequestContextResolver)
+    QScopedPointer<DBusDaemonRequestContextResolverPrivate> d_ptr;
 };
 
 // Abstracts an apparmor-based authentication of
@@ -143,11 +153,20 @@ protected:
 
 // Takes the existing logic and exposes it as an implementation
 // of the RequestAuthenticator interface.
+//
+// The rules are compiled once per context, and the directories found to be
+// accessible are remembered, so that checking many files from the same
+// directories is cheap.
+class AuthorizationPolicy;
 struct ExistingAuthenticator : public RequestAuthenticator
 {
-    ExistingAuthenticator() = default;
+    ExistingAuthenticator();
+    ~ExistingAuthenticator();
     // From RequestAuthenticator
     Result authenticate_open_uri_request(const Context&, const QUrl &uri) override;
+
+private:
+    QHash<QString, QSharedPointer<AuthorizationPolicy>> m_policies;
 };
 
 }
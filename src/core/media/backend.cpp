@@ -18,32 +18,83 @@
 
 #include "player.h"
 
+#include "logging.h"
+
 #include <gst/gst.h>
 
 namespace media = core::ubuntu::media;
 
-media::AVBackend::Backend media::AVBackend::get_backend_type()
+namespace {
+
+bool has_plugin(GstRegistry *registry, const char *file_name)
 {
-    GstRegistry *registry;
-    GstPlugin *plugin;
+    GstPlugin *plugin = gst_registry_lookup(registry, file_name);
+    if (!plugin) return false;
+    gst_object_unref(plugin);
+    return true;
+}
 
-    registry = gst_registry_get();
+bool has_element(GstRegistry *registry, const char *name)
+{
+    GstPluginFeature *feature =
+        gst_registry_find_feature(registry, name, GST_TYPE_ELEMENT_FACTORY);
+    if (!feature) return false;
+    gst_object_unref(feature);
+    return true;
+}
+
+media::AVBackend::Capabilities probe_capabilities()
+{
+    media::AVBackend::Capabilities caps;
+
+    GstRegistry *registry = gst_registry_get();
     if (not registry)
-        return media::AVBackend::Backend::none;
+        return caps;
+
+    if (has_plugin(registry, "libgstandroidmedia.so"))
+    {
+        caps.backend = media::AVBackend::Backend::hybris;
+        caps.hardware_decoding = true;
+    }
+    else if (has_plugin(registry, "libgstmirsink.so"))
+    {
+        caps.backend = media::AVBackend::Backend::mir;
+    }
 
-    plugin = gst_registry_lookup(registry, "libgstandroidmedia.so");
-    if (plugin)
+    for (const char *sink: { "hybrissink", "mirsink" })
     {
-        gst_object_unref(plugin);
-        return media::AVBackend::Backend::hybris;
+        if (has_element(registry, sink))
+            caps.video_sinks.append(QString::fromLatin1(sink));
     }
 
-    plugin = gst_registry_lookup(registry, "libgstmirsink.so");
-    if (plugin)
+    switch (caps.backend)
     {
-        gst_object_unref(plugin);
-        return media::AVBackend::Backend::mir;
+        case media::AVBackend::Backend::hybris:
+            caps.default_video_sink = QStringLiteral("hybrissink");
+            break;
+        case media::AVBackend::Backend::mir:
+            caps.default_video_sink = QStringLiteral("mirsink");
+            break;
+        default:
+            break;
     }
+    caps.buffer_export = !caps.default_video_sink.isEmpty() &&
+        caps.video_sinks.contains(caps.default_video_sink);
+
+    caps.pitch_correction = has_element(registry, "scaletempo");
 
-    return media::AVBackend::Backend::none;
+    MH_INFO("A/V backend: %d, video sinks: [%s], hardware decoding: %d, "
+            "buffer export: %d, pitch correction: %d",
+            int(caps.backend), qUtf8Printable(caps.video_sinks.join(", ")),
+            caps.hardware_decoding, caps.buffer_export,
+            caps.pitch_correction);
+    return caps;
+}
+
+} // namespace
+
+const media::AVBackend::Capabilities &media::AVBackend::capabilities()
+{
+    static const Capabilities caps = probe_capabilities();
+    return caps;
 }
@@ -0,0 +1,136 @@
+/*
+ * Copyright © 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "content_type_cache.h"
+
+#include "file_identity.h"
+#include "logging.h"
+#include "metadata_store.h"
+
+#include <QCache>
+#include <QMimeDatabase>
+#include <QMimeType>
+#include <QWeakPointer>
+
+namespace media = core::ubuntu::media;
+
+using namespace media;
+
+namespace {
+
+const int maxEntries = 1024;
+
+} // namespace
+
+namespace core {
+namespace ubuntu {
+namespace media {
+
+class ContentTypeCachePrivate
+{
+public:
+    struct Entry
+    {
+        // Invalid for remote URIs
+        FileIdentity identity;
+        QString content_type;
+    };
+
+    ContentTypeCachePrivate(const QSharedPointer<MetaDataStore> &store);
+
+    QString detect(const QUrl &uri);
+
+    QSharedPointer<MetaDataStore> m_store;
+    QMimeDatabase m_mimeDatabase;
+    QCache<QString, Entry> m_entries;
+    int m_detectionCount;
+};
+
+}}} // namespace
+
+ContentTypeCachePrivate::ContentTypeCachePrivate(
+        const QSharedPointer<MetaDataStore> &store):
+    m_store(store),
+    m_entries(maxEntries),
+    m_detectionCount(0)
+{
+}
+
+QString ContentTypeCachePrivate::detect(const QUrl &uri)
+{
+    m_detectionCount++;
+    const QString content_type = m_mimeDatabase.mimeTypeForUrl(uri).name();
+    MH_DEBUG("Detected content type %s for %s",
+             qUtf8Printable(content_type), qUtf8Printable(uri.toString()));
+    return content_type;
+}
+
+ContentTypeCache::ContentTypeCache(const QSharedPointer<MetaDataStore> &store):
+    d_ptr(new ContentTypeCachePrivate(store))
+{
+}
+
+ContentTypeCache::~ContentTypeCache() = default;
+
+QSharedPointer<ContentTypeCache> ContentTypeCache::instance()
+{
+    static QWeakPointer<ContentTypeCache> weakRef;
+
+    QSharedPointer<ContentTypeCache> cache = weakRef.toStrongRef();
+    if (!cache) {
+        cache = QSharedPointer<ContentTypeCache>::create(
+            MetaDataStore::instance());
+        weakRef = cache;
+    }
+    return cache;
+}
+
+QString ContentTypeCache::content_type(const QUrl &uri)
+{
+    Q_D(ContentTypeCache);
+
+    if (uri.isEmpty()) return QString();
+
+    const QString key = uri.toString();
+    FileIdentity identity;
+    if (uri.isLocalFile()) {
+        identity = FileIdentity::forPath(uri.toLocalFile());
+    }
+
+    const ContentTypeCachePrivate::Entry *entry = d->m_entries.object(key);
+    if (entry && entry->identity == identity) {
+        return entry->content_type;
+    }
+
+    QString content_type;
+    if (!d->m_store || !d->m_store->lookup_content_type(uri, &content_type)) {
+        content_type = d->detect(uri);
+        if (d->m_store && !content_type.isEmpty()) {
+            d->m_store->store_content_type(uri, content_type);
+        }
+    }
+
+    d->m_entries.insert(key,
+        new ContentTypeCachePrivate::Entry { identity, content_type });
+    return content_type;
+}
+
+int ContentTypeCache::detection_count() const
+{
+    Q_D(const ContentTypeCache);
+    return d->m_detectionCount;
+}
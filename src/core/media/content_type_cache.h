@@ -0,0 +1,71 @@
+/*
+ * Copyright © 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef CORE_UBUNTU_MEDIA_CONTENT_TYPE_CACHE_H_
+#define CORE_UBUNTU_MEDIA_CONTENT_TYPE_CACHE_H_
+
+#include <QScopedPointer>
+#include <QSharedPointer>
+#include <QString>
+#include <QUrl>
+
+namespace core
+{
+namespace ubuntu
+{
+namespace media
+{
+
+class MetaDataStore;
+
+/*
+ * Remembers the MIME type of the media files, so that their content is
+ * sniffed only once.
+ *
+ * Entries for local files are bound to the identity of the file (see
+ * FileIdentity), and are dropped when the file changes. The types of files
+ * known to the MetaDataStore are also saved there, so that they survive a
+ * restart of the service.
+ */
+class ContentTypeCachePrivate;
+class ContentTypeCache
+{
+public:
+    /* If `store` is null, the content types are only kept in memory */
+    ContentTypeCache(const QSharedPointer<MetaDataStore> &store);
+    ~ContentTypeCache();
+
+    // Returns an instance shared by all the players
+    static QSharedPointer<ContentTypeCache> instance();
+
+    /* Returns the MIME type name for `uri`, or an empty string if it could
+     * not be determined */
+    QString content_type(const QUrl &uri);
+
+    // Number of times the content type was actually detected
+    int detection_count() const;
+
+private:
+    Q_DECLARE_PRIVATE(ContentTypeCache)
+    QScopedPointer<ContentTypeCachePrivate> d_ptr;
+};
+
+}
+}
+}
+
+#endif // CORE_UBUNTU_MEDIA_CONTENT_TYPE_CACHE_H_
@@ -20,60 +20,66 @@
 
 #include <QDBusConnection>
 #include <QDBusMessage>
-#include <QDebug>
+#include <QElapsedTimer>
 #include <QMetaObject>
 #include <QMetaMethod>
 #include <QMetaProperty>
 #include <QString>
+#include <QTimer>
 #include <QVariantList>
 #include <QVariantMap>
 #include <QVector>
 
 class DBusPropertyNotifierPrivate: public QObject
 {
-    Q_OBJECT
-
 public:
     DBusPropertyNotifierPrivate(const QDBusConnection &connection,
                                 const QString &objectPath,
                                 QObject *target);
 
+    /* The NOTIFY signals of all the properties are connected to this object,
+     * using the position of the property in m_properties as method ID: this
+     * method is therefore the only dispatcher, whatever the number of
+     * properties. */
+    int qt_metacall(QMetaObject::Call call, int id, void **args) override;
+
     void findInterfaceName(const QMetaObject *mo);
     void connectAllProperties(const QMetaObject *mo);
+    void onChanged(int propertyIndex);
     void deliverNotifySignal();
     void notify(const QStringList &propertyFilter);
-
-private Q_SLOTS:
-    void onChanged(int propertyIndex);
-    void onPropertyChanged0() { onChanged(0); }
-    void onPropertyChanged1() { onChanged(1); }
-    void onPropertyChanged2() { onChanged(2); }
-    void onPropertyChanged3() { onChanged(3); }
-    void onPropertyChanged4() { onChanged(4); }
-    void onPropertyChanged5() { onChanged(5); }
-    void onPropertyChanged6() { onChanged(6); }
-    void onPropertyChanged7() { onChanged(7); }
-    void onPropertyChanged8() { onChanged(8); }
-    void onPropertyChanged9() { onChanged(9); }
-    void onPropertyChanged10() { onChanged(10); }
-    void onPropertyChanged11() { onChanged(11); }
-    void onPropertyChanged12() { onChanged(12); }
-    void onPropertyChanged13() { onChanged(13); }
-    void onPropertyChanged14() { onChanged(14); }
-    void onPropertyChanged15() { onChanged(15); }
-    void onPropertyChanged16() { onChanged(16); }
-    void onPropertyChanged17() { onChanged(17); }
-    void onPropertyChanged18() { onChanged(18); }
-    void onPropertyChanged19() { onChanged(19); }
+    void send(const QVariantMap &changedProperties);
 
 private:
+    friend class DBusPropertyNotifier;
+
+    struct Property {
+        QMetaProperty metaProperty;
+        // The value last sent over D-Bus
+        QVariant value;
+        bool changed = false;
+
+        /* Returns true (and remembers the new value) if the value of the
+         * property differs from the one last sent */
+        bool update(QObject *target) {
+            QVariant newValue = metaProperty.read(target);
+            if (newValue.userType() == value.userType() && newValue == value) {
+                return false;
+            }
+            value.swap(newValue);
+            return true;
+        }
+    };
+
     QDBusConnection m_connection;
     QString m_objectPath;
     QString m_interface;
     QObject *m_target;
+    QVector<Property> m_properties;
     QVector<int> m_changedPropertyIndexes;
-    QVector<QMetaProperty> m_properties;
-    QVariantMap m_lastValues;
+    int m_interval;
+    QTimer m_deliveryTimer;
+    QElapsedTimer m_lastDelivery;
 };
 
 DBusPropertyNotifierPrivate::DBusPropertyNotifierPrivate(
@@ -82,11 +88,33 @@ DBusPropertyNotifierPrivate::DBusPropertyNotifierPrivate(
         QObject *target):
     m_connection(connection),
     m_objectPath(objectPath),
-    m_target(target)
+    m_target(target),
+    m_interval(qEnvironmentVariableIsSet("MEDIA_HUB_PROPERTIES_INTERVAL") ?
+               qEnvironmentVariableIntValue("MEDIA_HUB_PROPERTIES_INTERVAL") :
+               20)
 {
     const QMetaObject *mo = target->metaObject();
     findInterfaceName(mo);
     connectAllProperties(mo);
+
+    m_deliveryTimer.setSingleShot(true);
+    m_deliveryTimer.callOnTimeout(this,
+        &DBusPropertyNotifierPrivate::deliverNotifySignal);
+}
+
+int DBusPropertyNotifierPrivate::qt_metacall(QMetaObject::Call call, int id,
+                                             void **args)
+{
+    id = QObject::qt_metacall(call, id, args);
+    if (id < 0) return id;
+
+    if (call == QMetaObject::InvokeMetaMethod) {
+        if (id < m_properties.count()) {
+            onChanged(id);
+        }
+        id -= m_properties.count();
+    }
+    return id;
 }
 
 void DBusPropertyNotifierPrivate::findInterfaceName(const QMetaObject *mo)
@@ -97,111 +125,91 @@ void DBusPropertyNotifierPrivate::findInterfaceName(const QMetaObject *mo)
 
 void DBusPropertyNotifierPrivate::connectAllProperties(const QMetaObject *mo)
 {
-    QStringList properties;
-    int nextFreeSlot = 0;
-    int indexOfFirstSlot = -1;
-    const QMetaObject *ourMo = metaObject();
-    for (int i = ourMo->methodOffset(); i < ourMo->methodCount(); i++) {
-        if (ourMo->method(i).name().startsWith("onPropertyChanged")) {
-            indexOfFirstSlot = i;
-            break;
-        }
-    }
+    // Our own "slots" come right after those of QObject
+    const int slotOffset = QObject::staticMetaObject.methodCount();
 
+    /* Properties without a NOTIFY signal are also tracked, since they can be
+     * sent via notify() */
     for (int i = mo->propertyOffset(); i < mo->propertyCount(); i++) {
         const QMetaProperty p = mo->property(i);
+        const int propertyIndex = m_properties.count();
+        m_properties.append({ p, QVariant(), false });
+
         if (!p.hasNotifySignal()) continue;
-        const QMetaMethod signalMethod = p.notifySignal();
-        const QMetaMethod slotMethod =
-            ourMo->method(indexOfFirstSlot + nextFreeSlot);
-        if (Q_UNLIKELY(!slotMethod.isValid())) {
-            qWarning() << "No more slots available!";
-            break;
-        }
-        QObject::connect(m_target, signalMethod, this, slotMethod);
-        m_properties.insert(nextFreeSlot, p);
-        nextFreeSlot++;
+        QMetaObject::connect(m_target, p.notifySignalIndex(),
+                             this, slotOffset + propertyIndex,
+                             Qt::DirectConnection);
     }
 }
 
 void DBusPropertyNotifierPrivate::onChanged(int propertyIndex)
 {
-    if (m_changedPropertyIndexes.contains(propertyIndex)) return;
+    /* The value is only read once, when the notification is delivered; until
+     * then, further changes of the same property cost nothing */
+    Property &p = m_properties[propertyIndex];
+    if (p.changed) return;
+    p.changed = true;
+    m_changedPropertyIndexes.append(propertyIndex);
 
-    /* If the property value didn't really change, do nothing */
-    const QMetaProperty &p = m_properties[propertyIndex];
-    const QVariant value = p.read(m_target);
-    if (m_lastValues.value(p.name()) == value) {
-        return;
-    }
+    if (m_deliveryTimer.isActive()) return;
 
-    /* If the list of properties is empty it means we haven't queued the
-     * emission of the notify signal.
-     */
-    if (m_changedPropertyIndexes.isEmpty()) {
-        QMetaObject::invokeMethod(this,
-                &DBusPropertyNotifierPrivate::deliverNotifySignal,
-                Qt::QueuedConnection);
+    /* Send at most one notification per interval: if the last one was sent
+     * long enough ago, just wait for the current event loop iteration to
+     * complete, in order to catch the changes happening together with this
+     * one. */
+    int delay = 0;
+    if (m_lastDelivery.isValid()) {
+        delay = qMax(0, m_interval - int(m_lastDelivery.elapsed()));
     }
-    m_changedPropertyIndexes.append(propertyIndex);
+    m_deliveryTimer.start(delay);
 }
 
 void DBusPropertyNotifierPrivate::deliverNotifySignal()
 {
     QVariantMap changedProperties;
     for (int propertyIndex: m_changedPropertyIndexes) {
-        const QMetaProperty &p = m_properties[propertyIndex];
-        const QVariant value = p.read(m_target);
-        if (m_lastValues.value(p.name()) != value) {
-            changedProperties.insert(p.name(), value);
-            m_lastValues.insert(p.name(), value);
+        Property &p = m_properties[propertyIndex];
+        p.changed = false;
+        if (p.update(m_target)) {
+            changedProperties.insert(p.metaProperty.name(), p.value);
         }
     }
-
-    if (!changedProperties.isEmpty()) {
-        QDBusMessage msg = QDBusMessage::createSignal(m_objectPath,
-                QStringLiteral("org.freedesktop.DBus.Properties"),
-                QStringLiteral("PropertiesChanged"));
-        msg.setArguments({
-            m_interface,
-            changedProperties,
-            QStringList {},
-        });
-        m_connection.send(msg);
-    }
-
     m_changedPropertyIndexes.clear();
+
+    send(changedProperties);
 }
 
 void DBusPropertyNotifierPrivate::notify(const QStringList &propertyFilter)
 {
     QVariantMap changedProperties;
-    const QMetaObject *mo = m_target->metaObject();
-    for (int i = mo->propertyOffset(); i < mo->propertyCount(); i++) {
-        const QMetaProperty p = mo->property(i);
-        const QString propertyName = p.name();
+    for (Property &p: m_properties) {
+        const QString propertyName = p.metaProperty.name();
         if (!propertyFilter.isEmpty() &&
             !propertyFilter.contains(propertyName)) {
             continue;
         }
-        const QVariant value = p.read(m_target);
-        if (m_lastValues.value(propertyName) != value) {
-            changedProperties.insert(propertyName, value);
-            m_lastValues.insert(propertyName, value);
+        if (p.update(m_target)) {
+            changedProperties.insert(propertyName, p.value);
         }
     }
 
-    if (!changedProperties.isEmpty()) {
-        QDBusMessage msg = QDBusMessage::createSignal(m_objectPath,
-                QStringLiteral("org.freedesktop.DBus.Properties"),
-                QStringLiteral("PropertiesChanged"));
-        msg.setArguments({
-            m_interface,
-            changedProperties,
-            QStringList {},
-        });
-        m_connection.send(msg);
-    }
+    send(changedProperties);
+}
+
+void DBusPropertyNotifierPrivate::send(const QVariantMap &changedProperties)
+{
+    if (changedProperties.isEmpty()) return;
+
+    QDBusMessage msg = QDBusMessage::createSignal(m_objectPath,
+            QStringLiteral("org.freedesktop.DBus.Properties"),
+            QStringLiteral("PropertiesChanged"));
+    msg.setArguments({
+        m_interface,
+        changedProperties,
+        QStringList {},
+    });
+    m_connection.send(msg);
+    m_lastDelivery.start();
 }
 
 DBusPropertyNotifier::DBusPropertyNotifier(const QDBusConnection &connection,
@@ -214,10 +222,20 @@ DBusPropertyNotifier::DBusPropertyNotifier(const QDBusConnection &connection,
 
 DBusPropertyNotifier::~DBusPropertyNotifier() = default;
 
+void DBusPropertyNotifier::setInterval(int msecs)
+{
+    Q_D(DBusPropertyNotifier);
+    d->m_interval = qMax(msecs, 0);
+}
+
+int DBusPropertyNotifier::interval() const
+{
+    Q_D(const DBusPropertyNotifier);
+    return d->m_interval;
+}
+
 void DBusPropertyNotifier::notify(const QStringList &propertyFilter)
 {
     Q_D(DBusPropertyNotifier);
     d->notify(propertyFilter);
 }
-
-#include "dbus_property_notifier.moc"
@@ -24,6 +24,16 @@
 
 class QDBusConnection;
 
+/*
+ * Emits the org.freedesktop.DBus.Properties.PropertiesChanged signal for the
+ * D-Bus properties of the `target` object, whenever their NOTIFY signal is
+ * emitted and their value has actually changed.
+ *
+ * Changes are batched: at most one PropertiesChanged signal is emitted per
+ * interval, carrying all the properties changed in the meantime. The default
+ * interval can be set with the MEDIA_HUB_PROPERTIES_INTERVAL environment
+ * variable (in milliseconds).
+ */
 class DBusPropertyNotifierPrivate;
 class DBusPropertyNotifier: public QObject
 {
@@ -35,6 +45,11 @@ public:
                          QObject *target);
     virtual ~DBusPropertyNotifier();
 
+    void setInterval(int msecs);
+    int interval() const;
+
+    /* Immediately emits the changes of the given properties (or of all of
+     * them, if the filter is empty) */
     void notify(const QStringList &propertyFilter = {});
 
 private:
@@ -48,6 +48,7 @@ private:
     Player::Lifetime m_lifetime;
     Player::Orientation m_orientation;
     double m_volume;
+    double m_playbackRate;
     QPair<QUrl,Track::MetaData> m_trackMetadata;
     Player::PlaybackStatus m_playbackStatus;
     QSize m_videoDimension;
@@ -64,6 +65,7 @@ EnginePrivate::EnginePrivate(Engine *q):
     m_lifetime(Player::Lifetime::normal),
     m_orientation(Player::Orientation::rotate0),
     m_volume(1.0),
+    m_playbackRate(1.0),
     q_ptr(q)
 {
 }
@@ -225,3 +227,20 @@ double Engine::volume() const
     Q_D(const Engine);
     return d->m_volume;
 }
+
+bool Engine::setPlaybackRate(double rate)
+{
+    Q_D(Engine);
+    if (rate == d->m_playbackRate) return true;
+    if (!doSetPlaybackRate(rate)) return false;
+
+    d->m_playbackRate = rate;
+    Q_EMIT playbackRateChanged();
+    return true;
+}
+
+double Engine::playbackRate() const
+{
+    Q_D(const Engine);
+    return d->m_playbackRate;
+}
@@ -79,6 +79,10 @@ public:
 
     virtual bool open_resource_for_uri(const QUrl &uri, bool do_pipeline_reset) = 0;
     virtual bool open_resource_for_uri(const QUrl &uri, const Player::HeadersType&) = 0;
+    /* Sets the resource to be played as soon as the current one ends,
+     * without tearing down the pipeline. The nextResourceStarted() signal is
+     * emitted when the switch happens. An empty URI cancels the request. */
+    virtual void set_next_resource_for_uri(const QUrl &uri) = 0;
     // Throws core::ubuntu::media::Player::Error::OutOfProcessBufferStreamingNotSupported if the implementation does not
     // support this feature.
     virtual void create_video_sink(uint32_t texture_id) = 0;
@@ -86,7 +90,8 @@ public:
     virtual bool play() = 0;
     virtual bool stop() = 0;
     virtual bool pause() = 0;
-    virtual bool seek_to(const std::chrono::microseconds& ts) = 0;
+    virtual bool seek_to(const std::chrono::microseconds& ts,
+                         Player::SeekMode mode) = 0;
 
     State state() const;
 
@@ -110,6 +115,12 @@ public:
     void setVolume(double volume);
     double volume() const;
 
+    // Returns false if the rate is not supported
+    bool setPlaybackRate(double rate);
+    double playbackRate() const;
+    virtual double minimumPlaybackRate() const = 0;
+    virtual double maximumPlaybackRate() const = 0;
+
     virtual void reset() = 0;
 
 Q_SIGNALS:
@@ -127,6 +138,7 @@ Q_SIGNALS:
     void trackMetadataChanged();
 
     void aboutToFinish();
+    void nextResourceStarted(const QUrl &uri);
     void seekedTo(uint64_t offset);
     void clientDisconnected();
     void endOfStream();
@@ -134,6 +146,8 @@ Q_SIGNALS:
     void videoDimensionChanged();
     void errorOccurred(Player::Error error);
     void bufferingChanged(int);
+    void playbackRateChanged();
+    void playbackRateRangeChanged();
 
 protected:
     void setMetadataExtractor(const QSharedPointer<MetaDataExtractor> &extractor);
@@ -148,6 +162,7 @@ protected:
     virtual void doSetAudioStreamRole(Player::AudioStreamRole role) = 0;
     virtual void doSetLifetime(Player::Lifetime lifetime) = 0;
     virtual void doSetVolume(double volume) = 0;
+    virtual bool doSetPlaybackRate(double rate) = 0;
 
 private:
     Q_DECLARE_PRIVATE(Engine)
@@ -0,0 +1,80 @@
+/*
+ * Copyright © 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef CORE_UBUNTU_MEDIA_FILE_IDENTITY_H_
+#define CORE_UBUNTU_MEDIA_FILE_IDENTITY_H_
+
+#include <QDataStream>
+#include <QFile>
+#include <QString>
+
+#include <sys/stat.h>
+
+namespace core
+{
+namespace ubuntu
+{
+namespace media
+{
+
+/* Identifies a version of a file: data derived from the file contents can be
+ * reused as long as the identity of the file is unchanged. */
+struct FileIdentity
+{
+    FileIdentity(): size(-1), mtime(0), inode(0) {}
+
+    static FileIdentity forPath(const QString &path)
+    {
+        FileIdentity id;
+        struct stat st;
+        if (::stat(QFile::encodeName(path).constData(), &st) == 0 &&
+            S_ISREG(st.st_mode)) {
+            id.size = st.st_size;
+            id.mtime = qint64(st.st_mtim.tv_sec) * 1000000000 +
+                st.st_mtim.tv_nsec;
+            id.inode = st.st_ino;
+        }
+        return id;
+    }
+
+    bool isValid() const { return size >= 0; }
+
+    bool operator==(const FileIdentity &o) const {
+        return size == o.size && mtime == o.mtime && inode == o.inode;
+    }
+    bool operator!=(const FileIdentity &o) const { return !(*this == o); }
+
+    qint64 size;
+    qint64 mtime;
+    quint64 inode;
+};
+
+inline QDataStream &operator<<(QDataStream &s, const FileIdentity &id)
+{
+    return s << id.size << id.mtime << id.inode;
+}
+
+inline QDataStream &operator>>(QDataStream &s, FileIdentity &id)
+{
+    return s >> id.size >> id.mtime >> id.inode;
+}
+
+}
+}
+}
+
+#endif // CORE_UBUNTU_MEDIA_FILE_IDENTITY_H_
@@ -22,7 +22,7 @@
 #include <gst/gst.h>
 
 #include <QByteArray>
-#include <QHash>
+#include <QVector>
 
 #include <exception>
 #include <functional>
@@ -33,152 +33,57 @@ namespace gstreamer
 class Bus
 {
 public:
+    /* A message delivered by the bus. Only the type is known upfront: the
+     * details are parsed the first time they are accessed, so subscribers
+     * which just look at the type don't pay for parsing. */
     struct Message
     {
-        ~Message()
-        {
-        }
-
         Message(GstMessage* msg)
             : message(msg),
               type(GST_MESSAGE_TYPE(msg)),
-              source(GST_MESSAGE_SRC_NAME(msg)),
-              sequence_number(gst_message_get_seqnum(msg))
+              m_parsed(false)
         {
+        }
+
+        ~Message()
+        {
+            if (!m_parsed) return;
+
             switch(type)
             {
-            case GST_MESSAGE_UNKNOWN:
-                throw std::runtime_error("Cannot construct message for type unknown");
-                break;
             case GST_MESSAGE_ERROR:
-            {
-                gst_message_parse_error(
-                            msg,
-                            &detail.error_warning_info.error,
-                            &detail.error_warning_info.debug);
-                cleanup = [this]()
-                {
-                    g_error_free(detail.error_warning_info.error);
-                    g_free(detail.error_warning_info.debug);
-                };
-                break;
-            }
             case GST_MESSAGE_WARNING:
-                gst_message_parse_warning(
-                            msg,
-                            &detail.error_warning_info.error,
-                            &detail.error_warning_info.debug);
-                cleanup = [this]()
-                {
-                    g_error_free(detail.error_warning_info.error);
-                    g_free(detail.error_warning_info.debug);
-                };
-                break;
             case GST_MESSAGE_INFO:
-                gst_message_parse_info(
-                            msg,
-                            &detail.error_warning_info.error,
-                            &detail.error_warning_info.debug);
-                cleanup = [this]()
-                {
-                    g_error_free(detail.error_warning_info.error);
-                    g_free(detail.error_warning_info.debug);
-                };
+                g_error_free(m_detail.error_warning_info.error);
+                g_free(m_detail.error_warning_info.debug);
                 break;
             case GST_MESSAGE_TAG:
-                gst_message_parse_tag(
-                            msg,
-                            &detail.tag.tag_list);
-                cleanup = [this]()
-                {
-                    gst_tag_list_unref(detail.tag.tag_list);
-                };
-                break;
-            case GST_MESSAGE_BUFFERING:
-                gst_message_parse_buffering(
-                            msg,
-                            &detail.buffering.percent);
-                break;
-            case GST_MESSAGE_STATE_CHANGED:
-                gst_message_parse_state_changed(
-                            msg,
-                            &detail.state_changed.old_state,
-                            &detail.state_changed.new_state,
-                            &detail.state_changed.pending_state);
-                break;
-            case GST_MESSAGE_STEP_DONE:
-                gst_message_parse_step_done(
-                            msg,
-                            &detail.step_done.format,
-                            &detail.step_done.amount,
-                            &detail.step_done.rate,
-                            &detail.step_done.flush,
-                            &detail.step_done.intermediate,
-                            &detail.step_done.duration,
-                            &detail.step_done.eos
-                            );
-                break;
-            case GST_MESSAGE_CLOCK_PROVIDE:
-                gst_message_parse_clock_provide(
-                            msg,
-                            &detail.clock_provide.clock,
-                            &detail.clock_provide.ready);
-                break;
-            case GST_MESSAGE_CLOCK_LOST:
-                gst_message_parse_clock_lost(
-                            msg,
-                            &detail.clock_lost.clock);
-                break;
-            case GST_MESSAGE_NEW_CLOCK:
-                gst_message_parse_new_clock(
-                            msg,
-                            &detail.clock_new.clock);
-                break;
-            case GST_MESSAGE_SEGMENT_START:
-                gst_message_parse_segment_start(
-                            msg,
-                            &detail.segment_start.format,
-                            &detail.segment_start.position);
-                break;
-            case GST_MESSAGE_SEGMENT_DONE:
-                gst_message_parse_segment_done(
-                            msg,
-                            &detail.segment_done.format,
-                            &detail.segment_done.position);
-                break;
-            case GST_MESSAGE_ASYNC_DONE:
-                gst_message_parse_async_done(
-                            msg,
-                            &detail.async_done.running_time);
-                break;
-            case GST_MESSAGE_STEP_START:
-                gst_message_parse_step_start(
-                            msg,
-                            &detail.step_start.active,
-                            &detail.step_start.format,
-                            &detail.step_start.amount,
-                            &detail.step_start.rate,
-                            &detail.step_start.flush,
-                            &detail.step_start.intermediate);
-                break;
-            case GST_MESSAGE_QOS:
-                gst_message_parse_qos(
-                            msg,
-                            &detail.qos.live,
-                            &detail.qos.running_time,
-                            &detail.qos.stream_time,
-                            &detail.qos.timestamp,
-                            &detail.qos.duration);
+                gst_tag_list_unref(m_detail.tag.tag_list);
                 break;
             default:
                 break;
             }
         }
 
+        Message(const Message &) = delete;
+        Message &operator=(const Message &) = delete;
+
+        /* The returned array does not own its data, which belongs to the
+         * message source: copy it if it must outlive the message. */
+        QByteArray source() const
+        {
+            const char *name = GST_MESSAGE_SRC_NAME(message);
+            return name ? QByteArray::fromRawData(name, qstrlen(name)) :
+                QByteArray();
+        }
+
+        uint32_t sequence_number() const
+        {
+            return gst_message_get_seqnum(message);
+        }
+
         GstMessage* message;
         GstMessageType type;
-        QByteArray source; // TODO compute it only when needed
-        uint32_t sequence_number;
 
         union Detail
         {
@@ -266,8 +171,133 @@ public:
                 guint64 timestamp;
                 guint64 duration;
             } qos;
-        } detail;
-        std::function<void()> cleanup;
+        };
+
+        const Detail &detail() const
+        {
+            if (!m_parsed) {
+                parse();
+                m_parsed = true;
+            }
+            return m_detail;
+        }
+
+    private:
+        void parse() const
+        {
+            switch(type)
+            {
+            case GST_MESSAGE_UNKNOWN:
+                throw std::runtime_error("Cannot construct message for type unknown");
+                break;
+            case GST_MESSAGE_ERROR:
+            {
+                gst_message_parse_error(
+                            message,
+                            &m_detail.error_warning_info.error,
+                            &m_detail.error_warning_info.debug);
+                break;
+            }
+            case GST_MESSAGE_WARNING:
+                gst_message_parse_warning(
+                            message,
+                            &m_detail.error_warning_info.error,
+                            &m_detail.error_warning_info.debug);
+                break;
+            case GST_MESSAGE_INFO:
+                gst_message_parse_info(
+                            message,
+                            &m_detail.error_warning_info.error,
+                            &m_detail.error_warning_info.debug);
+                break;
+            case GST_MESSAGE_TAG:
+                gst_message_parse_tag(
+                            message,
+                            &m_detail.tag.tag_list);
+                break;
+            case GST_MESSAGE_BUFFERING:
+                gst_message_parse_buffering(
+                            message,
+                            &m_detail.buffering.percent);
+                break;
+            case GST_MESSAGE_STATE_CHANGED:
+                gst_message_parse_state_changed(
+                            message,
+                            &m_detail.state_changed.old_state,
+                            &m_detail.state_changed.new_state,
+                            &m_detail.state_changed.pending_state);
+                break;
+            case GST_MESSAGE_STEP_DONE:
+                gst_message_parse_step_done(
+                            message,
+                            &m_detail.step_done.format,
+                            &m_detail.step_done.amount,
+                            &m_detail.step_done.rate,
+                            &m_detail.step_done.flush,
+                            &m_detail.step_done.intermediate,
+                            &m_detail.step_done.duration,
+                            &m_detail.step_done.eos
+                            );
+                break;
+            case GST_MESSAGE_CLOCK_PROVIDE:
+                gst_message_parse_clock_provide(
+                            message,
+                            &m_detail.clock_provide.clock,
+                            &m_detail.clock_provide.ready);
+                break;
+            case GST_MESSAGE_CLOCK_LOST:
+                gst_message_parse_clock_lost(
+                            message,
+                            &m_detail.clock_lost.clock);
+                break;
+            case GST_MESSAGE_NEW_CLOCK:
+                gst_message_parse_new_clock(
+                            message,
+                            &m_detail.clock_new.clock);
+                break;
+            case GST_MESSAGE_SEGMENT_START:
+                gst_message_parse_segment_start(
+                            message,
+                            &m_detail.segment_start.format,
+                            &m_detail.segment_start.position);
+                break;
+            case GST_MESSAGE_SEGMENT_DONE:
+                gst_message_parse_segment_done(
+                            message,
+                            &m_detail.segment_done.format,
+                            &m_detail.segment_done.position);
+                break;
+            case GST_MESSAGE_ASYNC_DONE:
+                gst_message_parse_async_done(
+                            message,
+                            &m_detail.async_done.running_time);
+                break;
+            case GST_MESSAGE_STEP_START:
+                gst_message_parse_step_start(
+                            message,
+                            &m_detail.step_start.active,
+                            &m_detail.step_start.format,
+                            &m_detail.step_start.amount,
+                            &m_detail.step_start.rate,
+                            &m_detail.step_start.flush,
+                            &m_detail.step_start.intermediate);
+                break;
+            case GST_MESSAGE_QOS:
+                gst_message_parse_qos(
+                            message,
+                            &m_detail.qos.live,
+                            &m_detail.qos.running_time,
+                            &m_detail.qos.stream_time,
+                            &m_detail.qos.timestamp,
+                            &m_detail.qos.duration);
+                break;
+            default:
+                break;
+            }
+        }
+
+        mutable Detail m_detail;
+        mutable bool m_parsed;
     };
 
     static gboolean bus_watch_handler(
@@ -278,8 +308,11 @@ public:
         (void) bus;
 
         auto thiz = static_cast<Bus*>(data);
-        Message message(msg);
-        thiz->notifyNewMessage(message);
+        // Messages nobody is interested in are dropped without any parsing
+        if (GST_MESSAGE_TYPE(msg) & thiz->m_types) {
+            Message message(msg);
+            thiz->notifyNewMessage(message);
+        }
 
         return true;
     }
@@ -287,6 +320,7 @@ public:
     Bus(GstBus* bus):
         bus(bus),
         m_onNewMessageNextId(1),
+        m_types(GstMessageType(0)),
         bus_watch_id(0)
     {
         set_bus(bus);
@@ -314,24 +348,50 @@ public:
 
     typedef std::function<void(const Message &)> MessageCallback;
 
-    int onNewMessage(const MessageCallback &cb) {
-        m_onNewMessage[m_onNewMessageNextId] = cb;
+    /* The callback is only invoked for messages whose type is in the
+     * `types` mask */
+    int onNewMessage(const MessageCallback &cb,
+                     GstMessageType types = GST_MESSAGE_ANY) {
+        m_onNewMessage.append({ m_onNewMessageNextId, types, cb });
+        m_types = GstMessageType(m_types | types);
         return m_onNewMessageNextId++;
     }
 
     void unsubscribeFromNewMessage(int id) {
-        m_onNewMessage.remove(id);
+        int types = 0;
+        for (auto i = m_onNewMessage.begin(); i != m_onNewMessage.end();) {
+            if (i->id == id) {
+                i = m_onNewMessage.erase(i);
+            } else {
+                types |= i->types;
+                i++;
+            }
+        }
+        m_types = GstMessageType(types);
     }
 
     void notifyNewMessage(const Message &msg) const {
-        for (auto cb: m_onNewMessage) {
-            cb(msg);
+        // A shallow copy, in case a callback changes the subscriptions
+        const QVector<Subscription> subscriptions = m_onNewMessage;
+        for (const Subscription &s: subscriptions) {
+            if (msg.type & s.types) {
+                s.callback(msg);
+            }
         }
     }
 
+    struct Subscription
+    {
+        int id;
+        GstMessageType types;
+        MessageCallback callback;
+    };
+
     GstBus* bus;
-    QHash<int,MessageCallback> m_onNewMessage;
+    QVector<Subscription> m_onNewMessage;
     int m_onNewMessageNextId;
+    // Union of the types all subscribers are interested in
+    GstMessageType m_types;
     guint bus_watch_id;
 };
 }
@@ -25,15 +25,26 @@
 #include "engine.h"
 #include "meta_data_extractor.h"
 #include "playbin.h"
+#include "playbin_pool.h"
 
 #include "core/media/logging.h"
 
+#include <QTimer>
+
 #include <cassert>
 
 namespace media = core::ubuntu::media;
 
 using namespace std;
 
+namespace {
+
+/* During playback, tags keep coming (for instance, the bitrate of streams):
+ * they are published at most this often */
+const int metadataUpdateInterval = 500; // milliseconds
+
+} // namespace
+
 namespace gstreamer
 {
 struct Init
@@ -77,6 +88,11 @@ public:
         {
             MH_INFO("State changed on playbin: %s",
                       gst_element_state_get_name(state.new_state));
+            const bool was_prerolled = prerolled;
+            prerolled = state.new_state >= GST_STATE_PAUSED;
+            // Publish the tags collected while prerolling all at once
+            if (prerolled && !was_prerolled)
+                publish_metadata();
             const auto status = gst_state_to_player_status(state);
             /*
              * When state moves to "paused" the pipeline is already set. We check that we
@@ -220,24 +236,88 @@ public:
     }
 
     void on_tag_available(const gstreamer::Bus::Message::Detail::Tag& tag)
+    {
+        // Tags are merged in place and published later, in a single update
+        gstreamer::MetaDataExtractor::on_tag_available(tag, &metadata);
+        metadata_dirty = true;
+        if (prerolled && !metadata_timer.isActive())
+            metadata_timer.start();
+    }
+
+    // Called whenever a new track is opened or started gaplessly
+    void reset_metadata(const QUrl &uri)
+    {
+        if (!metadata_uri.isEmpty())
+        {
+            // The last tags of the previous track are still worth having
+            publish_metadata();
+            MH_DEBUG("Published %d metadata updates for %s",
+                     metadata_updates,
+                     qUtf8Printable(metadata_uri.toString()));
+        }
+        metadata_uri = uri;
+        metadata.clear();
+        metadata_dirty = false;
+        metadata_updates = 0;
+        metadata_timer.stop();
+    }
+
+    void publish_metadata()
     {
         Q_Q(Engine);
-        media::Track::MetaData md;
+        metadata_timer.stop();
+        if (!metadata_dirty)
+            return;
 
-        // We update instead of creating from scratch if same uri
-        auto pair = q->trackMetadata();
-        if (playbin.uri() == pair.first)
-            md = pair.second;
+        metadata_dirty = false;
+        metadata_updates++;
+        q->setTrackMetadata(qMakePair(metadata_uri, metadata));
+    }
 
-        gstreamer::MetaDataExtractor::on_tag_available(tag, &md);
-        q->setTrackMetadata(qMakePair(playbin.uri(), md));
+    void change_state(GstState gst_state, media::Engine::State state)
+    {
+        Q_Q(Engine);
+        pending_state_changes++;
+        /* The engine state follows the pipeline's: it only changes once the
+         * pipeline has accepted the new state */
+        playbin.set_state(gst_state, q, [this, gst_state, state](bool succeeded) {
+            Q_Q(Engine);
+            pending_state_changes--;
+            if (!succeeded) {
+                MH_WARNING("Engine: could not change the state to %s",
+                           gst_element_state_get_name(gst_state));
+                return;
+            }
+
+            q->setState(state);
+            switch (state) {
+            case media::Engine::State::playing:
+                MH_INFO("Engine: playing uri: %s",
+                        qUtf8Printable(playbin.uri().toString()));
+                break;
+            case media::Engine::State::stopped:
+                q->setPlaybackStatus(media::Player::stopped);
+                break;
+            default:
+                break;
+            }
+        });
     }
 
     EnginePrivate(const core::ubuntu::media::Player::PlayerKey key,
             Engine *q)
-        : playbin(key),
+        : pool(PlaybinPool::instance()),
+          playbin(*pool->take(key)),
+          prerolled(false),
+          pending_state_changes(0),
+          metadata_dirty(false),
+          metadata_updates(0),
           q_ptr(q)
     {
+        metadata_timer.setSingleShot(true);
+        metadata_timer.setInterval(metadataUpdateInterval);
+        metadata_timer.callOnTimeout(q, [this]() { publish_metadata(); });
+
         QObject::connect(&playbin, &Playbin::errorOccurred,
                          q, [this](const Bus::Message::Detail::ErrorWarningInfo &ewi) {
             on_playbin_error(ewi);
@@ -252,10 +332,19 @@ public:
         });
 
         QObject::connect(&playbin, &Playbin::aboutToFinish,
-                         q, [this, q]() {
-            q->setState(Engine::State::ready);
+                         q, [q](bool nextUriQueued) {
+            // With gapless playback, we keep playing
+            if (!nextUriQueued)
+                q->setState(Engine::State::ready);
             Q_EMIT q->aboutToFinish();
         });
+        QObject::connect(&playbin, &Playbin::nextUriStarted,
+                         q, [this](const QUrl &uri) {
+            Q_Q(Engine);
+            // STREAM_START comes before the tags of the new track
+            reset_metadata(uri);
+            Q_EMIT q->nextResourceStarted(uri);
+        });
         QObject::connect(&playbin, &Playbin::seekedTo,
                          q, &Engine::seekedTo);
         QObject::connect(&playbin, &Playbin::bufferingChanged,
@@ -285,7 +374,24 @@ public:
         });
     }
 
-    gstreamer::Playbin playbin;
+    ~EnginePrivate()
+    {
+        pool->recycle(&playbin);
+    }
+
+    QSharedPointer<PlaybinPool> pool;
+    gstreamer::Playbin &playbin;
+    // Whether the playbin has reached the PAUSED state
+    bool prerolled;
+    // State changes requested to the playbin, whose outcome is not known yet
+    int pending_state_changes;
+    // Metadata of the current track, as collected from the tags
+    QUrl metadata_uri;
+    media::Track::MetaData metadata;
+    bool metadata_dirty;
+    // Number of times the metadata of the current track has been published
+    int metadata_updates;
+    QTimer metadata_timer;
     Engine *q_ptr;
 };
 
@@ -296,7 +402,7 @@ gstreamer::Engine::Engine(const core::ubuntu::media::Player::PlayerKey key)
 {
     Q_D(Engine);
 
-    setMetadataExtractor(QSharedPointer<gstreamer::MetaDataExtractor>::create());
+    setMetadataExtractor(gstreamer::MetaDataExtractor::instance());
 
     doSetAudioStreamRole(audioStreamRole());
     doSetLifetime(lifetime());
@@ -307,6 +413,17 @@ gstreamer::Engine::Engine(const core::ubuntu::media::Player::PlayerKey key)
         using ft = Playbin::MediaFileType;
         setIsVideoSource(fileType == ft::MEDIA_FILE_TYPE_VIDEO);
         setIsAudioSource(fileType == ft::MEDIA_FILE_TYPE_AUDIO);
+
+        /* Audio files can't be played backwards or in trick mode: if the
+         * current rate is not supported, fall back to the closest one */
+        Q_EMIT playbackRateRangeChanged();
+        const double rate = playbackRate();
+        if (fileType != ft::MEDIA_FILE_TYPE_NONE &&
+            (rate < minimumPlaybackRate() || rate > maximumPlaybackRate())) {
+            setPlaybackRate(rate < 0 ? 1.0 :
+                            qBound(minimumPlaybackRate(), rate,
+                                   maximumPlaybackRate()));
+        }
     });
 }
 
@@ -320,6 +437,7 @@ bool gstreamer::Engine::open_resource_for_uri(const QUrl &uri,
                                               bool do_pipeline_reset)
 {
     Q_D(Engine);
+    d->reset_metadata(uri);
     d->playbin.set_uri(uri, media::Player::HeadersType{}, do_pipeline_reset);
     return true;
 }
@@ -328,10 +446,17 @@ bool gstreamer::Engine::open_resource_for_uri(const QUrl &uri,
                                               const core::ubuntu::media::Player::HeadersType& headers)
 {
     Q_D(Engine);
+    d->reset_metadata(uri);
     d->playbin.set_uri(uri, headers);
     return true;
 }
 
+void gstreamer::Engine::set_next_resource_for_uri(const QUrl &uri)
+{
+    Q_D(Engine);
+    d->playbin.set_next_uri(uri);
+}
+
 void gstreamer::Engine::create_video_sink(uint32_t texture_id)
 {
     Q_D(Engine);
@@ -341,56 +466,37 @@ void gstreamer::Engine::create_video_sink(uint32_t texture_id)
 bool gstreamer::Engine::play()
 {
     Q_D(Engine);
-    const auto result = d->playbin.set_state(GST_STATE_PLAYING);
-
-    if (result)
-    {
-        setState(media::Engine::State::playing);
-        MH_INFO("Engine: playing uri: %s", qUtf8Printable(d->playbin.uri().toString()));
-    }
-
-    return result;
+    d->change_state(GST_STATE_PLAYING, media::Engine::State::playing);
+    return true;
 }
 
 bool gstreamer::Engine::stop()
 {
     Q_D(Engine);
     // No need to wait, and we can immediately return.
-    if (state() == media::Engine::State::stopped)
+    if (state() == media::Engine::State::stopped &&
+        d->pending_state_changes == 0)
     {
         MH_DEBUG("Current player state is already stopped - no need to change state to stopped");
         return true;
     }
 
-    const auto result = d->playbin.set_state(GST_STATE_NULL);
-    if (result)
-    {
-        setState(media::Engine::State::stopped);
-        MH_TRACE("");
-        setPlaybackStatus(media::Player::stopped);
-    }
-
-    return result;
+    d->change_state(GST_STATE_NULL, media::Engine::State::stopped);
+    return true;
 }
 
 bool gstreamer::Engine::pause()
 {
     Q_D(Engine);
-    const auto result = d->playbin.set_state(GST_STATE_PAUSED);
-
-    if (result)
-    {
-        setState(media::Engine::State::paused);
-        MH_TRACE("");
-    }
-
-    return result;
+    d->change_state(GST_STATE_PAUSED, media::Engine::State::paused);
+    return true;
 }
 
-bool gstreamer::Engine::seek_to(const std::chrono::microseconds& ts)
+bool gstreamer::Engine::seek_to(const std::chrono::microseconds& ts,
+                                media::Player::SeekMode mode)
 {
     Q_D(Engine);
-    return d->playbin.seek(ts);
+    return d->playbin.seek(ts, mode);
 }
 
 uint64_t gstreamer::Engine::position() const
@@ -405,6 +511,18 @@ uint64_t gstreamer::Engine::duration() const
     return d->playbin.duration();
 }
 
+double gstreamer::Engine::minimumPlaybackRate() const
+{
+    Q_D(const Engine);
+    return d->playbin.minimum_playback_rate();
+}
+
+double gstreamer::Engine::maximumPlaybackRate() const
+{
+    Q_D(const Engine);
+    return d->playbin.maximum_playback_rate();
+}
+
 void gstreamer::Engine::reset()
 {
     Q_D(Engine);
@@ -428,3 +546,9 @@ void gstreamer::Engine::doSetVolume(double volume)
     Q_D(Engine);
     d->playbin.set_volume(volume);
 }
+
+bool gstreamer::Engine::doSetPlaybackRate(double rate)
+{
+    Q_D(Engine);
+    return d->playbin.set_playback_rate(rate);
+}
@@ -38,23 +38,29 @@ public:
 
     bool open_resource_for_uri(const QUrl &uri, bool do_pipeline_reset);
     bool open_resource_for_uri(const QUrl &uri, const core::ubuntu::media::Player::HeadersType& headers);
+    void set_next_resource_for_uri(const QUrl &uri) override;
     void create_video_sink(uint32_t texture_id);
 
     // use_main_thread will set the pipeline's new state in the main thread context
     bool play();
     bool stop();
     bool pause();
-    bool seek_to(const std::chrono::microseconds& ts);
+    bool seek_to(const std::chrono::microseconds& ts,
+                 core::ubuntu::media::Player::SeekMode mode) override;
 
     uint64_t position() const;
     uint64_t duration() const;
 
+    double minimumPlaybackRate() const override;
+    double maximumPlaybackRate() const override;
+
     void reset();
 
 protected:
     void doSetAudioStreamRole(core::ubuntu::media::Player::AudioStreamRole role) override;
     void doSetLifetime(core::ubuntu::media::Player::Lifetime lifetime) override;
     void doSetVolume(double volume) override;
+    bool doSetPlaybackRate(double rate) override;
 
 private:
     Q_DECLARE_PRIVATE(Engine)
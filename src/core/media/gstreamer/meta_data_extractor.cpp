@@ -0,0 +1,373 @@
+/*
+ * Copyright © 2013 Canonical Ltd.
+ * Copyright © 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authored by: Thomas Voß <thomas.voss@canonical.com>
+ */
+
+#include "meta_data_extractor.h"
+
+#include "pipeline_worker.h"
+
+#include "core/media/logging.h"
+#include "core/media/metadata_store.h"
+
+#include <QObject>
+#include <QQueue>
+#include <QThread>
+#include <QTimer>
+#include <QVector>
+#include <QWeakPointer>
+
+
+namespace gstreamer
+{
+
+/* Sources which never preroll (stalled network streams, live sources) would
+ * otherwise keep a pipeline of the shared pool busy forever */
+static const int EXTRACTION_TIMEOUT_MS = 5000;
+
+class ExtractorPipeline
+{
+public:
+    typedef std::function<void(ExtractorPipeline *)> DoneCallback;
+
+    struct Result
+    {
+        QUrl uri;
+        MetaDataExtractor::Callback callback;
+        QVariantMap metadata;
+        bool succeeded;
+    };
+
+    /* `onDone` is invoked when the extraction is complete; `onIdle` when the
+     * pipeline is available again after takeResult() */
+    ExtractorPipeline(const QSharedPointer<PipelineWorker> &worker,
+                      const DoneCallback &onDone,
+                      const DoneCallback &onIdle);
+    ~ExtractorPipeline();
+
+    bool isBusy() const { return m_state != Idle; }
+
+    void start(const QUrl &uri, const MetaDataExtractor::Callback &cb);
+    /* Returns the request that has just been completed, along with the
+     * collected metadata, and starts resetting the pipeline */
+    Result takeResult();
+
+private:
+    enum State {
+        Idle,
+        Extracting,
+        Resetting,
+    };
+
+    static void on_new_pad(GstElement*, GstPad* pad, GstElement* fakesink);
+
+    void on_new_message(const Bus::Message &msg);
+    void on_start_failed();
+    void on_timeout();
+
+    QSharedPointer<PipelineWorker> m_worker;
+    GstElement *m_pipe;
+    GstElement *m_decoder;
+    Bus m_bus;
+    DoneCallback m_onDone;
+    DoneCallback m_onIdle;
+    // Guards the callbacks from the worker threads
+    QObject m_context;
+    QTimer m_timeout;
+    State m_state;
+    bool m_failed;
+    QUrl m_uri;
+    MetaDataExtractor::Callback m_callback;
+    QVariantMap m_metadata;
+};
+
+class MetaDataExtractorPrivate
+{
+public:
+    struct Request
+    {
+        QUrl uri;
+        MetaDataExtractor::Callback callback;
+    };
+
+    MetaDataExtractorPrivate(int max_pipelines);
+    ~MetaDataExtractorPrivate();
+
+    ExtractorPipeline *idle_pipeline();
+    void on_pipeline_done(ExtractorPipeline *pipeline);
+    void dispatch();
+
+    int m_maxPipelines;
+    QSharedPointer<core::ubuntu::media::MetaDataStore> m_store;
+    QSharedPointer<PipelineWorker> m_worker;
+    QVector<ExtractorPipeline*> m_pipelines;
+    QQueue<Request> m_queue;
+};
+
+} // namespace
+
+using namespace gstreamer;
+
+ExtractorPipeline::ExtractorPipeline(const QSharedPointer<PipelineWorker> &worker,
+                                     const DoneCallback &onDone,
+                                     const DoneCallback &onIdle):
+    m_worker(worker),
+    m_pipe(gst_pipeline_new("meta_data_extractor_pipeline")),
+    m_decoder(gst_element_factory_make ("uridecodebin", NULL)),
+    m_bus(gst_element_get_bus(m_pipe)),
+    m_onDone(onDone),
+    m_onIdle(onIdle),
+    m_state(Idle),
+    m_failed(false)
+{
+    gst_bin_add(GST_BIN(m_pipe), m_decoder);
+
+    auto sink = gst_element_factory_make ("fakesink", NULL);
+    gst_bin_add (GST_BIN (m_pipe), sink);
+
+    g_signal_connect (m_decoder, "pad-added", G_CALLBACK (on_new_pad), sink);
+
+    m_timeout.setSingleShot(true);
+    m_timeout.setInterval(EXTRACTION_TIMEOUT_MS);
+    m_timeout.callOnTimeout(&m_context, [this]() { on_timeout(); });
+
+    m_bus.onNewMessage([this](const Bus::Message &msg) {
+        on_new_message(msg);
+    }, GstMessageType(GST_MESSAGE_TAG | GST_MESSAGE_ASYNC_DONE |
+                      GST_MESSAGE_ERROR));
+}
+
+ExtractorPipeline::~ExtractorPipeline()
+{
+    // The worker holds its own reference until the teardown is complete
+    m_worker->set_state(m_pipe, GST_STATE_NULL);
+    gst_object_unref(m_pipe);
+}
+
+void ExtractorPipeline::on_new_pad(GstElement*, GstPad* pad, GstElement* fakesink)
+{
+    GstPad *sinkpad;
+
+    sinkpad = gst_element_get_static_pad (fakesink, "sink");
+
+    if (!gst_pad_is_linked (sinkpad)) {
+        if (gst_pad_link (pad, sinkpad) != GST_PAD_LINK_OK)
+            g_error ("Failed to link pads!");
+    }
+
+    gst_object_unref (sinkpad);
+}
+
+void ExtractorPipeline::start(const QUrl &uri,
+                              const MetaDataExtractor::Callback &cb)
+{
+    m_state = Extracting;
+    m_failed = false;
+    m_uri = uri;
+    m_callback = cb;
+    m_metadata.clear();
+    m_timeout.start();
+
+    GstElement *pipe = m_pipe;
+    GstElement *decoder = m_decoder;
+    const QByteArray encodedUri = uri.toEncoded();
+    auto ok = QSharedPointer<bool>::create(true);
+    m_worker->run(m_pipe, [pipe, decoder, encodedUri, ok]() {
+        g_object_set(decoder, "uri", encodedUri.constData(), NULL);
+        if (gst_element_set_state(pipe, GST_STATE_PAUSED) ==
+            GST_STATE_CHANGE_FAILURE) {
+            gst_element_set_state(pipe, GST_STATE_NULL);
+            *ok = false;
+        }
+    }, &m_context, [this, ok]() {
+        if (!*ok) on_start_failed();
+    });
+}
+
+void ExtractorPipeline::on_start_failed()
+{
+    if (m_state != Extracting) return;
+
+    MH_WARNING("Failed to start metadata extraction for %s",
+               qUtf8Printable(m_uri.toString()));
+    m_failed = true;
+    m_onDone(this);
+}
+
+void ExtractorPipeline::on_timeout()
+{
+    if (m_state != Extracting) return;
+
+    MH_WARNING("Metadata extraction for %s timed out",
+               qUtf8Printable(m_uri.toString()));
+    // The tags collected so far are reported, but not stored
+    m_failed = true;
+    m_onDone(this);
+}
+
+ExtractorPipeline::Result ExtractorPipeline::takeResult()
+{
+    m_timeout.stop();
+    // Going to NULL also flushes any pending message from the bus
+    m_state = Resetting;
+    m_worker->run(m_pipe, [pipe = m_pipe]() {
+        gst_element_set_state(pipe, GST_STATE_NULL);
+    }, &m_context, [this]() {
+        m_state = Idle;
+        m_onIdle(this);
+    });
+
+    Result result;
+    std::swap(result.uri, m_uri);
+    std::swap(result.callback, m_callback);
+    result.metadata.swap(m_metadata);
+    result.succeeded = !m_failed;
+    return result;
+}
+
+void ExtractorPipeline::on_new_message(const Bus::Message &msg)
+{
+    if (m_state != Extracting) return;
+
+    switch (msg.type)
+    {
+    case GST_MESSAGE_TAG:
+        MetaDataExtractor::on_tag_available(msg.detail().tag, &m_metadata);
+        break;
+    case GST_MESSAGE_ASYNC_DONE:
+        m_onDone(this);
+        break;
+    case GST_MESSAGE_ERROR:
+        MH_WARNING("Failed to extract metadata for %s: %s",
+                   qUtf8Printable(m_uri.toString()),
+                   msg.detail().error_warning_info.error->message);
+        m_failed = true;
+        m_onDone(this);
+        break;
+    default:
+        break;
+    }
+}
+
+MetaDataExtractorPrivate::MetaDataExtractorPrivate(int max_pipelines):
+    m_maxPipelines(max_pipelines),
+    m_store(core::ubuntu::media::MetaDataStore::instance()),
+    m_worker(PipelineWorker::instance())
+{
+    if (m_maxPipelines <= 0) {
+        m_maxPipelines =
+            qEnvironmentVariableIsSet("MEDIA_HUB_METADATA_EXTRACTORS") ?
+            qEnvironmentVariableIntValue("MEDIA_HUB_METADATA_EXTRACTORS") :
+            QThread::idealThreadCount();
+    }
+    m_maxPipelines = qMax(m_maxPipelines, 1);
+}
+
+MetaDataExtractorPrivate::~MetaDataExtractorPrivate()
+{
+    qDeleteAll(m_pipelines);
+}
+
+ExtractorPipeline *MetaDataExtractorPrivate::idle_pipeline()
+{
+    for (ExtractorPipeline *pipeline: m_pipelines) {
+        if (!pipeline->isBusy()) return pipeline;
+    }
+
+    // Pipelines are created lazily, only when needed
+    if (m_pipelines.count() < m_maxPipelines) {
+        auto pipeline = new ExtractorPipeline(m_worker,
+                                              [this](ExtractorPipeline *p) {
+            on_pipeline_done(p);
+        }, [this](ExtractorPipeline *) {
+            dispatch();
+        });
+        m_pipelines.append(pipeline);
+        return pipeline;
+    }
+
+    return nullptr;
+}
+
+void MetaDataExtractorPrivate::on_pipeline_done(ExtractorPipeline *pipeline)
+{
+    const ExtractorPipeline::Result result = pipeline->takeResult();
+    if (result.succeeded) {
+        m_store->store(result.uri, result.metadata);
+    }
+
+    // Start the next request before invoking the callback, which might
+    // queue more requests; this pipeline is not available until reset
+    dispatch();
+
+    if (result.callback) result.callback(result.metadata);
+}
+
+void MetaDataExtractorPrivate::dispatch()
+{
+    while (!m_queue.isEmpty()) {
+        ExtractorPipeline *pipeline = idle_pipeline();
+        if (!pipeline) break;
+
+        const Request request = m_queue.dequeue();
+        pipeline->start(request.uri, request.callback);
+    }
+}
+
+MetaDataExtractor::MetaDataExtractor(int max_pipelines):
+    d_ptr(new MetaDataExtractorPrivate(max_pipelines))
+{
+}
+
+MetaDataExtractor::~MetaDataExtractor() = default;
+
+QSharedPointer<MetaDataExtractor> MetaDataExtractor::instance()
+{
+    static QWeakPointer<MetaDataExtractor> weakRef;
+
+    QSharedPointer<MetaDataExtractor> extractor = weakRef.toStrongRef();
+    if (!extractor) {
+        extractor = QSharedPointer<MetaDataExtractor>::create();
+        weakRef = extractor;
+    }
+    return extractor;
+}
+
+int MetaDataExtractor::max_pipelines() const
+{
+    Q_D(const MetaDataExtractor);
+    return d->m_maxPipelines;
+}
+
+void MetaDataExtractor::meta_data_for_track_with_uri(const QUrl &uri,
+                                                     const Callback &cb)
+{
+    Q_D(MetaDataExtractor);
+
+    if (!gst_uri_is_valid(qUtf8Printable(uri.toString())))
+        throw std::runtime_error("Invalid uri");
+
+    // Files we have already seen need no decoding at all
+    QVariantMap metadata;
+    if (d->m_store->lookup(uri, &metadata)) {
+        if (cb) cb(metadata);
+        return;
+    }
+
+    d->m_queue.enqueue({ uri, cb });
+    d->dispatch();
+}
@@ -26,12 +26,16 @@
 
 #include "core/media/logging.h"
 
+#include <QScopedPointer>
+#include <QSharedPointer>
+
 #include <gst/gst.h>
 
 #include <exception>
 
 namespace gstreamer
 {
+class MetaDataExtractorPrivate;
 class MetaDataExtractor : public core::ubuntu::media::Engine::MetaDataExtractor
 {
 public:
@@ -60,9 +64,12 @@ public:
         return lut;
     }
 
+    /* Merges the tags into `md`, which can be either a QVariantMap or a
+     * Track::MetaData */
+    template <class Map>
     static void on_tag_available(
             const gstreamer::Bus::Message::Detail::Tag& tag,
-            QVariantMap *md)
+            Map *md)
     {
         namespace media = core::ubuntu::media;
 
@@ -74,7 +81,7 @@ public:
         {
             (void) list;
 
-            auto md = static_cast<QVariantMap*>(user_data);
+            auto md = static_cast<Map*>(user_data);
             QVariant v;
 
             switch (gst_tag_get_type(tag))
@@ -160,108 +167,27 @@ public:
         md);
     }
 
-    MetaDataExtractor()
-        : pipe(gst_pipeline_new("meta_data_extractor_pipeline")),
-          decoder(gst_element_factory_make ("uridecodebin", NULL)),
-          bus(gst_element_get_bus(pipe)),
-          m_newMessageSubscriptionId(-1)
-    {
-        gst_bin_add(GST_BIN(pipe), decoder);
-
-        auto sink = gst_element_factory_make ("fakesink", NULL);
-        gst_bin_add (GST_BIN (pipe), sink);
-
-        g_signal_connect (decoder, "pad-added", G_CALLBACK (on_new_pad), sink);
-    }
-
-    ~MetaDataExtractor()
-    {
-        if (m_newMessageSubscriptionId >= 0) {
-            bus.unsubscribeFromNewMessage(m_newMessageSubscriptionId);
-        }
-        set_state_and_wait(GST_STATE_NULL);
-        gst_object_unref(pipe);
-    }
-
-    bool set_state_and_wait(GstState new_state)
-    {
-        static const std::chrono::nanoseconds state_change_timeout
-        {
-            // We choose a quite high value here as tests are run under valgrind
-            // and gstreamer pipeline setup/state changes take longer in that scenario.
-            // The value does not negatively impact runtime performance.
-            std::chrono::milliseconds{5000}
-        };
-
-        auto ret = gst_element_set_state(pipe, new_state);
+    /* Extraction happens in a pool of at most `max_pipelines` decoding
+     * pipelines, so that several URIs can be processed concurrently; requests
+     * exceeding the pool capacity are queued. If `max_pipelines` is 0, the
+     * value of the MEDIA_HUB_METADATA_EXTRACTORS environment variable is
+     * used, defaulting to the number of CPU cores.
+     * Results for local files are kept in the persistent MetaDataStore, and
+     * are returned without decoding as long as the file is unchanged. */
+    MetaDataExtractor(int max_pipelines = 0);
+    ~MetaDataExtractor();
 
-        bool result = false; GstState current, pending;
-        switch(ret)
-        {
-            case GST_STATE_CHANGE_FAILURE:
-                result = false; break;
-            case GST_STATE_CHANGE_NO_PREROLL:
-            case GST_STATE_CHANGE_SUCCESS:
-                result = true; break;
-            case GST_STATE_CHANGE_ASYNC:
-                result = GST_STATE_CHANGE_SUCCESS == gst_element_get_state(
-                    pipe,
-                    &current,
-                    &pending,
-                    state_change_timeout.count());
-                break;
-        }
+    // Returns an instance shared by all the players
+    static QSharedPointer<MetaDataExtractor> instance();
 
-        return result;
-    }
+    int max_pipelines() const;
 
     void meta_data_for_track_with_uri(const QUrl &uri,
-                                      const Callback &cb)
-    {
-        if (!gst_uri_is_valid(qUtf8Printable(uri.toString())))
-            throw std::runtime_error("Invalid uri");
-
-        m_metadata.clear();
-        auto messageHandler = [this, cb](
-            const gstreamer::Bus::Message& msg)
-        {
-            if (msg.type == GST_MESSAGE_TAG)
-            {
-                MetaDataExtractor::on_tag_available(msg.detail.tag, &m_metadata);
-            } else if (msg.type == GST_MESSAGE_ASYNC_DONE)
-            {
-                set_state_and_wait(GST_STATE_NULL);
-                bus.unsubscribeFromNewMessage(m_newMessageSubscriptionId);
-                m_newMessageSubscriptionId = -1;
-                cb(m_metadata);
-            }
-        };
-        m_newMessageSubscriptionId = bus.onNewMessage(messageHandler);
-
-        g_object_set(decoder, "uri", qUtf8Printable(uri.toString()), NULL);
-        gst_element_set_state(pipe, GST_STATE_PAUSED);
-    }
+                                      const Callback &cb) override;
 
 private:
-    static void on_new_pad(GstElement*, GstPad* pad, GstElement* fakesink)
-    {
-        GstPad *sinkpad;
-
-        sinkpad = gst_element_get_static_pad (fakesink, "sink");
-
-        if (!gst_pad_is_linked (sinkpad)) {
-            if (gst_pad_link (pad, sinkpad) != GST_PAD_LINK_OK)
-                g_error ("Failed to link pads!");
-        }
-
-        gst_object_unref (sinkpad);
-    }
-
-    GstElement* pipe;
-    GstElement* decoder;
-    Bus bus;
-    QVariantMap m_metadata;
-    int m_newMessageSubscriptionId;
+    Q_DECLARE_PRIVATE(MetaDataExtractor)
+    QScopedPointer<MetaDataExtractorPrivate> d_ptr;
 };
 }
 
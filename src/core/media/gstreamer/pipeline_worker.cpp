@@ -0,0 +1,203 @@
+/*
+ * Copyright © 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "pipeline_worker.h"
+
+#include "core/media/logging.h"
+
+#include <QCoreApplication>
+#include <QHash>
+#include <QMetaObject>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QPointer>
+#include <QQueue>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QWaitCondition>
+#include <QWeakPointer>
+
+namespace gstreamer
+{
+
+class PipelineWorkerPrivate
+{
+public:
+    struct Task
+    {
+        PipelineWorker::Job job;
+        QPointer<QObject> context;
+        PipelineWorker::Job done;
+    };
+
+    PipelineWorkerPrivate(int threads);
+
+    // Runs the jobs queued for `pipeline` until there are none left
+    void run_queue(GstElement *pipeline);
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_queueDone;
+    /* A pipeline has an entry here as long as it has jobs queued or
+     * running; the running job is the head of the queue */
+    QHash<GstElement*, QQueue<Task>> m_queues;
+    QThreadPool m_threadPool;
+};
+
+} // namespace
+
+using namespace gstreamer;
+
+namespace {
+
+class QueueRunner: public QRunnable
+{
+public:
+    QueueRunner(PipelineWorkerPrivate *worker, GstElement *pipeline):
+        m_worker(worker), m_pipeline(pipeline)
+    {
+    }
+
+    void run() override { m_worker->run_queue(m_pipeline); }
+
+private:
+    PipelineWorkerPrivate *m_worker;
+    GstElement *m_pipeline;
+};
+
+} // namespace
+
+PipelineWorkerPrivate::PipelineWorkerPrivate(int threads)
+{
+    if (threads <= 0) {
+        threads =
+            qEnvironmentVariableIsSet("MEDIA_HUB_PIPELINE_WORKERS") ?
+            qEnvironmentVariableIntValue("MEDIA_HUB_PIPELINE_WORKERS") : 2;
+    }
+    m_threadPool.setMaxThreadCount(qMax(threads, 1));
+}
+
+void PipelineWorkerPrivate::run_queue(GstElement *pipeline)
+{
+    QMutexLocker locker(&m_mutex);
+    while (true) {
+        QQueue<Task> &queue = m_queues[pipeline];
+        const Task task = queue.head();
+        locker.unlock();
+
+        task.job();
+        if (task.done && QCoreApplication::instance()) {
+            const QPointer<QObject> context = task.context;
+            const PipelineWorker::Job done = task.done;
+            QMetaObject::invokeMethod(QCoreApplication::instance(),
+                                      [context, done]() {
+                if (context) done();
+            }, Qt::QueuedConnection);
+        }
+        // The last reference might go away here, and that's fine
+        gst_object_unref(pipeline);
+
+        locker.relock();
+        QQueue<Task> &current = m_queues[pipeline];
+        current.dequeue();
+        if (current.isEmpty()) {
+            m_queues.remove(pipeline);
+            m_queueDone.wakeAll();
+            return;
+        }
+    }
+}
+
+PipelineWorker::PipelineWorker(int threads):
+    d_ptr(new PipelineWorkerPrivate(threads))
+{
+}
+
+PipelineWorker::~PipelineWorker()
+{
+    Q_D(PipelineWorker);
+    d->m_threadPool.waitForDone();
+}
+
+QSharedPointer<PipelineWorker> PipelineWorker::instance()
+{
+    static QWeakPointer<PipelineWorker> weakRef;
+
+    QSharedPointer<PipelineWorker> worker = weakRef.toStrongRef();
+    if (!worker) {
+        worker = QSharedPointer<PipelineWorker>::create();
+        weakRef = worker;
+    }
+    return worker;
+}
+
+int PipelineWorker::max_threads() const
+{
+    Q_D(const PipelineWorker);
+    return d->m_threadPool.maxThreadCount();
+}
+
+void PipelineWorker::run(GstElement *pipeline, const Job &job,
+                         QObject *context, const Job &done)
+{
+    Q_D(PipelineWorker);
+
+    // Released once the job has run
+    gst_object_ref(pipeline);
+
+    bool start;
+    {
+        QMutexLocker locker(&d->m_mutex);
+        QQueue<PipelineWorkerPrivate::Task> &queue = d->m_queues[pipeline];
+        // Otherwise, the runner already working on this queue will get to it
+        start = queue.isEmpty();
+        queue.enqueue({ job, context, done });
+    }
+
+    if (start) {
+        d->m_threadPool.start(new QueueRunner(d, pipeline));
+    }
+}
+
+void PipelineWorker::set_state(GstElement *pipeline, GstState state,
+                               QObject *context, const StateChangeDone &done)
+{
+    auto ok = QSharedPointer<bool>::create(true);
+    run(pipeline, [pipeline, state, ok]() {
+        if (gst_element_set_state(pipeline, state) == GST_STATE_CHANGE_FAILURE) {
+            MH_WARNING("Failed to set %s to state %s",
+                       GST_ELEMENT_NAME(pipeline),
+                       gst_element_state_get_name(state));
+            *ok = false;
+        }
+    }, context, done ? Job([done, ok]() { done(*ok); }) : Job());
+}
+
+int PipelineWorker::pending(GstElement *pipeline) const
+{
+    Q_D(const PipelineWorker);
+    QMutexLocker locker(&d->m_mutex);
+    return d->m_queues.value(pipeline).count();
+}
+
+void PipelineWorker::wait(GstElement *pipeline)
+{
+    Q_D(PipelineWorker);
+    QMutexLocker locker(&d->m_mutex);
+    while (d->m_queues.contains(pipeline)) {
+        d->m_queueDone.wait(&d->m_mutex);
+    }
+}
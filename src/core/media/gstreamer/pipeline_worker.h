@@ -0,0 +1,85 @@
+/*
+ * Copyright © 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef GSTREAMER_PIPELINE_WORKER_H_
+#define GSTREAMER_PIPELINE_WORKER_H_
+
+#include <gst/gst.h>
+
+#include <QScopedPointer>
+#include <QSharedPointer>
+
+#include <functional>
+
+class QObject;
+
+namespace gstreamer
+{
+
+/*
+ * Runs the blocking operations on GStreamer pipelines (mostly state
+ * changes) on a small pool of worker threads, so that a slow pipeline does
+ * not stall the main loop, and with it every other session.
+ *
+ * Jobs queued for the same pipeline are executed one at a time, in the order
+ * they were queued; jobs for different pipelines run in parallel. The
+ * pipeline is kept alive until its jobs have completed. The number of
+ * threads can be set with the MEDIA_HUB_PIPELINE_WORKERS environment
+ * variable.
+ */
+class PipelineWorkerPrivate;
+class PipelineWorker
+{
+public:
+    typedef std::function<void()> Job;
+    typedef std::function<void(bool succeeded)> StateChangeDone;
+
+    /* If `threads` is not positive, the value of the
+     * MEDIA_HUB_PIPELINE_WORKERS environment variable is used, defaulting
+     * to 2. */
+    PipelineWorker(int threads = -1);
+    ~PipelineWorker();
+
+    // Returns an instance shared by all the pipelines
+    static QSharedPointer<PipelineWorker> instance();
+
+    int max_threads() const;
+
+    /* Queues `job` for `pipeline`. Once it has run, `done` is invoked in the
+     * main thread, unless `context` has been destroyed meanwhile. */
+    void run(GstElement *pipeline, const Job &job,
+             QObject *context = nullptr, const Job &done = Job());
+
+    /* Queues a state change, logging a warning if it fails. Its outcome is
+     * then passed to `done`, as for run(). */
+    void set_state(GstElement *pipeline, GstState state,
+                   QObject *context = nullptr,
+                   const StateChangeDone &done = StateChangeDone());
+
+    // Number of jobs queued or running for `pipeline`
+    int pending(GstElement *pipeline) const;
+    // Blocks until all the jobs queued for `pipeline` have completed
+    void wait(GstElement *pipeline);
+
+private:
+    Q_DECLARE_PRIVATE(PipelineWorker)
+    QScopedPointer<PipelineWorkerPrivate> d_ptr;
+};
+
+}
+
+#endif // GSTREAMER_PIPELINE_WORKER_H_
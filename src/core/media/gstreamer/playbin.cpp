@@ -19,6 +19,7 @@
 
 #include <core/media/gstreamer/playbin.h>
 #include <core/media/gstreamer/engine.h>
+#include <core/media/gstreamer/pipeline_worker.h>
 #include <core/media/logging.h>
 #include <core/media/video/socket_types.h>
 
@@ -27,10 +28,9 @@
 #include <hybris/media/surface_texture_client_hybris.h>
 #include <hybris/media/media_codec_layer.h>
 
+#include "core/media/content_type_cache.h"
 #include "core/media/util/uri_check.h"
 
-#include <QMimeDatabase>
-#include <QMimeType>
 #include <QSize>
 
 #include <sys/socket.h>
@@ -47,6 +47,16 @@ static const char *MIR_SINK = "mirsink";
 namespace media = core::ubuntu::media;
 namespace video = core::ubuntu::media::video;
 
+/* Reading the sink's stats allocates a GstStructure: the drop count is only
+ * refreshed every this many frames */
+static const uint32_t DROP_STATS_INTERVAL = 30;
+// Longest time a seek can take before the next requests go through
+static const int SEEK_TIMEOUT_MS = 5000;
+
+constexpr double gstreamer::Playbin::min_audible_rate;
+constexpr double gstreamer::Playbin::max_audible_rate;
+constexpr double gstreamer::Playbin::max_trick_mode_rate;
+
 void gstreamer::Playbin::setup_video_sink_for_buffer_streaming()
 {
     IGBPWrapperHybris igbp;
@@ -54,6 +64,7 @@ void gstreamer::Playbin::setup_video_sink_for_buffer_streaming()
     GstContext *context;
     GstStructure *structure;
 
+    buffer_streaming_enabled = true;
     switch (backend) {
     case core::ubuntu::media::AVBackend::Backend::hybris:
         // Get the service-side BufferQueue (IGraphicBufferProducer) and
@@ -108,7 +119,22 @@ const std::string& gstreamer::Playbin::pipeline_name()
 void gstreamer::Playbin::about_to_finish(GstElement*, gpointer user_data)
 {
     auto thiz = static_cast<Playbin*>(user_data);
-    Q_EMIT thiz->aboutToFinish();
+
+    /* This is invoked from a streaming thread, and it's the only point where
+     * the URI can be changed without interrupting the playback */
+    bool queued = false;
+    {
+        std::lock_guard<std::mutex> lock(thiz->next_uri_guard);
+        if (!thiz->next_uri.isEmpty()) {
+            const QByteArray uri = thiz->next_uri.toEncoded();
+            MH_INFO("Queuing next uri: %s", uri.constData());
+            g_object_set(thiz->pipeline, "uri", uri.constData(), NULL);
+            thiz->queued_uri = thiz->next_uri;
+            queued = true;
+        }
+    }
+
+    Q_EMIT thiz->aboutToFinish(queued);
 }
 
 void gstreamer::Playbin::source_setup(GstElement*,
@@ -148,15 +174,42 @@ gstreamer::Playbin::Playbin(const core::ubuntu::media::Player::PlayerKey key_in)
       video_stream_id(-1),
       current_new_state(GST_STATE_NULL),
       key(key_in),
-      backend(core::ubuntu::media::AVBackend::get_backend_type()),
-      sock_consumer(-1)
+      backend(core::ubuntu::media::AVBackend::capabilities().backend),
+      content_type_cache(media::ContentTypeCache::instance()),
+      worker(PipelineWorker::instance()),
+      sock_consumer(-1),
+      buffer_streaming_enabled(false),
+      frame_sequence(0),
+      dropped_frames(0),
+      has_pitch_correction(false),
+      rate(1.0),
+      rate_seek_pending(false),
+      has_pending_seek(false),
+      pending_seek_position(0),
+      pending_seek_flags(GST_SEEK_FLAG_NONE),
+      coalesced_seeks(0),
+      last_seek(0),
+      user_seek(0),
+      user_seek_sent(false)
 {
     if (!pipeline)
         throw std::runtime_error("Could not create pipeline for playbin.");
 
+    seek_watchdog.setSingleShot(true);
+    seek_watchdog.setInterval(SEEK_TIMEOUT_MS);
+    seek_watchdog.callOnTimeout(this, [this]() {
+        MH_WARNING("Seek not settled after %d ms", SEEK_TIMEOUT_MS);
+        finish_seek();
+    });
+
     bus.onNewMessage([this](const Bus::Message &msg) {
         on_new_message(msg);
-    });
+    }, GstMessageType(GST_MESSAGE_ERROR | GST_MESSAGE_WARNING |
+                      GST_MESSAGE_INFO | GST_MESSAGE_STATE_CHANGED |
+                      GST_MESSAGE_APPLICATION | GST_MESSAGE_ELEMENT |
+                      GST_MESSAGE_TAG | GST_MESSAGE_ASYNC_DONE |
+                      GST_MESSAGE_STREAM_START | GST_MESSAGE_EOS |
+                      GST_MESSAGE_BUFFERING));
 
     // Add audio and/or video sink elements depending on environment variables
     // being set or not set
@@ -214,8 +267,11 @@ gstreamer::Playbin::~Playbin()
     g_signal_handler_disconnect(pipeline, m_audioChangedHandlerId);
     g_signal_handler_disconnect(pipeline, m_videoChangedHandlerId);
 
-    if (pipeline)
+    if (pipeline) {
+        // The worker holds its own reference until the teardown is complete
+        worker->set_state(pipeline, GST_STATE_NULL);
         gst_object_unref(pipeline);
+    }
 
     if (sock_consumer != -1) {
         close(sock_consumer);
@@ -243,20 +299,17 @@ void gstreamer::Playbin::reset()
 void gstreamer::Playbin::reset_pipeline()
 {
     MH_TRACE("");
-    const auto ret = gst_element_set_state(pipeline, GST_STATE_NULL);
-    switch (ret)
+    // Tearing down the sinks can take a while
+    worker->set_state(pipeline, GST_STATE_NULL);
+    setMediaFileType(MEDIA_FILE_TYPE_NONE);
     {
-    case GST_STATE_CHANGE_FAILURE:
-        MH_WARNING("Failed to reset the pipeline state. Client reconnect may not function properly.");
-        break;
-    case GST_STATE_CHANGE_NO_PREROLL:
-    case GST_STATE_CHANGE_SUCCESS:
-    case GST_STATE_CHANGE_ASYNC:
-        break;
-    default:
-        MH_WARNING("Failed to reset the pipeline state. Client reconnect may not function properly.");
+        std::lock_guard<std::mutex> lock(next_uri_guard);
+        queued_uri.clear();
     }
-    setMediaFileType(MEDIA_FILE_TYPE_NONE);
+    current_uri.clear();
+    clear_seek_state();
+    frame_sequence = 0;
+    dropped_frames = 0;
     is_missing_audio_codec = false;
     is_missing_video_codec = false;
     audio_stream_id = -1;
@@ -267,6 +320,51 @@ void gstreamer::Playbin::reset_pipeline()
     }
 }
 
+void gstreamer::Playbin::warm_up()
+{
+    GstElement *p = pipeline;
+    worker->run(pipeline, [p]() {
+        if (gst_element_set_state(p, GST_STATE_READY) ==
+            GST_STATE_CHANGE_FAILURE) {
+            MH_WARNING("Could not bring the playbin to READY state");
+            return;
+        }
+
+        // Whoever takes this playbin is not interested in these state changes
+        GstBus *gst_bus = gst_element_get_bus(p);
+        gst_bus_set_flushing(gst_bus, TRUE);
+        gst_bus_set_flushing(gst_bus, FALSE);
+        gst_object_unref(gst_bus);
+    });
+}
+
+bool gstreamer::Playbin::reset_for_reuse()
+{
+    // The video sink context can't be unset, so it's safer to start afresh
+    if (buffer_streaming_enabled)
+        return false;
+
+    player_lifetime = media::Player::Lifetime::normal;
+    reset_pipeline();
+    set_next_uri(QUrl());
+    request_headers.clear();
+    clear_seek_state();
+    previous_position = 0;
+    set_volume(1.0);
+    rate = 1.0;
+    rate_seek_pending = false;
+    g_object_set(pipeline, "mute", FALSE, NULL);
+    key = media::Player::invalidKey;
+
+    warm_up();
+    return true;
+}
+
+void gstreamer::Playbin::set_key(media::Player::PlayerKey key_in)
+{
+    key = key_in;
+}
+
 void gstreamer::Playbin::process_missing_plugin_message(GstMessage *message)
 {
     gchar *desc = gst_missing_plugin_message_get_description(message);
@@ -341,12 +439,27 @@ void gstreamer::Playbin::process_message_element(GstMessage *message)
             MH_ERROR("Bad buffer-export-data message: mirsink version mismatch?");
             return;
         }
-        MH_DEBUG("Exporting %dx%d buffer (fd %d)", meta.width, meta.height, fd);
+        // Sinks exporting a single buffer don't tell its index
+        if (!gst_structure_get_int(msg_data, "index", &meta.index))
+            meta.index = 0;
+        if (meta.index < 0 ||
+            meta.index >= core::ubuntu::media::video::maxExportedBuffers)
+        {
+            MH_ERROR("Exported buffer index %d out of range", meta.index);
+            return;
+        }
+        MH_DEBUG("Exporting %dx%d buffer %d (fd %d)",
+                 meta.width, meta.height, meta.index, fd);
         send_buffer_data(fd, &meta, sizeof meta);
     }
     else if (g_strcmp0("frame-ready", struct_name) == 0)
     {
-        send_frame_ready();
+        // Whatever is not filled in must not leak to the consumer
+        core::ubuntu::media::video::FrameReady frame = {};
+        if (!gst_structure_get_int(msg_data, "index", &frame.index))
+            frame.index = 0;
+        fill_frame_timing(msg_data, &frame);
+        send_frame_ready(frame);
     }
     else if (g_strcmp0("streams-changed", struct_name) == 0)
     {
@@ -363,16 +476,16 @@ void gstreamer::Playbin::on_new_message(const Bus::Message& message)
     switch (message.type)
     {
     case GST_MESSAGE_ERROR:
-        Q_EMIT errorOccurred(message.detail.error_warning_info);
+        Q_EMIT errorOccurred(message.detail().error_warning_info);
         break;
     case GST_MESSAGE_WARNING:
-        Q_EMIT warningOccurred(message.detail.error_warning_info);
+        Q_EMIT warningOccurred(message.detail().error_warning_info);
         break;
     case GST_MESSAGE_INFO:
-        Q_EMIT infoOccurred(message.detail.error_warning_info);
+        Q_EMIT infoOccurred(message.detail().error_warning_info);
         break;
     case GST_MESSAGE_STATE_CHANGED:
-        if (message.source == "playbin") {
+        if (message.source() == "playbin") {
             g_object_get(G_OBJECT(pipeline), "current-audio", &audio_stream_id, NULL);
             g_object_get(G_OBJECT(pipeline), "current-video", &video_stream_id, NULL);
 #ifdef DEBUG_GST_PIPELINE
@@ -382,10 +495,10 @@ void gstreamer::Playbin::on_new_message(const Bus::Message& message)
 
             // TODO: move here the stateChange() signal handling
             // from gstreamer::Engine
-        } else if (message.source == "video-sink") {
-            processVideoSinkStateChanged(message.detail.state_changed);
+        } else if (message.source() == "video-sink") {
+            processVideoSinkStateChanged(message.detail().state_changed);
         }
-        Q_EMIT stateChanged(message.detail.state_changed, message.source);
+        Q_EMIT stateChanged(message.detail().state_changed, message.source());
         break;
     case GST_MESSAGE_APPLICATION:
     case GST_MESSAGE_ELEMENT:
@@ -397,29 +510,54 @@ void gstreamer::Playbin::on_new_message(const Bus::Message& message)
     case GST_MESSAGE_TAG:
         {
             gchar *orientation;
-            if (gst_tag_list_get_string(message.detail.tag.tag_list, "image-orientation", &orientation))
+            if (gst_tag_list_get_string(message.detail().tag.tag_list, "image-orientation", &orientation))
             {
                 // If the image-orientation tag is in the GstTagList, signal the Engine
                 Q_EMIT orientationChanged(orientation_lut(orientation));
                 g_free (orientation);
             }
 
-            Q_EMIT tagAvailable(message.detail.tag);
+            Q_EMIT tagAvailable(message.detail().tag);
         }
         break;
     case GST_MESSAGE_ASYNC_DONE:
-        if (is_seeking)
+    {
+        if (rate_seek_pending)
         {
-            // FIXME: Pass the actual playback time position to the signal call
-            Q_EMIT seekedTo(0);
-            is_seeking = false;
+            // A new stream always starts at the normal rate
+            rate_seek_pending = false;
+            seek_with_rate(position(), GST_SEEK_FLAG_ACCURATE);
+        }
+        /* The ASYNC_DONE of an earlier seek doesn't complete the one
+         * requested by the client */
+        if (is_seeking && user_seek_sent)
+            finish_seek();
+        break;
+    }
+    case GST_MESSAGE_STREAM_START:
+        {
+            QUrl started_uri;
+            {
+                std::lock_guard<std::mutex> lock(next_uri_guard);
+                std::swap(started_uri, queued_uri);
+            }
+            if (!started_uri.isEmpty()) {
+                current_uri = started_uri;
+                const MediaFileType fileType = file_type_for_uri(started_uri);
+                if (fileType != MEDIA_FILE_TYPE_NONE)
+                    setMediaFileType(fileType);
+                // The new stream starts at the normal rate
+                if (rate != 1.0)
+                    seek_with_rate(position(), GST_SEEK_FLAG_ACCURATE);
+                Q_EMIT nextUriStarted(started_uri);
+            }
         }
         break;
     case GST_MESSAGE_EOS:
         Q_EMIT endOfStream();
         break;
     case GST_MESSAGE_BUFFERING:
-        Q_EMIT bufferingChanged(message.detail.buffering.percent);
+        Q_EMIT bufferingChanged(message.detail().buffering.percent);
         break;
     default:
         break;
@@ -455,15 +593,26 @@ void gstreamer::Playbin::setup_pipeline_for_audio_video()
         MH_ERROR("Error trying to create audio sink %s", asink_name);
     }
 
-    const char *vsink_name = ::getenv("CORE_UBUNTU_MEDIA_SERVICE_VIDEO_SINK_NAME");
+    const core::ubuntu::media::AVBackend::Capabilities &caps =
+        core::ubuntu::media::AVBackend::capabilities();
 
-    if (vsink_name == nullptr) {
-        if (backend == core::ubuntu::media::AVBackend::Backend::hybris)
-            vsink_name = HYBRIS_SINK;
-        else if (backend == core::ubuntu::media::AVBackend::Backend::mir)
-            vsink_name = MIR_SINK;
+    /* scaletempo keeps the pitch unchanged when the playback rate changes;
+     * at the normal rate it works in passthrough mode */
+    GstElement *audio_filter = caps.pitch_correction ?
+        gst_element_factory_make("scaletempo", NULL) : nullptr;
+    if (audio_filter) {
+        g_object_set(pipeline, "audio-filter", audio_filter, NULL);
+        has_pitch_correction = true;
+    } else {
+        MH_WARNING("scaletempo not available: audio can only be played at the normal rate");
     }
 
+    const char *vsink_name = ::getenv("CORE_UBUNTU_MEDIA_SERVICE_VIDEO_SINK_NAME");
+
+    const QByteArray default_vsink_name = caps.default_video_sink.toUtf8();
+    if (vsink_name == nullptr && caps.buffer_export)
+        vsink_name = default_vsink_name.constData();
+
     if (vsink_name) {
         video_sink_name = vsink_name;
         video_sink = gst_element_factory_make (vsink_name, "video-sink");
@@ -584,32 +733,41 @@ void gstreamer::Playbin::set_uri(
     const media::Player::HeadersType &headers,
     bool do_pipeline_reset)
 {
-    gchar *current_uri = nullptr;
-    g_object_get(pipeline, "current-uri", &current_uri, NULL);
+    {
+        // Whatever was queued for gapless playback is now obsolete
+        std::lock_guard<std::mutex> lock(next_uri_guard);
+        queued_uri.clear();
+    }
 
     // Checking for a current_uri being set and not resetting the pipeline
     // if there isn't a current_uri causes the first play to start playback
-    // sooner since reset_pipeline won't be called
-    if (current_uri and do_pipeline_reset)
+    // sooner since reset_pipeline won't be called. The previous URI might
+    // not have reached playbin yet, so this can't ask the pipeline.
+    if (!current_uri.isEmpty() and do_pipeline_reset)
         reset_pipeline();
+    current_uri = uri;
 
-    QString tmp_uri{uri.toString(QUrl::FullyEncoded)};
-    g_object_set(pipeline, "uri", qUtf8Printable(tmp_uri), NULL);
-    if (is_video_file(uri))
-        setMediaFileType(MEDIA_FILE_TYPE_VIDEO);
-    else if (is_audio_file(uri))
-        setMediaFileType(MEDIA_FILE_TYPE_AUDIO);
+    const QByteArray tmp_uri = uri.toEncoded();
+    const MediaFileType fileType = file_type_for_uri(uri);
+    if (fileType != MEDIA_FILE_TYPE_NONE)
+        setMediaFileType(fileType);
 
     request_headers = headers;
-
-    if (!tmp_uri.isEmpty()) {
-        /* Setting the pipeline to "paused" to let GStreamer inspect the media
-         * and report the number of audio and video streams
-         */
-        gst_element_set_state(pipeline, GST_STATE_PAUSED);
-    }
-
-    g_free(current_uri);
+    rate_seek_pending = rate != 1.0;
+    // Seeks requested on the previous URI are meaningless now
+    clear_seek_state();
+
+    // This must happen after the reset, if any
+    GstElement *p = pipeline;
+    worker->run(pipeline, [p, tmp_uri]() {
+        g_object_set(p, "uri", tmp_uri.constData(), NULL);
+        if (!tmp_uri.isEmpty()) {
+            /* Setting the pipeline to "paused" to let GStreamer inspect the
+             * media and report the number of audio and video streams
+             */
+            gst_element_set_state(p, GST_STATE_PAUSED);
+        }
+    });
 }
 
 void gstreamer::Playbin::setup_source(GstElement *source)
@@ -673,45 +831,203 @@ void gstreamer::Playbin::updateMediaFileType()
         setMediaFileType(MEDIA_FILE_TYPE_AUDIO);
 }
 
+void gstreamer::Playbin::set_next_uri(const QUrl &uri)
+{
+    std::lock_guard<std::mutex> lock(next_uri_guard);
+    next_uri = uri;
+}
+
 QUrl gstreamer::Playbin::uri() const
 {
-    gchar* data = nullptr;
-    g_object_get(pipeline, "current-uri", &data, nullptr);
+    return current_uri;
+}
+
+void gstreamer::Playbin::set_state(GstState new_state, QObject *context,
+                                   const std::function<void(bool)> &done)
+{
+    MH_DEBUG("Requested state change to %s",
+             gst_element_state_get_name(new_state));
+    worker->set_state(pipeline, new_state, context, done);
+}
+
+bool gstreamer::Playbin::seek(const std::chrono::microseconds& ms,
+                              media::Player::SeekMode mode)
+{
+    const GstSeekFlags flags = mode == media::Player::SeekMode::accurate ?
+        GST_SEEK_FLAG_ACCURATE :
+        GstSeekFlags(GST_SEEK_FLAG_KEY_UNIT | GST_SEEK_FLAG_SNAP_NEAREST);
+    const gint64 position = ms.count() * 1000;
+
+    if (is_seeking) {
+        /* Flushing seeks would queue behind each other and stall the
+         * pipeline: just remember the latest target */
+        if (has_pending_seek) coalesced_seeks++;
+        has_pending_seek = true;
+        pending_seek_position = position;
+        pending_seek_flags = flags;
+        return true;
+    }
 
-    QUrl result = QUrl::fromEncoded((data == nullptr ? "" : data));
-    g_free(data);
+    seek_timer.start();
+    start_seek(position, flags);
+    return true;
+}
 
-    return result;
+void gstreamer::Playbin::start_seek(gint64 position, GstSeekFlags flags)
+{
+    if (position < 0) position = this->position();
+    is_seeking = true;
+    user_seek_sent = false;
+    user_seek = seek_with_rate(position, flags);
+    seek_watchdog.start();
 }
 
-bool gstreamer::Playbin::set_state(GstState new_state)
+void gstreamer::Playbin::on_seek_sent(quint32 seek, bool succeeded,
+                                      gint64 position)
 {
-    bool result = false;
-    const auto ret = gst_element_set_state(pipeline, new_state);
+    if (!succeeded)
+        MH_WARNING("Seek to %" G_GINT64_FORMAT " failed", position);
+    if (!is_seeking || seek != user_seek)
+        return;
 
-    MH_DEBUG("Requested state change.");
+    if (!succeeded) {
+        // No ASYNC_DONE is coming
+        seek_watchdog.stop();
+        if (has_pending_seek) {
+            has_pending_seek = false;
+            start_seek(pending_seek_position, pending_seek_flags);
+            return;
+        }
+        is_seeking = false;
+        coalesced_seeks = 0;
+        return;
+    }
 
-    switch (ret)
-    {
-    case GST_STATE_CHANGE_FAILURE:
-        result = false; break;
-    case GST_STATE_CHANGE_NO_PREROLL:
-    case GST_STATE_CHANGE_SUCCESS:
-    case GST_STATE_CHANGE_ASYNC:
-        result = true; break;
+    user_seek_sent = true;
+    /* The pipeline might have prerolled before the worker reported back, in
+     * which case the ASYNC_DONE has already been handled */
+    if (gst_element_get_state(pipeline, nullptr, nullptr, 0) !=
+        GST_STATE_CHANGE_ASYNC)
+        finish_seek();
+}
+
+void gstreamer::Playbin::finish_seek()
+{
+    seek_watchdog.stop();
+    if (has_pending_seek) {
+        has_pending_seek = false;
+        start_seek(pending_seek_position, pending_seek_flags);
+        return;
     }
+    is_seeking = false;
+    MH_DEBUG("Seek completed in %lld ms, %d requests coalesced",
+             seek_timer.elapsed(), coalesced_seeks);
+    coalesced_seeks = 0;
+    Q_EMIT seekedTo(position() / 1000);
+}
 
-    return result;
+void gstreamer::Playbin::clear_seek_state()
+{
+    seek_watchdog.stop();
+    is_seeking = false;
+    has_pending_seek = false;
+    coalesced_seeks = 0;
+    user_seek = 0;
+    user_seek_sent = false;
 }
 
-bool gstreamer::Playbin::seek(const std::chrono::microseconds& ms)
+quint32 gstreamer::Playbin::seek_with_rate(gint64 position, GstSeekFlags flags)
 {
-    is_seeking = true;
-    return gst_element_seek_simple(
-                pipeline,
-                GST_FORMAT_TIME,
-                (GstSeekFlags)(GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_KEY_UNIT),
-                ms.count() * 1000);
+    // 0 is never used, so that it can't match a cleared user_seek
+    if (++last_seek == 0) ++last_seek;
+    const quint32 seek = last_seek;
+
+    int seek_flags = GST_SEEK_FLAG_FLUSH | flags;
+    if (rate < 0 || rate > max_audible_rate) {
+        /* Decoding every frame would be a waste of CPU: only decode the key
+         * frames, and let the demuxer drop the audio */
+        seek_flags |= GST_SEEK_FLAG_TRICKMODE |
+            GST_SEEK_FLAG_TRICKMODE_KEY_UNITS |
+            GST_SEEK_FLAG_TRICKMODE_NO_AUDIO;
+        seek_flags &= ~GST_SEEK_FLAG_ACCURATE;
+    }
+
+    /* Sending the event takes the pipeline state lock, so it must be queued
+     * after the pending state changes */
+    GstElement *p = pipeline;
+    const double r = rate;
+    auto ok = QSharedPointer<bool>::create(true);
+    worker->run(pipeline, [p, r, seek_flags, position, ok]() {
+        // Playing backwards, the segment ends at the requested position
+        *ok = r > 0 ?
+            gst_element_seek(p, r, GST_FORMAT_TIME,
+                             GstSeekFlags(seek_flags),
+                             GST_SEEK_TYPE_SET, position,
+                             GST_SEEK_TYPE_NONE, GST_CLOCK_TIME_NONE) :
+            gst_element_seek(p, r, GST_FORMAT_TIME,
+                             GstSeekFlags(seek_flags),
+                             GST_SEEK_TYPE_SET, 0,
+                             GST_SEEK_TYPE_SET, position);
+    }, this, [this, seek, position, ok]() {
+        on_seek_sent(seek, *ok, position);
+    });
+    return seek;
+}
+
+bool gstreamer::Playbin::set_playback_rate(double new_rate)
+{
+    if (new_rate == 0.0 ||
+        new_rate < minimum_playback_rate() ||
+        new_rate > maximum_playback_rate()) {
+        MH_WARNING("Unsupported playback rate %f", new_rate);
+        return false;
+    }
+    if (new_rate == rate) return true;
+
+    rate = new_rate;
+    const bool audible = rate >= min_audible_rate && rate <= max_audible_rate &&
+        (rate == 1.0 || has_pitch_correction);
+    g_object_set(pipeline, "mute", audible ? FALSE : TRUE, NULL);
+
+    GstState state = GST_STATE_NULL;
+    gst_element_get_state(pipeline, &state, nullptr, 0);
+    if (state < GST_STATE_PAUSED) {
+        // Nothing to seek yet: the rate is applied once prerolled
+        rate_seek_pending = true;
+        return true;
+    }
+
+    rate_seek_pending = false;
+    if (is_seeking) {
+        // The new rate will be applied by the next seek
+        if (!has_pending_seek) {
+            has_pending_seek = true;
+            pending_seek_position = -1;
+            pending_seek_flags = GST_SEEK_FLAG_ACCURATE;
+        }
+        return true;
+    }
+    seek_with_rate(position(), GST_SEEK_FLAG_ACCURATE);
+    return true;
+}
+
+double gstreamer::Playbin::playback_rate() const
+{
+    return rate;
+}
+
+double gstreamer::Playbin::minimum_playback_rate() const
+{
+    if (m_fileType == MEDIA_FILE_TYPE_VIDEO)
+        return -max_trick_mode_rate;
+    return has_pitch_correction ? min_audible_rate : 1.0;
+}
+
+double gstreamer::Playbin::maximum_playback_rate() const
+{
+    if (m_fileType == MEDIA_FILE_TYPE_VIDEO)
+        return max_trick_mode_rate;
+    return has_pitch_correction ? max_audible_rate : 1.0;
 }
 
 QSize gstreamer::Playbin::get_video_dimensions() const
@@ -751,8 +1067,8 @@ QSize gstreamer::Playbin::get_video_dimensions() const
 
 QString gstreamer::Playbin::file_info_from_uri(const QUrl &uri) const
 {
-    QMimeType mimeType = QMimeDatabase().mimeTypeForUrl(uri);
-    return mimeType.name();
+    // Sniffing the content can be expensive: do it once per file
+    return content_type_cache->content_type(uri);
 }
 
 QString gstreamer::Playbin::get_file_content_type(const QUrl &uri) const
@@ -806,6 +1122,26 @@ bool gstreamer::Playbin::is_video_file(const QUrl &uri) const
     return false;
 }
 
+gstreamer::Playbin::MediaFileType gstreamer::Playbin::file_type_for_uri(const QUrl &uri) const
+{
+    if (uri.isEmpty())
+        return MEDIA_FILE_TYPE_NONE;
+
+    const QString content_type = get_file_content_type(uri);
+    if (content_type.startsWith("video/"))
+    {
+        MH_INFO("Found video content");
+        return MEDIA_FILE_TYPE_VIDEO;
+    }
+    else if (content_type.startsWith("audio/"))
+    {
+        MH_INFO("Found audio content");
+        return MEDIA_FILE_TYPE_AUDIO;
+    }
+
+    return MEDIA_FILE_TYPE_NONE;
+}
+
 gstreamer::Playbin::MediaFileType gstreamer::Playbin::mediaFileType() const
 {
     return m_fileType;
@@ -912,11 +1248,56 @@ void gstreamer::Playbin::send_buffer_data(int fd, void *data, size_t len)
                  strerror(errno), errno);
 }
 
-void gstreamer::Playbin::send_frame_ready(void)
+void gstreamer::Playbin::fill_frame_timing(
+        const GstStructure *msg_data,
+        core::ubuntu::media::video::FrameReady *frame)
 {
-    const char ready = 'r';
+    frame->sequence = frame_sequence++;
+
+    // Prefer the timestamp from the sink, if it tells it
+    guint64 pts;
+    frame->pts = -1;
+    if (gst_structure_get_uint64(msg_data, "pts", &pts)) {
+        frame->pts = pts;
+    } else {
+        GstSample *sample = nullptr;
+        g_object_get(video_sink, "last-sample", &sample, NULL);
+        if (sample) {
+            GstBuffer *buffer = gst_sample_get_buffer(sample);
+            const GstSegment *segment = gst_sample_get_segment(sample);
+            if (buffer && segment && GST_BUFFER_PTS_IS_VALID(buffer)) {
+                const guint64 stream_time = gst_segment_to_stream_time(
+                    segment, GST_FORMAT_TIME, GST_BUFFER_PTS(buffer));
+                if (GST_CLOCK_TIME_IS_VALID(stream_time))
+                    frame->pts = stream_time;
+            }
+            gst_sample_unref(sample);
+        }
+    }
+
+    gint64 pos;
+    frame->position =
+        gst_element_query_position(pipeline, GST_FORMAT_TIME, &pos) ? pos : -1;
+    // Only a hint for the consumer, so not worth taking the state lock
+    frame->rate = GST_STATE(pipeline) == GST_STATE_PLAYING ? rate : 0.0;
+
+    if (frame->sequence % DROP_STATS_INTERVAL == 0) {
+        GstStructure *stats = nullptr;
+        g_object_get(video_sink, "stats", &stats, NULL);
+        if (stats) {
+            guint64 dropped;
+            if (gst_structure_get_uint64(stats, "dropped", &dropped))
+                dropped_frames = dropped;
+            gst_structure_free(stats);
+        }
+    }
+    frame->dropped = dropped_frames;
+}
 
-    if (send (sock_consumer, &ready, sizeof ready, 0) == -1)
+void gstreamer::Playbin::send_frame_ready(
+        const core::ubuntu::media::video::FrameReady &frame)
+{
+    if (send (sock_consumer, &frame, sizeof frame, 0) == -1)
         MH_ERROR("Error when sending frame ready flag to client: %s (%d)",
                  strerror(errno), errno);
 }
@@ -23,14 +23,19 @@
 
 #include "core/media/player.h"
 
+#include <QElapsedTimer>
 #include <QObject>
+#include <QSharedPointer>
 #include <QString>
+#include <QTimer>
 #include <QUrl>
 
 #include <gio/gio.h>
 #include <gst/gst.h>
 
 #include <chrono>
+#include <functional>
+#include <mutex>
 #include <string>
 
 // Uncomment to generate a dot file at the time that the pipeline
@@ -39,8 +44,17 @@
 // other image format, use: dot pipeline.dot -Tpng -o pipeline.png
 //#define DEBUG_GST_PIPELINE
 
+namespace core { namespace ubuntu { namespace media {
+class ContentTypeCache;
+namespace video { struct FrameReady; }
+}}}
+
 namespace gstreamer
 {
+class PipelineWorker;
+
+/* The state changes and seeks are performed asynchronously, on the
+ * PipelineWorker threads: their outcome is reported by the bus messages. */
 class Playbin: public QObject
 {
     Q_OBJECT
@@ -60,6 +74,13 @@ public:
         MEDIA_FILE_TYPE_VIDEO
     };
 
+    /* Rates within this range are played with audio, pitch-corrected if
+     * the scaletempo element is available. Faster rates and rewinding skip
+     * to key frames only, and the audio is muted. */
+    static constexpr double min_audible_rate = 0.5;
+    static constexpr double max_audible_rate = 2.0;
+    static constexpr double max_trick_mode_rate = 8.0;
+
     static std::string get_audio_role_str(core::ubuntu::media::Player::AudioStreamRole audio_role);
 
     static const std::string& pipeline_name();
@@ -77,6 +98,13 @@ public:
     void reset();
     void reset_pipeline();
 
+    // Brings the pipeline to READY state, discarding the resulting messages
+    void warm_up();
+    /* Restores the initial configuration after a session has used this
+     * Playbin, and warms it up again. Returns false if it can't be reused. */
+    bool reset_for_reuse();
+    void set_key(core::ubuntu::media::Player::PlayerKey key);
+
     void on_new_message(const Bus::Message& message);
     void processVideoSinkStateChanged(const Bus::Message::Detail::StateChanged &state);
     void process_message_element(GstMessage *message);
@@ -101,14 +129,33 @@ public:
     uint64_t duration() const;
 
     void set_uri(const QUrl &uri, const core::ubuntu::media::Player::HeadersType& headers, bool do_pipeline_reset = true);
+    // The URI being played, even if playbin has not been given it yet
     QUrl uri() const;
+    /* Sets the URI to be played right after the current one, without
+     * stopping the pipeline; an empty URI disables gapless playback. */
+    void set_next_uri(const QUrl &uri);
 
     void setup_source(GstElement *source);
     void updateMediaFileType();
 
-    // Sets the pipeline's state (stopped, playing, paused, etc).
-    bool set_state(GstState new_state);
-    bool seek(const std::chrono::microseconds& ms);
+    /* Sets the pipeline's state (stopped, playing, paused, etc). Once the
+     * change has been attempted, `done` is invoked in the main thread with
+     * its outcome, unless `context` has been destroyed meanwhile. */
+    void set_state(GstState new_state, QObject *context = nullptr,
+                   const std::function<void(bool)> &done =
+                       std::function<void(bool)>());
+    /* While a seek is in progress, further requests are coalesced: only the
+     * latest one is performed once the pipeline has settled. */
+    bool seek(const std::chrono::microseconds& ms,
+              core::ubuntu::media::Player::SeekMode mode);
+
+    /* Changes the playback rate; negative values play backwards. Returns
+     * false if the rate is out of the supported range. */
+    bool set_playback_rate(double rate);
+    double playback_rate() const;
+    // The supported range depends on the media type and on the plugins
+    double minimum_playback_rate() const;
+    double maximum_playback_rate() const;
 
     QSize get_video_dimensions() const;
 
@@ -117,6 +164,8 @@ public:
 
     bool is_audio_file(const QUrl &uri) const;
     bool is_video_file(const QUrl &uri) const;
+    // Like the two methods above, but only looks up the content type once
+    MediaFileType file_type_for_uri(const QUrl &uri) const;
 
     MediaFileType mediaFileType() const;
 
@@ -140,13 +189,22 @@ public:
     gint audio_stream_id;
     gint video_stream_id;
     GstState current_new_state;
+    // Guards next_uri and queued_uri, accessed from the streaming thread
+    std::mutex next_uri_guard;
+    QUrl next_uri;
+    QUrl queued_uri;
+    /* Tracked here, since playbin's "current-uri" lags behind the jobs
+     * still queued on the worker */
+    QUrl current_uri;
 
 Q_SIGNALS:
     void errorOccurred(const Bus::Message::Detail::ErrorWarningInfo &);
     void warningOccurred(const Bus::Message::Detail::ErrorWarningInfo &);
     void infoOccurred(const Bus::Message::Detail::ErrorWarningInfo &);
 
-    void aboutToFinish();
+    // nextUriQueued is true if the next URI has already been set on playbin
+    void aboutToFinish(bool nextUriQueued);
+    void nextUriStarted(const QUrl &uri);
     void seekedTo(uint64_t offset);
     void stateChanged(const Bus::Message::Detail::StateChanged &state,
                       const QByteArray &source);
@@ -166,13 +224,50 @@ private:
     bool is_supported_video_sink(void) const;
     bool connect_to_consumer(void);
     void send_buffer_data(int fd, void *data, size_t len);
-    void send_frame_ready(void);
+    // Sets the sequence number, timestamps, rate and drop count of the frame
+    void fill_frame_timing(const GstStructure *msg_data,
+                           core::ubuntu::media::video::FrameReady *frame);
+    void send_frame_ready(const core::ubuntu::media::video::FrameReady &frame);
     void process_missing_plugin_message(GstMessage *message);
-
-    const core::ubuntu::media::Player::PlayerKey key;
+    // Returns the serial number identifying the seek
+    quint32 seek_with_rate(gint64 position, GstSeekFlags flags);
+    // A negative position means the current one
+    void start_seek(gint64 position, GstSeekFlags flags);
+    void on_seek_sent(quint32 seek, bool succeeded, gint64 position);
+    // Starts the pending seek, if any, or reports the client's seek as done
+    void finish_seek();
+    void clear_seek_state();
+
+    core::ubuntu::media::Player::PlayerKey key;
     const core::ubuntu::media::AVBackend::Backend backend;
+    QSharedPointer<core::ubuntu::media::ContentTypeCache> content_type_cache;
+    QSharedPointer<PipelineWorker> worker;
     std::string video_sink_name;
     int sock_consumer;
+    bool buffer_streaming_enabled;
+    // Sequence number of the next exported frame
+    uint32_t frame_sequence;
+    // As last read from the video sink's stats
+    uint64_t dropped_frames;
+    bool has_pitch_correction;
+    double rate;
+    // Set when the rate must be applied once the pipeline prerolls
+    bool rate_seek_pending;
+    // The latest seek requested while another one was in flight
+    bool has_pending_seek;
+    gint64 pending_seek_position;
+    GstSeekFlags pending_seek_flags;
+    int coalesced_seeks;
+    QElapsedTimer seek_timer;
+    quint32 last_seek;
+    // The seek performed for the client, while is_seeking is set
+    quint32 user_seek;
+    /* Set once the client's seek has been sent to the pipeline: the first
+     * ASYNC_DONE after that settles it, since back-to-back flushing seeks
+     * may be answered by a single ASYNC_DONE */
+    bool user_seek_sent;
+    // Unblocks the seek requests if the pipeline never settles
+    QTimer seek_watchdog;
 };
 }
 
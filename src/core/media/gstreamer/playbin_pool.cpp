@@ -0,0 +1,161 @@
+/*
+ * Copyright © 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "playbin_pool.h"
+
+#include "playbin.h"
+
+#include "core/media/logging.h"
+
+#include <QTimer>
+#include <QVector>
+#include <QWeakPointer>
+
+namespace media = core::ubuntu::media;
+
+namespace gstreamer
+{
+
+class PlaybinPoolPrivate
+{
+public:
+    PlaybinPoolPrivate(int capacity);
+    ~PlaybinPoolPrivate();
+
+    void schedule_refill();
+    void refill();
+
+    int m_capacity;
+    QVector<Playbin*> m_idle;
+    QTimer m_refillTimer;
+};
+
+} // namespace
+
+using namespace gstreamer;
+
+PlaybinPoolPrivate::PlaybinPoolPrivate(int capacity):
+    m_capacity(capacity)
+{
+    if (m_capacity < 0) {
+        m_capacity =
+            qEnvironmentVariableIsSet("MEDIA_HUB_PLAYBIN_POOL_SIZE") ?
+            qEnvironmentVariableIntValue("MEDIA_HUB_PLAYBIN_POOL_SIZE") : 1;
+    }
+
+    // A zero timeout fires when there are no pending events
+    m_refillTimer.setSingleShot(true);
+    m_refillTimer.setInterval(0);
+    m_refillTimer.callOnTimeout([this]() { refill(); });
+}
+
+PlaybinPoolPrivate::~PlaybinPoolPrivate()
+{
+    qDeleteAll(m_idle);
+}
+
+void PlaybinPoolPrivate::schedule_refill()
+{
+    if (m_idle.count() < m_capacity && !m_refillTimer.isActive()) {
+        m_refillTimer.start();
+    }
+}
+
+void PlaybinPoolPrivate::refill()
+{
+    // Build one pipeline at a time, so that we don't block the main loop
+    try {
+        auto playbin = new Playbin(media::Player::invalidKey);
+        // The state change itself happens in a worker thread
+        playbin->warm_up();
+        m_idle.append(playbin);
+    } catch (const std::runtime_error &e) {
+        MH_WARNING("Could not create a playbin for the pool: %s", e.what());
+        return;
+    }
+
+    MH_DEBUG("Playbin pool: %d/%d pipelines ready",
+             m_idle.count(), m_capacity);
+    schedule_refill();
+}
+
+PlaybinPool::PlaybinPool(int capacity):
+    d_ptr(new PlaybinPoolPrivate(capacity))
+{
+    Q_D(PlaybinPool);
+    d->schedule_refill();
+}
+
+PlaybinPool::~PlaybinPool() = default;
+
+QSharedPointer<PlaybinPool> PlaybinPool::instance()
+{
+    static QWeakPointer<PlaybinPool> weakRef;
+
+    QSharedPointer<PlaybinPool> pool = weakRef.toStrongRef();
+    if (!pool) {
+        pool = QSharedPointer<PlaybinPool>::create();
+        weakRef = pool;
+    }
+    return pool;
+}
+
+int PlaybinPool::capacity() const
+{
+    Q_D(const PlaybinPool);
+    return d->m_capacity;
+}
+
+int PlaybinPool::available() const
+{
+    Q_D(const PlaybinPool);
+    return d->m_idle.count();
+}
+
+Playbin *PlaybinPool::take(media::Player::PlayerKey key)
+{
+    Q_D(PlaybinPool);
+
+    Playbin *playbin = nullptr;
+    if (!d->m_idle.isEmpty()) {
+        playbin = d->m_idle.takeLast();
+        playbin->set_key(key);
+    } else {
+        MH_DEBUG("Playbin pool is empty, creating a new pipeline");
+        playbin = new Playbin(key);
+    }
+
+    d->schedule_refill();
+    return playbin;
+}
+
+void PlaybinPool::recycle(Playbin *playbin)
+{
+    Q_D(PlaybinPool);
+
+    // Make sure that nobody hears about the reset
+    playbin->disconnect();
+
+    if (d->m_idle.count() >= d->m_capacity || !playbin->reset_for_reuse()) {
+        delete playbin;
+        return;
+    }
+
+    MH_DEBUG("Playbin returned to the pool");
+    d->m_idle.append(playbin);
+    d->m_refillTimer.stop();
+    d->schedule_refill();
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright © 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GSTREAMER_PLAYBIN_POOL_H_
+#define GSTREAMER_PLAYBIN_POOL_H_
+
+#include "core/media/player.h"
+
+#include <QScopedPointer>
+#include <QSharedPointer>
+
+namespace gstreamer
+{
+class Playbin;
+
+/*
+ * Keeps a few Playbin instances built and in READY state, so that new
+ * sessions do not have to pay for the pipeline construction and the sink
+ * initialization. The pool is refilled when the main loop is idle, and the
+ * pipelines of terminated sessions are reset and reused.
+ */
+class PlaybinPoolPrivate;
+class PlaybinPool
+{
+public:
+    /* If `capacity` is negative, the value of the
+     * MEDIA_HUB_PLAYBIN_POOL_SIZE environment variable is used, defaulting
+     * to 1. A capacity of 0 disables pre-warming. */
+    PlaybinPool(int capacity = -1);
+    ~PlaybinPool();
+
+    // Returns an instance shared by all the engines
+    static QSharedPointer<PlaybinPool> instance();
+
+    int capacity() const;
+    int available() const;
+
+    // The caller takes ownership of the returned Playbin
+    Playbin *take(core::ubuntu::media::Player::PlayerKey key);
+    // Takes back ownership of a Playbin which is no longer in use
+    void recycle(Playbin *playbin);
+
+private:
+    Q_DECLARE_PRIVATE(PlaybinPool)
+    QScopedPointer<PlaybinPoolPrivate> d_ptr;
+};
+}
+
+#endif // GSTREAMER_PLAYBIN_POOL_H_
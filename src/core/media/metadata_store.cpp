@@ -0,0 +1,416 @@
+/*
+ * Copyright © 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "metadata_store.h"
+
+#include "file_identity.h"
+#include "logging.h"
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QWeakPointer>
+
+namespace media = core::ubuntu::media;
+
+using namespace media;
+
+namespace {
+
+const quint32 fileMagic = 0x4d484d53; // "MHMS"
+const quint32 fileVersion = 2;
+const int headerSize = 2 * sizeof(quint32);
+const QDataStream::Version streamVersion = QDataStream::Qt_5_6;
+
+} // namespace
+
+namespace core {
+namespace ubuntu {
+namespace media {
+
+class MetaDataStorePrivate
+{
+public:
+    struct Entry
+    {
+        FileIdentity identity;
+        /* Position and length of the serialized metadata in the mapped
+         * file; the offset is -1 if the metadata only lives in memory */
+        qint64 offset = -1;
+        int length = 0;
+        QString content_type;
+        QVariantMap metadata;
+    };
+
+    MetaDataStorePrivate(const QString &file_path);
+
+    void load();
+    bool parse_record(const uchar *data, qint64 offset, qint64 end,
+                      qint64 *next);
+    bool open_for_append();
+    bool append_record(const QString &path, const Entry &entry);
+    void compact();
+    void close();
+    QVariantMap decode(const Entry &entry) const;
+    // Returns the entry for `path`, dropping it if it's stale
+    Entry *valid_entry(const QString &path);
+
+    QString m_filePath;
+    QFile m_file;
+    const uchar *m_map;
+    QHash<QString, Entry> m_entries;
+    // Number of records in the file, including the superseded ones
+    int m_recordCount;
+};
+
+}}} // namespace
+
+MetaDataStorePrivate::MetaDataStorePrivate(const QString &file_path):
+    m_filePath(file_path),
+    m_map(nullptr),
+    m_recordCount(0)
+{
+}
+
+void MetaDataStorePrivate::load()
+{
+    if (m_filePath.isEmpty()) return;
+
+    QDir().mkpath(QFileInfo(m_filePath).absolutePath());
+    m_file.setFileName(m_filePath);
+    if (!m_file.open(QIODevice::ReadWrite)) {
+        MH_WARNING("Cannot open metadata cache %s: %s",
+                   qUtf8Printable(m_filePath),
+                   qUtf8Printable(m_file.errorString()));
+        return;
+    }
+
+    const qint64 fileSize = m_file.size();
+    if (fileSize > 0) {
+        m_map = m_file.map(0, fileSize);
+    }
+
+    qint64 validEnd = 0;
+    if (m_map && fileSize >= headerSize) {
+        QDataStream header(QByteArray::fromRawData(
+            reinterpret_cast<const char*>(m_map), headerSize));
+        quint32 magic, version;
+        header >> magic >> version;
+        if (magic == fileMagic && version == fileVersion) {
+            validEnd = headerSize;
+            qint64 next;
+            while (validEnd < fileSize &&
+                   parse_record(m_map, validEnd, fileSize, &next)) {
+                validEnd = next;
+            }
+        }
+    }
+
+    if (validEnd < fileSize) {
+        // Either a different format or a record interrupted by a crash:
+        // drop everything after the last good record
+        MH_DEBUG("Truncating metadata cache at %lld", validEnd);
+        m_file.resize(validEnd);
+    }
+
+    if (validEnd == 0 && !open_for_append()) return;
+
+    MH_DEBUG("Loaded %d metadata cache entries from %d records",
+             m_entries.count(), m_recordCount);
+
+    if (m_recordCount > 2 * m_entries.count() + 64) {
+        compact();
+    }
+}
+
+bool MetaDataStorePrivate::parse_record(const uchar *data, qint64 offset,
+                                        qint64 end, qint64 *next)
+{
+    if (end - offset < qint64(sizeof(quint32))) return false;
+
+    QDataStream lengthStream(QByteArray::fromRawData(
+        reinterpret_cast<const char*>(data + offset), sizeof(quint32)));
+    quint32 length;
+    lengthStream >> length;
+    offset += sizeof(quint32);
+    if (length == 0 || end - offset < length) return false;
+
+    const QByteArray payload = QByteArray::fromRawData(
+        reinterpret_cast<const char*>(data + offset), length);
+    QDataStream stream(payload);
+    stream.setVersion(streamVersion);
+
+    QString path;
+    Entry entry;
+    stream >> path >> entry.identity >> entry.content_type;
+    if (stream.status() != QDataStream::Ok) return false;
+
+    const qint64 consumed = stream.device()->pos();
+    entry.offset = offset + consumed;
+    entry.length = length - consumed;
+    // Later records supersede the earlier ones
+    m_entries.insert(path, entry);
+    m_recordCount++;
+
+    *next = offset + length;
+    return true;
+}
+
+bool MetaDataStorePrivate::open_for_append()
+{
+    if (m_file.size() == 0) {
+        QDataStream header(&m_file);
+        header << fileMagic << fileVersion;
+        if (header.status() != QDataStream::Ok || !m_file.flush()) {
+            MH_WARNING("Cannot write metadata cache %s: %s",
+                       qUtf8Printable(m_filePath),
+                       qUtf8Printable(m_file.errorString()));
+            close();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool MetaDataStorePrivate::append_record(const QString &path,
+                                         const Entry &entry)
+{
+    if (!m_file.isOpen()) return false;
+
+    QByteArray payload;
+    {
+        QDataStream stream(&payload, QIODevice::WriteOnly);
+        stream.setVersion(streamVersion);
+        stream << path << entry.identity << entry.content_type <<
+            entry.metadata;
+    }
+
+    QByteArray record;
+    QDataStream(&record, QIODevice::WriteOnly) << quint32(payload.size());
+    record.append(payload);
+
+    if (!m_file.seek(m_file.size()) ||
+        m_file.write(record) != record.size() || !m_file.flush()) {
+        MH_WARNING("Cannot write metadata cache %s: %s",
+                   qUtf8Printable(m_filePath),
+                   qUtf8Printable(m_file.errorString()));
+        close();
+        return false;
+    }
+
+    m_recordCount++;
+    return true;
+}
+
+void MetaDataStorePrivate::compact()
+{
+    MH_DEBUG("Compacting metadata cache %s", qUtf8Printable(m_filePath));
+
+    QSaveFile file(m_filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        MH_WARNING("Cannot compact metadata cache %s: %s",
+                   qUtf8Printable(m_filePath),
+                   qUtf8Printable(file.errorString()));
+        return;
+    }
+
+    QDataStream header(&file);
+    header << fileMagic << fileVersion;
+    for (auto i = m_entries.begin(); i != m_entries.end(); i++) {
+        Entry entry = i.value();
+        entry.metadata = decode(entry);
+
+        QByteArray payload;
+        QDataStream stream(&payload, QIODevice::WriteOnly);
+        stream.setVersion(streamVersion);
+        stream << i.key() << entry.identity << entry.content_type <<
+            entry.metadata;
+        header << quint32(payload.size());
+        file.write(payload);
+    }
+
+    if (!file.commit()) {
+        MH_WARNING("Cannot compact metadata cache %s: %s",
+                   qUtf8Printable(m_filePath),
+                   qUtf8Printable(file.errorString()));
+        return;
+    }
+
+    // Reload the new file, so that the entries point to the new mapping
+    m_file.unmap(const_cast<uchar*>(m_map));
+    m_map = nullptr;
+    m_file.close();
+    m_entries.clear();
+    m_recordCount = 0;
+    load();
+}
+
+void MetaDataStorePrivate::close()
+{
+    if (m_map) {
+        m_file.unmap(const_cast<uchar*>(m_map));
+        m_map = nullptr;
+    }
+    m_file.close();
+
+    // Keep whatever we had in memory
+    for (auto i = m_entries.begin(); i != m_entries.end(); i++) {
+        Entry &entry = i.value();
+        if (entry.offset >= 0) {
+            entry.metadata = decode(entry);
+            entry.offset = -1;
+        }
+    }
+}
+
+QVariantMap MetaDataStorePrivate::decode(const Entry &entry) const
+{
+    if (entry.offset < 0 || !m_map) return entry.metadata;
+
+    QDataStream stream(QByteArray::fromRawData(
+        reinterpret_cast<const char*>(m_map + entry.offset), entry.length));
+    stream.setVersion(streamVersion);
+    QVariantMap metadata;
+    stream >> metadata;
+    return metadata;
+}
+
+MetaDataStorePrivate::Entry *MetaDataStorePrivate::valid_entry(
+        const QString &path)
+{
+    const auto i = m_entries.find(path);
+    if (i == m_entries.end()) return nullptr;
+
+    if (i.value().identity != FileIdentity::forPath(path)) {
+        // The file has changed, or is gone
+        m_entries.erase(i);
+        return nullptr;
+    }
+    return &i.value();
+}
+
+MetaDataStore::MetaDataStore(const QString &file_path):
+    d_ptr(new MetaDataStorePrivate(file_path))
+{
+    Q_D(MetaDataStore);
+    d->load();
+}
+
+MetaDataStore::~MetaDataStore() = default;
+
+QSharedPointer<MetaDataStore> MetaDataStore::instance()
+{
+    static QWeakPointer<MetaDataStore> weakRef;
+
+    QSharedPointer<MetaDataStore> store = weakRef.toStrongRef();
+    if (!store) {
+        const QString filePath =
+            qEnvironmentVariableIsSet("MEDIA_HUB_METADATA_CACHE") ?
+            qEnvironmentVariable("MEDIA_HUB_METADATA_CACHE") :
+            QStandardPaths::writableLocation(
+                QStandardPaths::GenericCacheLocation) +
+            QStringLiteral("/media-hub/metadata.cache");
+        store = QSharedPointer<MetaDataStore>::create(filePath);
+        weakRef = store;
+    }
+    return store;
+}
+
+QString MetaDataStore::file_path() const
+{
+    Q_D(const MetaDataStore);
+    return d->m_filePath;
+}
+
+int MetaDataStore::count() const
+{
+    Q_D(const MetaDataStore);
+    return d->m_entries.count();
+}
+
+bool MetaDataStore::lookup(const QUrl &uri, QVariantMap *metadata)
+{
+    Q_D(MetaDataStore);
+
+    if (!is_cacheable(uri)) return false;
+
+    const MetaDataStorePrivate::Entry *entry =
+        d->valid_entry(uri.toLocalFile());
+    if (!entry) return false;
+
+    *metadata = d->decode(*entry);
+    return true;
+}
+
+void MetaDataStore::store(const QUrl &uri, const QVariantMap &metadata)
+{
+    Q_D(MetaDataStore);
+
+    if (!is_cacheable(uri)) return;
+
+    const QString path = uri.toLocalFile();
+    MetaDataStorePrivate::Entry entry;
+    entry.identity = FileIdentity::forPath(path);
+    if (!entry.identity.isValid()) return;
+
+    // The content type is still valid if the file did not change
+    const auto i = d->m_entries.constFind(path);
+    if (i != d->m_entries.constEnd() && i.value().identity == entry.identity) {
+        entry.content_type = i.value().content_type;
+    }
+
+    entry.metadata = metadata;
+    d->append_record(path, entry);
+    d->m_entries.insert(path, entry);
+}
+
+bool MetaDataStore::lookup_content_type(const QUrl &uri, QString *content_type)
+{
+    Q_D(MetaDataStore);
+
+    if (!is_cacheable(uri)) return false;
+
+    const MetaDataStorePrivate::Entry *entry =
+        d->valid_entry(uri.toLocalFile());
+    if (!entry || entry->content_type.isEmpty()) return false;
+
+    *content_type = entry->content_type;
+    return true;
+}
+
+void MetaDataStore::store_content_type(const QUrl &uri,
+                                       const QString &content_type)
+{
+    Q_D(MetaDataStore);
+
+    if (!is_cacheable(uri)) return;
+
+    const QString path = uri.toLocalFile();
+    MetaDataStorePrivate::Entry *entry = d->valid_entry(path);
+    if (!entry || entry->content_type == content_type) return;
+
+    MetaDataStorePrivate::Entry updated;
+    updated.identity = entry->identity;
+    updated.content_type = content_type;
+    updated.metadata = d->decode(*entry);
+    d->append_record(path, updated);
+    *entry = updated;
+}
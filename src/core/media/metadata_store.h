@@ -0,0 +1,83 @@
+/*
+ * Copyright © 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CORE_UBUNTU_MEDIA_METADATA_STORE_H_
+#define CORE_UBUNTU_MEDIA_METADATA_STORE_H_
+
+#include <QScopedPointer>
+#include <QSharedPointer>
+#include <QString>
+#include <QUrl>
+#include <QVariantMap>
+
+namespace core
+{
+namespace ubuntu
+{
+namespace media
+{
+
+/*
+ * Persistent store of the metadata extracted from local files.
+ *
+ * Entries are keyed by the file path and remember the size, modification
+ * time and inode of the file they were extracted from: if any of these
+ * changes, the entry is considered stale and is ignored. Besides the
+ * metadata, an entry can also remember the content type of the file.
+ *
+ * The backing file is an append-only log of records, which is memory-mapped
+ * when loaded; only the record headers are parsed at startup, while the
+ * metadata itself is decoded on demand. Stale and superseded records are
+ * dropped by rewriting the file when they outnumber the valid ones.
+ */
+class MetaDataStorePrivate;
+class MetaDataStore
+{
+public:
+    /* If `file_path` is empty, the store only lives in memory */
+    MetaDataStore(const QString &file_path);
+    ~MetaDataStore();
+
+    /* Returns an instance shared by all the sessions, backed by a file in the
+     * user cache directory. The MEDIA_HUB_METADATA_CACHE environment variable
+     * can be used to override the file location; if set to an empty value,
+     * persistence is disabled. */
+    static QSharedPointer<MetaDataStore> instance();
+
+    static bool is_cacheable(const QUrl &uri) { return uri.isLocalFile(); }
+
+    QString file_path() const;
+    int count() const;
+
+    // Returns true and fills `metadata` if a valid entry exists for `uri`
+    bool lookup(const QUrl &uri, QVariantMap *metadata);
+    void store(const QUrl &uri, const QVariantMap &metadata);
+
+    /* The content type is only stored for files which already have an
+     * entry, that is whose metadata has been stored */
+    bool lookup_content_type(const QUrl &uri, QString *content_type);
+    void store_content_type(const QUrl &uri, const QString &content_type);
+
+private:
+    Q_DECLARE_PRIVATE(MetaDataStore)
+    QScopedPointer<MetaDataStorePrivate> d_ptr;
+};
+
+}
+}
+}
+
+#endif // CORE_UBUNTU_MEDIA_METADATA_STORE_H_
@@ -35,6 +35,13 @@ struct Service
         return s;
     }
 
+    // Each player session is exported under this path, followed by its key
+    static const QString &sessionsPath()
+    {
+        static const QString s{"/core/ubuntu/media/Service/sessions/"};
+        return s;
+    }
+
     struct Errors
     {
         struct CreatingSession
@@ -219,6 +226,13 @@ struct TrackList
         return s;
     }
 
+    // Appended to the object path of the session owning the track list
+    static const QString &pathSuffix()
+    {
+        static const QString s{"/TrackList"};
+        return s;
+    }
+
     struct Error
     {
         struct InsufficientPermissionsToAddTrack
@@ -155,7 +155,7 @@ public:
     double playbackRate() const { return m_player ? m_player->playbackRate() : 1.0; }
     void setShuffle(bool shuffle) { if (m_player) m_player->setShuffle(shuffle); }
     bool shuffle() const { return m_player ? m_player->shuffle() : false; }
-    QVariantMap metadata() const { return m_player ? m_player->metadataForCurrentTrack() : QVariantMap(); }
+    QVariantMap metadata() const { return m_player ? m_player->metadataForCurrentTrack().toMap() : QVariantMap(); }
     void setVolume(double volume) { if (m_player) m_player->setVolume(volume); }
     double volume() const { return m_player ? m_player->volume() : 1.0; }
     double minimumRate() const { return m_player ? m_player->minimumRate() : 1.0; }
@@ -21,6 +21,7 @@
 #include <QMap>
 #include <QMetaType>
 #include <QString>
+#include <QStringList>
 
 #include <cstdint>
 #include <stdexcept>
@@ -41,11 +42,31 @@ struct AVBackend
         mir
     };
 
+    /* What the platform offers, probed from the GStreamer registry the first
+     * time it's needed; it does not change during the lifetime of the
+     * process. */
+    struct Capabilities
+    {
+        Backend backend = none;
+        // The video sinks we know how to drive which are installed
+        QStringList video_sinks;
+        // The sink to use by default; empty if none is usable
+        QString default_video_sink;
+        // Whether hardware (androidmedia) decoders are available
+        bool hardware_decoding = false;
+        // Whether decoded frames can be streamed out of process
+        bool buffer_export = false;
+        // Whether scaletempo is available for pitch correction
+        bool pitch_correction = false;
+    };
+
+    static const Capabilities &capabilities();
+
     /**
      * @brief Returns the type of audio/video decoding/encoding backend being used.
      * @return Returns the current backend type.
      */
-    static Backend get_backend_type();
+    static Backend get_backend_type() { return capabilities().backend; }
 };
 
 class Player
@@ -127,6 +148,16 @@ public:
         rotate270
     };
 
+    /**
+     * Fast seeks land on the closest key frame, which is cheap but not
+     * exact; accurate seeks land exactly on the requested position.
+     */
+    enum SeekMode
+    {
+        fast,
+        accurate
+    };
+
     enum Lifetime
     {
         normal,
@@ -25,6 +25,7 @@
 #include "client_death_observer.h"
 #include "engine.h"
 #include "logging.h"
+#include "mpris.h"
 #include "track_list_implementation.h"
 #include "xesam.h"
 
@@ -205,12 +206,52 @@ public:
             // been called yet to load a media resource
             MH_INFO("Calling d->m_engine->open_resource_for_uri() for first track added only: %s",
                     qUtf8Printable(uri.toString()));
-            MH_INFO("\twith a Track::Id: %s", qUtf8Printable(id));
+            MH_INFO("\twith a Track::Id: %s", qUtf8Printable(id.toString()));
             static const bool do_pipeline_reset = true;
             m_engine->open_resource_for_uri(uri, do_pipeline_reset);
+            set_prerolling(true);
         }
     }
 
+    /* The metadata prefetch of the queued tracks competes with the playbin
+     * for I/O and CPU: hold it back until the playback has settled */
+    void set_prerolling(bool prerolling)
+    {
+        m_prerolling = prerolling;
+        // Don't wait forever if the engine never reports it
+        if (prerolling) {
+            m_prerollTimer.start();
+        } else {
+            m_prerollTimer.stop();
+        }
+        m_trackList->setPrefetchThrottled(m_prerolling || m_buffering);
+    }
+
+    void set_buffering(bool buffering)
+    {
+        m_buffering = buffering;
+        m_trackList->setPrefetchThrottled(m_prerolling || m_buffering);
+    }
+
+    /* Tells the engine which track to play after the current one, so that
+     * it can switch to it without any gap */
+    void prepare_next_track()
+    {
+        if (!m_gaplessPlayback)
+            return;
+
+        const media::Track::Id id = m_trackList->peek_next();
+        if (id == m_preparedTrack)
+            return;
+
+        m_preparedTrack = id;
+        const QUrl uri = id.isNull() ?
+            QUrl() : m_trackList->query_uri_for_track(id);
+        MH_DEBUG("Next track for gapless playback: %s",
+                 qUtf8Printable(uri.toString()));
+        m_engine->set_next_resource_for_uri(uri);
+    }
+
     void update_mpris_properties()
     {
         Q_Q(PlayerImplementation);
@@ -232,6 +273,8 @@ public:
         m_canGoPrevious = has_previous;
         m_canGoNext = has_next;
         Q_EMIT q->mprisPropertiesChanged();
+
+        prepare_next_track();
     }
 
     QUrl get_uri_for_album_artwork(const QUrl &uri,
@@ -268,16 +311,10 @@ public:
         media::Track::MetaData metadata{md};
         if (not metadata.isSet(media::Track::MetaData::TrackIdKey))
         {
-            const QString current_track = m_trackList->current();
-            if (not current_track.isEmpty())
-            {
-                const int last_slash = current_track.lastIndexOf('/');
-                const QStringRef track_id = current_track.midRef(last_slash + 1);
-                if (not track_id.isEmpty())
-                    metadata.setTrackId("/org/mpris/MediaPlayer2/Track/" + track_id);
-                else
-                    MH_WARNING("Failed to set MPRIS track id since the id value is NULL");
-            }
+            const media::Track::Id current_track = m_trackList->current();
+            if (not current_track.isNull())
+                metadata.setTrackId("/org/mpris/MediaPlayer2/Track/" +
+                                    QString::number(current_track.sequence()));
             else
                 MH_WARNING("Failed to set MPRIS track id since the id value is NULL");
         }
@@ -321,15 +358,22 @@ public:
     bool m_canGoPrevious = false;
     bool m_canGoNext = false;
     bool m_shuffle = false;
-    double m_playbackRate = 1.f;
     Player::LoopStatus m_loopStatus = Player::LoopStatus::none;
     int64_t m_position = 0;
     int64_t m_duration = 0;
     bool m_doingOpenUri = false;
+    bool m_gaplessPlayback = false;
+    // Set while the TrackList follows a gapless switch done by the engine
+    bool m_doingGaplessSwitch = false;
+    // Whether the pipeline is prerolling or buffering the current track
+    bool m_prerolling = false;
+    bool m_buffering = false;
+    media::Track::Id m_preparedTrack;
     Player::AudioStreamRole m_audioStreamRole = Player::AudioStreamRole::multimedia;
     Player::Lifetime m_lifetime = Player::Lifetime::normal;
     QTimer m_abandonTimer;
     QTimer m_wakeLockTimer;
+    QTimer m_prerollTimer;
     Track::MetaData m_metadataForCurrentTrack;
     media::PlayerImplementation *q_ptr;
 };
@@ -351,6 +395,8 @@ PlayerImplementationPrivate::PlayerImplementationPrivate(
     doing_abandon(false),
     q_ptr(q)
 {
+    m_trackList->setSession(m_client.key);
+
     // Poor man's logging of release/acquire events.
     QObject::connect(power_state_controller.data(),
                      &power::StateController::displayOnAcquired,
@@ -440,6 +486,23 @@ PlayerImplementationPrivate::PlayerImplementationPrivate(
         m_trackList->next();
     });
 
+    QObject::connect(m_engine.data(), &Engine::nextResourceStarted,
+                     q, [this](const QUrl &uri)
+    {
+        MH_INFO("Playback continued with %s", qUtf8Printable(uri.toString()));
+        /* If the list was edited after the engine queued the next URI, the
+         * pipeline is not playing the track which follows: advancing the
+         * list then opens the right one */
+        const bool prepared = !m_preparedTrack.isNull() &&
+            m_trackList->query_uri_for_track(m_preparedTrack) == uri;
+        if (!prepared)
+            MH_WARNING("Not the prepared track, switching to the next one");
+        // Otherwise, just advance the TrackList, the pipeline is already playing
+        m_doingGaplessSwitch = prepared;
+        m_trackList->next();
+        m_doingGaplessSwitch = false;
+    });
+
     QObject::connect(m_engine.data(), &Engine::clientDisconnected,
                      q, [this]()
     {
@@ -450,6 +513,14 @@ PlayerImplementationPrivate::PlayerImplementationPrivate(
                      q, &PlayerImplementation::seekedTo);
     QObject::connect(m_engine.data(), &Engine::bufferingChanged,
                      q, &PlayerImplementation::bufferingChanged);
+    QObject::connect(m_engine.data(), &Engine::bufferingChanged,
+                     q, [this](int percent) {
+        set_buffering(percent < 100);
+    });
+    QObject::connect(m_engine.data(), &Engine::playbackRateChanged,
+                     q, &PlayerImplementation::playbackRateChanged);
+    QObject::connect(m_engine.data(), &Engine::playbackRateRangeChanged,
+                     q, &PlayerImplementation::playbackRateRangeChanged);
     QObject::connect(m_engine.data(), &Engine::playbackStatusChanged,
                      q, &PlayerImplementation::playbackStatusChanged);
     QObject::connect(m_engine.data(), &Engine::aboutToFinish,
@@ -459,6 +530,18 @@ PlayerImplementationPrivate::PlayerImplementationPrivate(
     QObject::connect(m_engine.data(), &Engine::errorOccurred,
                      q, &PlayerImplementation::errorOccurred);
 
+    // The pipeline has prerolled, or it won't
+    QObject::connect(m_engine.data(), &Engine::playbackStatusChanged,
+                     q, [this]() {
+        const auto status = m_engine->playbackStatus();
+        if (status == Player::PlaybackStatus::paused ||
+            status == Player::PlaybackStatus::playing) {
+            set_prerolling(false);
+        }
+    });
+    QObject::connect(m_engine.data(), &Engine::errorOccurred,
+                     q, [this]() { set_prerolling(false); });
+
     QObject::connect(m_trackList.data(), &TrackListImplementation::endOfTrackList,
                      q, [this]()
     {
@@ -472,6 +555,15 @@ PlayerImplementationPrivate::PlayerImplementationPrivate(
     QObject::connect(m_trackList.data(), &TrackListImplementation::onGoToTrack,
                      q, [this](const media::Track::Id &id)
     {
+        if (m_doingGaplessSwitch && id == m_preparedTrack)
+        {
+            /* The engine is already playing this track; make sure the next
+             * one gets prepared even if it is the same (looping) */
+            m_preparedTrack.clear();
+            prepare_next_track();
+            return;
+        }
+
         // Store whether we should restore the current playing state after loading the new uri
         const bool auto_play = m_engine->playbackStatus() == media::Player::playing;
 
@@ -480,9 +572,10 @@ PlayerImplementationPrivate::PlayerImplementationPrivate(
         {
             MH_INFO("Setting next track on playbin (on_go_to_track signal): %s",
                     qUtf8Printable(uri.toString()));
-            MH_INFO("\twith a Track::Id: %s", qUtf8Printable(id));
+            MH_INFO("\twith a Track::Id: %s", qUtf8Printable(id.toString()));
             static const bool do_pipeline_reset = true;
             m_engine->open_resource_for_uri(uri, do_pipeline_reset);
+            set_prerolling(true);
         }
 
         if (auto_play)
@@ -503,17 +596,14 @@ PlayerImplementationPrivate::PlayerImplementationPrivate(
     });
 
     QObject::connect(m_trackList.data(), &TrackListImplementation::tracksAdded,
-                     q, [this](const QVector<QUrl> &tracks)
+                     q, [this](const QVector<media::Track::Id> &tracks)
     {
         MH_TRACE("** Track was added, handling in PlayerImplementation");
         // If the two sizes are the same, that means the TrackList was previously empty and we need
         // to open the first track in the TrackList so that is_audio_source() and is_video_source()
         // will function correctly.
-        /* FIXME: we are passing a URL to a method expecting a track ID, so
-         * this will not work; on the other hand, the code has always been like
-         * this, so let's fix it later. */
         if (not tracks.isEmpty() and m_trackList->tracks().count() == tracks.count())
-            open_first_track_from_tracklist(tracks.front().toString());
+            open_first_track_from_tracklist(m_trackList->tracks().first());
 
         update_mpris_properties();
     });
@@ -522,6 +612,10 @@ PlayerImplementationPrivate::PlayerImplementationPrivate(
                      &TrackListImplementation::trackRemoved,
                      q, [this]() { update_mpris_properties(); });
 
+    QObject::connect(m_trackList.data(),
+                     &TrackListImplementation::trackMoved,
+                     q, [this]() { update_mpris_properties(); });
+
     QObject::connect(m_trackList.data(),
                      &TrackListImplementation::trackListReset,
                      q, [this]() { update_mpris_properties(); });
@@ -562,6 +656,13 @@ PlayerImplementationPrivate::PlayerImplementationPrivate(
     m_wakeLockTimer.callOnTimeout(q, [this]() {
         clear_wakelocks();
     });
+
+    m_prerollTimer.setSingleShot(true);
+    m_prerollTimer.setInterval(5000);
+    m_prerollTimer.callOnTimeout(q, [this]() { set_prerolling(false); });
+
+    m_gaplessPlayback =
+        qEnvironmentVariableIntValue("MEDIA_HUB_GAPLESS_PLAYBACK") != 0;
 }
 
 PlayerImplementationPrivate::~PlayerImplementationPrivate()
@@ -579,7 +680,7 @@ PlayerImplementation::PlayerImplementation(const Configuration &config,
     QObject::connect(this, &QObject::objectNameChanged,
                      this, [this](const QString &name) {
         Q_D(PlayerImplementation);
-        d->m_trackList->setObjectName(name + "/TrackList");
+        d->m_trackList->setObjectName(name + mpris::TrackList::pathSuffix());
     });
 }
 
@@ -630,23 +731,29 @@ bool PlayerImplementation::canGoNext() const
 
 void PlayerImplementation::setPlaybackRate(double rate)
 {
-    Q_UNUSED(rate);
-    MH_WARNING("Setting playback rate not implemented");
+    Q_D(PlayerImplementation);
+    if (!d->m_engine->setPlaybackRate(rate)) {
+        MH_WARNING("Playback rate %f not supported (range is %f - %f)",
+                   rate, minimumRate(), maximumRate());
+    }
 }
 
 double PlayerImplementation::playbackRate() const
 {
-    return 1.0;
+    Q_D(const PlayerImplementation);
+    return d->m_engine->playbackRate();
 }
 
 double PlayerImplementation::minimumRate() const
 {
-    return 1.0;
+    Q_D(const PlayerImplementation);
+    return d->m_engine->minimumPlaybackRate();
 }
 
 double PlayerImplementation::maximumRate() const
 {
-    return 1.0;
+    Q_D(const PlayerImplementation);
+    return d->m_engine->maximumPlaybackRate();
 }
 
 void PlayerImplementation::setLoopStatus(Player::LoopStatus status)
@@ -654,6 +761,7 @@ void PlayerImplementation::setLoopStatus(Player::LoopStatus status)
     Q_D(PlayerImplementation);
     MH_INFO() << "LoopStatus:" << status;
     d->m_trackList->setLoopStatus(status);
+    d->prepare_next_track();
 }
 
 Player::LoopStatus PlayerImplementation::loopStatus() const
@@ -666,6 +774,7 @@ void PlayerImplementation::setShuffle(bool shuffle)
 {
     Q_D(PlayerImplementation);
     d->m_trackList->setShuffle(shuffle);
+    d->prepare_next_track();
 }
 
 bool PlayerImplementation::shuffle() const
@@ -810,6 +919,7 @@ bool PlayerImplementation::open_uri(const QUrl &uri, const Headers &headers)
     }
 
     const bool ret = d->m_engine->open_resource_for_uri(uri, headers);
+    d->set_prerolling(true);
     // Don't set new track as the current track to play since we're calling open_resource_for_uri above
     static const bool make_current = false;
     d->m_trackList->add_track_with_uri_at(uri, TrackListImplementation::afterEmptyTrack(), make_current);
@@ -856,8 +966,9 @@ void PlayerImplementation::stop()
     d->m_engine->stop();
 }
 
-void PlayerImplementation::seek_to(const std::chrono::microseconds& ms)
+void PlayerImplementation::seek_to(const std::chrono::microseconds& ms,
+                                   Player::SeekMode mode)
 {
     Q_D(PlayerImplementation);
-    d->m_engine->seek_to(ms);
+    d->m_engine->seek_to(ms, mode);
 }
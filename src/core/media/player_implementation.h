@@ -115,7 +115,8 @@ public:
     void play();
     void pause();
     void stop();
-    void seek_to(const std::chrono::microseconds& offset);
+    void seek_to(const std::chrono::microseconds& offset,
+                 Player::SeekMode mode = Player::SeekMode::fast);
 
 Q_SIGNALS:
     void isVideoSourceChanged();
@@ -127,6 +128,8 @@ Q_SIGNALS:
     void durationChanged();
     void volumeChanged();
     void playbackStatusChanged();
+    void playbackRateChanged();
+    void playbackRateRangeChanged();
 
     void orientationChanged();
     void videoDimensionChanged();
@@ -32,10 +32,14 @@
 
 #include <QDBusArgument>
 #include <QDBusMessage>
+#include <QDBusServiceWatcher>
 #include <QDateTime>
+#include <QHash>
 #include <QMetaEnum>
 #include <QTimer>
 
+#include <time.h>
+
 using namespace core::ubuntu::media;
 
 namespace core {
@@ -55,6 +59,11 @@ public:
 
     void openUri(const QDBusMessage &in, const QDBusConnection &bus,
                  OpenUriCall callType);
+    void emitPositionAnchor();
+    void updatePositionTimer();
+    // Returns whether `client` was not subscribed before
+    bool setPositionSubscription(const QString &client, qint32 interval);
+    void updatePositionUpdateInterval();
 
 private:
     friend class PlayerSkeleton;
@@ -66,6 +75,12 @@ private:
     QTimer m_bufferingTimer;
     QDateTime m_bufferingLastEmission;
     int m_bufferingValue;
+    // The shortest interval requested by the subscribed clients
+    qint32 m_positionUpdateInterval;
+    // Intervals requested by each client, by D-Bus name
+    QHash<QString, qint32> m_positionSubscribers;
+    QDBusServiceWatcher m_subscriberWatcher;
+    QTimer m_positionTimer;
     PlayerSkeleton *q_ptr;
 };
 
@@ -78,6 +93,7 @@ PlayerSkeletonPrivate::PlayerSkeletonPrivate(
     m_connection(conf.connection),
     request_context_resolver{conf.request_context_resolver},
     request_authenticator{conf.request_authenticator},
+    m_positionUpdateInterval(-1),
     q_ptr(q)
 {
     auto impl = m_player;
@@ -131,6 +147,32 @@ PlayerSkeletonPrivate::PlayerSkeletonPrivate(
 
     QObject::connect(impl, &PlayerImplementation::volumeChanged,
                      q, &PlayerSkeleton::volumeChanged);
+    QObject::connect(impl, &PlayerImplementation::playbackRateChanged,
+                     q, &PlayerSkeleton::playbackRateChanged);
+    QObject::connect(impl, &PlayerImplementation::playbackRateRangeChanged,
+                     q, &PlayerSkeleton::playbackRateRangeChanged);
+
+    /* Position anchors: emitted whenever the position stops progressing
+     * linearly, and then periodically to correct the clients' drift */
+    QObject::connect(impl, &PlayerImplementation::playbackStatusChanged,
+                     q, [this]() {
+        updatePositionTimer();
+        emitPositionAnchor();
+    });
+    QObject::connect(impl, &PlayerImplementation::seekedTo,
+                     q, [this]() { emitPositionAnchor(); });
+    QObject::connect(impl, &PlayerImplementation::playbackRateChanged,
+                     q, [this]() { emitPositionAnchor(); });
+    QObject::connect(impl, &PlayerImplementation::metadataForCurrentTrackChanged,
+                     q, [this]() { emitPositionAnchor(); });
+    m_positionTimer.callOnTimeout(q, [this]() { emitPositionAnchor(); });
+    m_subscriberWatcher.setConnection(m_connection);
+    m_subscriberWatcher.setWatchMode(QDBusServiceWatcher::WatchForUnregistration);
+    QObject::connect(&m_subscriberWatcher,
+                     &QDBusServiceWatcher::serviceUnregistered,
+                     q, [this](const QString &client) {
+        setPositionSubscription(client, -1);
+    });
 
     /* Property signals */
     QObject::connect(impl, &PlayerImplementation::mprisPropertiesChanged,
@@ -211,6 +253,66 @@ void PlayerSkeletonPrivate::openUri(const QDBusMessage &in,
     });
 }
 
+void PlayerSkeletonPrivate::emitPositionAnchor()
+{
+    if (m_positionUpdateInterval < 0) return;
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    const qint64 timestamp = qint64(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+    const double rate =
+        m_player->playbackStatus() == Player::PlaybackStatus::playing ?
+        m_player->playbackRate() : 0.0;
+    Q_EMIT q_ptr->PositionAnchor(m_player->position(), timestamp, rate);
+}
+
+bool PlayerSkeletonPrivate::setPositionSubscription(const QString &client,
+                                                    qint32 interval)
+{
+    const bool wasSubscribed = m_positionSubscribers.contains(client);
+    if (interval < 0) {
+        m_positionSubscribers.remove(client);
+        if (!client.isEmpty()) m_subscriberWatcher.removeWatchedService(client);
+    } else {
+        m_positionSubscribers.insert(client, interval);
+        if (!wasSubscribed && !client.isEmpty()) {
+            m_subscriberWatcher.addWatchedService(client);
+        }
+    }
+    updatePositionUpdateInterval();
+    return !wasSubscribed;
+}
+
+void PlayerSkeletonPrivate::updatePositionUpdateInterval()
+{
+    /* Every client must get the anchors at least as often as it asked:
+     * positive intervals win over 0 */
+    qint32 interval = -1;
+    for (const qint32 requested: qAsConst(m_positionSubscribers)) {
+        if (interval <= 0) {
+            interval = qMax(interval, requested);
+        } else if (requested > 0) {
+            interval = qMin(interval, requested);
+        }
+    }
+
+    m_positionUpdateInterval = interval;
+    if (interval > 0) m_positionTimer.setInterval(interval);
+    updatePositionTimer();
+}
+
+void PlayerSkeletonPrivate::updatePositionTimer()
+{
+    /* While not playing, the position does not change and the last anchor
+     * remains valid */
+    if (m_positionUpdateInterval > 0 &&
+        m_player->playbackStatus() == Player::PlaybackStatus::playing) {
+        if (!m_positionTimer.isActive()) m_positionTimer.start();
+    } else {
+        m_positionTimer.stop();
+    }
+}
+
 PlayerSkeleton::PlayerSkeleton(const Configuration& configuration,
                                QObject *parent):
     QObject(parent),
@@ -342,7 +444,7 @@ bool PlayerSkeleton::shuffle() const
 
 QVariantMap PlayerSkeleton::metadata() const
 {
-    return player()->metadataForCurrentTrack();
+    return player()->metadataForCurrentTrack().toMap();
 }
 
 void PlayerSkeleton::setVolume(double volume)
@@ -370,6 +472,31 @@ qint64 PlayerSkeleton::position() const
     return player()->position();
 }
 
+void PlayerSkeleton::setPositionUpdateInterval(qint32 interval)
+{
+    Q_D(PlayerSkeleton);
+
+    /* Negative values disable the anchors; 0 means that they are only
+     * emitted when the playback state changes. Positive values are
+     * clamped, to avoid flooding the bus. Each client of the session has
+     * its own setting. */
+    if (interval > 0) interval = qMax(interval, 10);
+    const QString client = calledFromDBus() ? message().service() : QString();
+    const bool subscribed = d->setPositionSubscription(client, interval);
+    // Give the client a starting point right away
+    if (subscribed && interval >= 0) d->emitPositionAnchor();
+}
+
+qint32 PlayerSkeleton::positionUpdateInterval() const
+{
+    Q_D(const PlayerSkeleton);
+    // Clients read back their own setting
+    if (calledFromDBus()) {
+        return d->m_positionSubscribers.value(message().service(), -1);
+    }
+    return d->m_positionUpdateInterval;
+}
+
 qint64 PlayerSkeleton::duration() const
 {
     return player()->duration();
@@ -453,6 +580,17 @@ void PlayerSkeleton::Seek(quint64 microSeconds)
     player()->seek_to(std::chrono::microseconds(microSeconds));
 }
 
+void PlayerSkeleton::SeekWithMode(quint64 microSeconds, qint16 mode)
+{
+    if (mode != Player::SeekMode::fast && mode != Player::SeekMode::accurate) {
+        sendErrorReply(QDBusError::InvalidArgs,
+                       QStringLiteral("Invalid seek mode %1").arg(mode));
+        return;
+    }
+    player()->seek_to(std::chrono::microseconds(microSeconds),
+                      static_cast<Player::SeekMode>(mode));
+}
+
 void PlayerSkeleton::SetPosition(const QDBusObjectPath &, quint64)
 {
     // TODO: implement (this was never implemented in media-hub)
@@ -61,13 +61,18 @@ class PlayerSkeleton: public QObject, protected QDBusContext
     Q_PROPERTY(QString PlaybackStatus READ playbackStatus
                NOTIFY PlaybackStatusChanged)
     Q_PROPERTY(QString LoopStatus READ loopStatus WRITE setLoopStatus)
-    Q_PROPERTY(double PlaybackRate READ playbackRate WRITE setPlaybackRate)
+    Q_PROPERTY(double PlaybackRate READ playbackRate WRITE setPlaybackRate
+               NOTIFY playbackRateChanged)
     Q_PROPERTY(bool Shuffle READ shuffle WRITE setShuffle)
     Q_PROPERTY(QVariantMap Metadata READ metadata NOTIFY metadataChanged)
     Q_PROPERTY(double Volume READ volume WRITE setVolume NOTIFY volumeChanged)
-    Q_PROPERTY(double MinimumRate READ minimumRate)
-    Q_PROPERTY(double MaximumRate READ maximumRate)
+    Q_PROPERTY(double MinimumRate READ minimumRate
+               NOTIFY playbackRateRangeChanged)
+    Q_PROPERTY(double MaximumRate READ maximumRate
+               NOTIFY playbackRateRangeChanged)
     Q_PROPERTY(qint64 Position READ position)
+    Q_PROPERTY(qint32 PositionUpdateInterval READ positionUpdateInterval
+               WRITE setPositionUpdateInterval)
     Q_PROPERTY(qint64 Duration READ duration)
     Q_PROPERTY(qint16 TypedBackend READ backend)
     Q_PROPERTY(qint16 Orientation READ orientation NOTIFY orientationChanged)
@@ -127,6 +132,8 @@ public:
     double minimumRate() const;
     double maximumRate() const;
     qint64 position() const;
+    void setPositionUpdateInterval(qint32 interval);
+    qint32 positionUpdateInterval() const;
     qint64 duration() const;
     qint16 backend() const;
     qint16 orientation() const;
@@ -142,6 +149,8 @@ public Q_SLOTS:
     void Stop();
     void Play();
     void Seek(quint64 microSeconds);
+    // `mode` is a Player::SeekMode; Seek() is equivalent to the fast mode
+    void SeekWithMode(quint64 microSeconds, qint16 mode);
     void SetPosition(const QDBusObjectPath &trackObject,
                      quint64 microSeconds);
     void CreateVideoSink(quint32 textureId);
@@ -159,6 +168,12 @@ Q_SIGNALS:
     Q_SCRIPTABLE void VideoDimensionChanged(quint32 height, quint32 width);
     Q_SCRIPTABLE void Error(qint16 code);
     Q_SCRIPTABLE void Buffering(int percent); // TODO: set a fixed type
+    /* Emitted only if PositionUpdateInterval is not negative: the position
+     * at any later time can be computed as
+     *   position + (now - timestamp) * rate
+     * where the timestamps are taken from CLOCK_MONOTONIC, in nanoseconds. */
+    Q_SCRIPTABLE void PositionAnchor(qint64 position, qint64 timestamp,
+                                     double rate);
 
     void canPlayChanged();
     void canPauseChanged();
@@ -168,6 +183,8 @@ Q_SIGNALS:
     void isAudioSourceChanged();
     void metadataChanged();
     void volumeChanged();
+    void playbackRateChanged();
+    void playbackRateRangeChanged();
     void orientationChanged();
 
 private:
@@ -25,6 +25,7 @@
 #include "apparmor/ubuntu.h"
 #include "audio/output_observer.h"
 #include "client_death_observer.h"
+#include "gstreamer/playbin_pool.h"
 #include "logging.h"
 #include "player_implementation.h"
 #include "power/battery_observer.h"
@@ -74,6 +75,8 @@ private:
     media::power::BatteryObserver battery_observer;
     media::power::StateController::Ptr power_state_controller;
     media::ClientDeathObserver::Ptr client_death_observer;
+    // Keeps pipelines ready for new sessions
+    QSharedPointer<gstreamer::PlaybinPool> playbin_pool;
     media::RecorderObserver recorder_observer;
     media::audio::OutputObserver audio_output_observer;
     media::audio::OutputState audio_output_state;
@@ -94,6 +97,7 @@ ServiceImplementationPrivate::ServiceImplementationPrivate(
     resume_key(Player::invalidKey),
     power_state_controller(media::power::StateController::instance()),
     client_death_observer(ClientDeathObserver::Ptr::create()),
+    playbin_pool(gstreamer::PlaybinPool::instance()),
     audio_output_state(media::audio::OutputState::Speaker),
     m_currentPlayer(Player::invalidKey),
     q_ptr(q)
@@ -138,7 +138,7 @@ void ServiceSkeletonPrivate::onCurrentPlayerChanged()
 
 QString ServiceSkeletonPrivate::pathForPlayer(Player::PlayerKey key) const
 {
-    return "/core/ubuntu/media/Service/sessions/" + QString::number(key);
+    return mpris::Service::sessionsPath() + QString::number(key);
 }
 
 void ServiceSkeletonPrivate::exportPlayer(const SessionInfo &info)
@@ -18,6 +18,8 @@
 #ifndef CORE_UBUNTU_MEDIA_TRACK_H_
 #define CORE_UBUNTU_MEDIA_TRACK_H_
 
+#include <QHash>
+#include <QMetaType>
 #include <QString>
 #include <QScopedPointer>
 #include <QUrl>
@@ -33,21 +35,69 @@ namespace media
 class Track
 {
 public:
-    typedef QString Id;
-    typedef QVariantMap MetaDataType;
+    /* Identifies a track within the track list of a player session. IDs
+     * are compared and hashed as a pair of integers; the D-Bus object path
+     * is only built when the ID is serialized, with toString(). */
+    class Id
+    {
+    public:
+        Id(): m_session(NoSession), m_sequence(0) {}
+        Id(quint32 session, quint32 sequence):
+            m_session(session), m_sequence(sequence) {}
+
+        // The ID which MPRIS clients use to add tracks at the beginning
+        static Id noTrack() { return Id(NoSession, 1); }
+
+        // Returns a null ID if `path` is not a track object path
+        static Id fromString(const QString &path);
+        QString toString() const;
+
+        bool isNull() const { return *this == Id(); }
+        void clear() { *this = Id(); }
+
+        quint32 session() const { return m_session; }
+        quint32 sequence() const { return m_sequence; }
+
+        bool operator==(const Id &other) const {
+            return m_session == other.m_session &&
+                m_sequence == other.m_sequence;
+        }
+        bool operator!=(const Id &other) const { return !(*this == other); }
+        bool operator<(const Id &other) const {
+            return m_session < other.m_session ||
+                (m_session == other.m_session &&
+                 m_sequence < other.m_sequence);
+        }
+
+    private:
+        // Same value as Player::invalidKey, which is never a session
+        static const quint32 NoSession = 0xffffffff;
+
+        quint32 m_session;
+        quint32 m_sequence;
+    };
 
-    class MetaData: public MetaDataType
+    /* Compact record of the track metadata: the common xesam/MPRIS fields
+     * have their own typed slots, while the rare tags end up in an overflow
+     * map. Artist, album and genre names are interned, so that tracks from
+     * the same album share them. The QVariantMap representation is only
+     * built for D-Bus, with toMap(). */
+    class MetaData
     {
     public:
-        using MetaDataType::MetaDataType;
         static constexpr const char* TrackArtlUrlKey = "mpris:artUrl";
         static constexpr const char* TrackLengthKey = "mpris:length";
         static constexpr const char* TrackIdKey = "mpris:trackid";
 
+        MetaData();
+
+        static MetaData fromMap(const QVariantMap &map);
+        QVariantMap toMap() const;
+
         template<typename Tag>
         bool contains() const
         {
-            return contains(Tag::name());
+            return contains(Tag::name);
         }
 
         bool isSet(const QString &key) const
@@ -55,6 +105,18 @@ public:
             return !value(key).isNull();
         }
 
+        bool isEmpty() const;
+        bool contains(const QString &key) const;
+        QVariant value(const QString &key) const;
+        void insert(const QString &key, const QVariant &value);
+        void remove(const QString &key);
+        void clear();
+
+        bool operator==(const MetaData &other) const;
+        bool operator!=(const MetaData &other) const {
+            return !(*this == other);
+        }
+
         void setAlbum(const QString &album);
         void setArtist(const QString &artist);
         void setTitle(const QString &title);
@@ -69,6 +131,41 @@ public:
         int64_t trackLength() const;
         QUrl artUrl() const;
         QString lastUsed() const;
+
+    private:
+        enum Field {
+            // String fields
+            Title = 0,
+            Album,
+            Artist,
+            AlbumArtist,
+            Genre,
+            TrackId,
+            ArtUrl,
+            LastUsed,
+            StringFieldCount,
+            // Other fields, whose presence is tracked in m_flags
+            Length = StringFieldCount,
+            TrackNumber,
+            DiscNumber,
+            Image,
+            PreviewImage,
+            FieldCount,
+        };
+
+        static int fieldFor(const QString &key);
+        bool hasField(int field) const { return m_flags & (1 << field); }
+        // Returns false if the value has not the type of the field
+        bool setField(int field, const QVariant &value);
+        void clearField(int field);
+        QVariant fieldValue(int field) const;
+
+        QString m_strings[StringFieldCount];
+        qint64 m_length;
+        quint32 m_trackNumber;
+        quint32 m_discNumber;
+        quint16 m_flags;
+        QVariantMap m_extra;
     };
 
     Track(const Id& id);
@@ -86,8 +183,15 @@ private:
     QScopedPointer<Private> d;
 };
 
+inline uint qHash(const Track::Id &id, uint seed = 0)
+{
+    return ::qHash((quint64(id.session()) << 32) | id.sequence(), seed);
+}
+
 }
 }
 }
 
+Q_DECLARE_METATYPE(core::ubuntu::media::Track::Id)
+
 #endif // CORE_UBUNTU_MEDIA_TRACK_H_
@@ -0,0 +1,64 @@
+/*
+ * Copyright © 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "track.h"
+
+#include "mpris.h"
+
+#include <QVector>
+
+namespace media = core::ubuntu::media;
+
+using namespace media;
+
+namespace {
+
+// Tracks live under the object path of their session's track list
+const QString &sessionsPrefix = mpris::Service::sessionsPath();
+const QString trackListPath = mpris::TrackList::pathSuffix() + '/';
+const QString noTrackPath =
+    QStringLiteral("/org/mpris/MediaPlayer2/TrackList/NoTrack");
+
+} // namespace
+
+Track::Id Track::Id::fromString(const QString &path)
+{
+    if (path == noTrackPath) return noTrack();
+    if (!path.startsWith(sessionsPrefix)) return Id();
+
+    const QVector<QStringRef> parts =
+        path.midRef(sessionsPrefix.length()).split('/');
+    if (parts.count() != 3) return Id();
+
+    bool sessionOk, sequenceOk;
+    const quint32 session = parts[0].toUInt(&sessionOk);
+    const quint32 sequence = parts[2].toUInt(&sequenceOk);
+    if (!sessionOk || !sequenceOk || session == NoSession) return Id();
+
+    // Only accept the canonical form, which toString() gives back
+    const Id id(session, sequence);
+    return id.toString() == path ? id : Id();
+}
+
+QString Track::Id::toString() const
+{
+    if (m_session == NoSession) {
+        return m_sequence == noTrack().m_sequence ? noTrackPath : QString();
+    }
+
+    return sessionsPrefix + QString::number(m_session) + trackListPath +
+        QString::number(m_sequence);
+}
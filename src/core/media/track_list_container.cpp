@@ -0,0 +1,305 @@
+/*
+ * Copyright © 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "track_list_container.h"
+
+#include <QtGlobal>
+
+namespace media = core::ubuntu::media;
+
+using namespace media;
+using namespace media::TrackList;
+
+struct Container::Node
+{
+    Node(const Track::Id &id, quint32 priority):
+        id(id),
+        priority(priority),
+        size(1),
+        left(nullptr),
+        right(nullptr),
+        parent(nullptr)
+    {
+    }
+
+    Track::Id id;
+    quint32 priority;
+    int size;
+    Node *left;
+    Node *right;
+    Node *parent;
+};
+
+namespace {
+
+typedef Container::ConstIterator ConstIterator;
+
+template <class N>
+int sizeOf(const N *node)
+{
+    return node ? node->size : 0;
+}
+
+template <class N>
+void update(N *node)
+{
+    node->size = 1 + sizeOf(node->left) + sizeOf(node->right);
+    if (node->left) node->left->parent = node;
+    if (node->right) node->right->parent = node;
+}
+
+/* Splits the tree rooted in `node` so that the first `count` elements end up
+ * in `*left` and the remaining ones in `*right`. */
+template <class N>
+void split(N *node, int count, N **left, N **right)
+{
+    if (!node) {
+        *left = *right = nullptr;
+        return;
+    }
+
+    if (sizeOf(node->left) < count) {
+        split(node->right, count - sizeOf(node->left) - 1,
+              &node->right, right);
+        update(node);
+        *left = node;
+    } else {
+        split(node->left, count, left, &node->left);
+        update(node);
+        *right = node;
+    }
+}
+
+template <class N>
+N *merge(N *left, N *right)
+{
+    if (!left) return right;
+    if (!right) return left;
+
+    if (left->priority > right->priority) {
+        left->right = merge(left->right, right);
+        update(left);
+        return left;
+    } else {
+        right->left = merge(left, right->left);
+        update(right);
+        return right;
+    }
+}
+
+} // namespace
+
+const Track::Id &ConstIterator::operator*() const
+{
+    Q_ASSERT(m_node);
+    return m_node->id;
+}
+
+ConstIterator &ConstIterator::operator++()
+{
+    const Node *n = m_node;
+    if (!n) return *this;
+
+    if (n->right) {
+        n = n->right;
+        while (n->left) n = n->left;
+    } else {
+        while (n->parent && n == n->parent->right) n = n->parent;
+        n = n->parent;
+    }
+    m_node = n;
+    return *this;
+}
+
+ConstIterator &ConstIterator::operator--()
+{
+    const Node *n = m_node;
+    if (!n) {
+        // Decrementing end() yields the last element
+        n = m_container->m_root;
+        while (n && n->right) n = n->right;
+    } else if (n->left) {
+        n = n->left;
+        while (n->right) n = n->right;
+    } else {
+        while (n->parent && n == n->parent->left) n = n->parent;
+        n = n->parent;
+    }
+    m_node = n;
+    return *this;
+}
+
+Container::Container():
+    m_root(nullptr)
+{
+}
+
+Container::Container(const QVector<Track::Id> &ids):
+    Container()
+{
+    for (const Track::Id &id: ids) {
+        append(id);
+    }
+}
+
+Container::Container(const Container &other):
+    Container()
+{
+    for (const Track::Id &id: other) {
+        append(id);
+    }
+}
+
+Container::~Container()
+{
+    clear();
+}
+
+Container &Container::operator=(const Container &other)
+{
+    if (&other == this) return *this;
+
+    clear();
+    for (const Track::Id &id: other) {
+        append(id);
+    }
+    return *this;
+}
+
+int Container::indexOf(const Track::Id &id) const
+{
+    const Node *node = m_index.value(id, nullptr);
+    if (!node) return -1;
+
+    int index = sizeOf(node->left);
+    for (; node->parent; node = node->parent) {
+        if (node == node->parent->right) {
+            index += sizeOf(node->parent->left) + 1;
+        }
+    }
+    return index;
+}
+
+const Track::Id &Container::at(int index) const
+{
+    const Node *node = nodeAt(index);
+    Q_ASSERT(node);
+    return node->id;
+}
+
+Container::Node *Container::nodeAt(int index) const
+{
+    if (index < 0 || index >= count()) return nullptr;
+
+    Node *node = m_root;
+    while (node) {
+        const int leftSize = sizeOf(node->left);
+        if (index < leftSize) {
+            node = node->left;
+        } else if (index == leftSize) {
+            break;
+        } else {
+            index -= leftSize + 1;
+            node = node->right;
+        }
+    }
+    return node;
+}
+
+void Container::insert(int index, const Track::Id &id)
+{
+    Q_ASSERT(!m_index.contains(id));
+    Node *node = new Node(id, m_random.generate());
+    m_index.insert(id, node);
+    attach(qBound(0, index, count() - 1), node);
+}
+
+bool Container::remove(const Track::Id &id)
+{
+    Node *node = m_index.take(id);
+    if (!node) return false;
+
+    detach(node);
+    delete node;
+    return true;
+}
+
+void Container::move(int from, int to)
+{
+    if (from == to) return;
+
+    Node *node = nodeAt(from);
+    if (!node) return;
+
+    detach(node);
+    attach(qBound(0, to, count() - 1), node);
+}
+
+void Container::clear()
+{
+    qDeleteAll(m_index);
+    m_index.clear();
+    m_root = nullptr;
+}
+
+QVector<Track::Id> Container::toVector() const
+{
+    QVector<Track::Id> ret;
+    ret.reserve(count());
+    for (const Track::Id &id: *this) {
+        ret.append(id);
+    }
+    return ret;
+}
+
+ConstIterator Container::begin() const
+{
+    const Node *node = m_root;
+    while (node && node->left) node = node->left;
+    return ConstIterator(this, node);
+}
+
+/* Note: this is invoked when `node` is already accounted for in count(),
+ * so the valid positions range from 0 to count() - 1. */
+void Container::attach(int index, Node *node)
+{
+    Node *left, *right;
+    split(m_root, index, &left, &right);
+    m_root = merge(merge(left, node), right);
+    m_root->parent = nullptr;
+}
+
+void Container::detach(Node *node)
+{
+    Node *parent = node->parent;
+    Node *child = merge(node->left, node->right);
+    if (child) child->parent = parent;
+
+    if (!parent) {
+        m_root = child;
+    } else if (parent->left == node) {
+        parent->left = child;
+    } else {
+        parent->right = child;
+    }
+
+    for (Node *n = parent; n; n = n->parent) {
+        n->size--;
+    }
+
+    node->left = node->right = node->parent = nullptr;
+    node->size = 1;
+}
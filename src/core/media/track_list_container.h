@@ -0,0 +1,134 @@
+/*
+ * Copyright © 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CORE_UBUNTU_MEDIA_TRACK_LIST_CONTAINER_H_
+#define CORE_UBUNTU_MEDIA_TRACK_LIST_CONTAINER_H_
+
+#include "track.h"
+
+#include <QHash>
+#include <QRandomGenerator>
+#include <QVector>
+
+#include <iterator>
+
+namespace core
+{
+namespace ubuntu
+{
+namespace media
+{
+namespace TrackList
+{
+
+/*
+ * Ordered list of track IDs, indexed both by position and by ID.
+ *
+ * The tracks are stored in an implicit treap (a randomized balanced binary
+ * tree ordered by position, where each node knows the size of its subtree),
+ * and a hash maps each ID to its tree node. This gives O(1) membership tests
+ * and O(log n) positional lookup, insertion, removal and moves, which keeps
+ * queue editing fast even on very large playlists.
+ *
+ * Track IDs must be unique within a container.
+ */
+class Container
+{
+    struct Node;
+
+public:
+    class ConstIterator
+    {
+    public:
+        typedef std::bidirectional_iterator_tag iterator_category;
+        typedef Track::Id value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const Track::Id *pointer;
+        typedef const Track::Id &reference;
+
+        ConstIterator(): m_container(nullptr), m_node(nullptr) {}
+
+        reference operator*() const;
+        pointer operator->() const { return &operator*(); }
+
+        ConstIterator &operator++();
+        ConstIterator operator++(int) { auto tmp = *this; ++*this; return tmp; }
+        ConstIterator &operator--();
+        ConstIterator operator--(int) { auto tmp = *this; --*this; return tmp; }
+
+        bool operator==(const ConstIterator &o) const {
+            return m_node == o.m_node;
+        }
+        bool operator!=(const ConstIterator &o) const {
+            return m_node != o.m_node;
+        }
+
+    private:
+        friend class Container;
+        ConstIterator(const Container *c, const Node *node):
+            m_container(c), m_node(node) {}
+
+        const Container *m_container;
+        const Node *m_node;
+    };
+    typedef ConstIterator const_iterator;
+
+    Container();
+    Container(const QVector<Track::Id> &ids);
+    Container(const Container &other);
+    ~Container();
+
+    Container &operator=(const Container &other);
+
+    int count() const { return m_index.count(); }
+    bool isEmpty() const { return m_index.isEmpty(); }
+    bool contains(const Track::Id &id) const { return m_index.contains(id); }
+
+    // Returns the position of the track, or -1 if not found
+    int indexOf(const Track::Id &id) const;
+    const Track::Id &at(int index) const;
+    const Track::Id &first() const { return at(0); }
+    const Track::Id &last() const { return at(count() - 1); }
+
+    // Inserts the track so that it ends up at the given position
+    void insert(int index, const Track::Id &id);
+    void append(const Track::Id &id) { insert(count(), id); }
+    bool remove(const Track::Id &id);
+    // Same semantics as QVector::move()
+    void move(int from, int to);
+    void clear();
+
+    QVector<Track::Id> toVector() const;
+
+    ConstIterator begin() const;
+    ConstIterator end() const { return ConstIterator(this, nullptr); }
+
+private:
+    Node *nodeAt(int index) const;
+    void attach(int index, Node *node);
+    void detach(Node *node);
+
+    Node *m_root;
+    QHash<Track::Id, Node*> m_index;
+    QRandomGenerator m_random;
+};
+
+} // namespace TrackList
+}
+}
+}
+
+#endif // CORE_UBUNTU_MEDIA_TRACK_LIST_CONTAINER_H_
@@ -20,15 +20,18 @@
 
 #include "engine.h"
 #include "logging.h"
+#include "track_list_shuffle.h"
 
-#include <QMap>
+#include <QHash>
 #include <QPair>
-#include <QRandomGenerator>
+#include <QPointer>
+#include <QSet>
 #include <QSharedPointer>
+#include <QTimer>
 #include <QUrl>
 
-#include <algorithm>
 #include <sstream>
+#include <stdexcept>
 #include <stdio.h>
 #include <stdlib.h>
 #include <tuple>
@@ -38,6 +41,15 @@ namespace media = core::ubuntu::media;
 
 using namespace media;
 
+namespace {
+
+// Maximum number of prefetch requests started in one main loop iteration
+const int prefetchBatchSize = 32;
+// Metadata updates are collected for this long before being notified
+const int metaDataChangedInterval = 250; // milliseconds
+
+} // namespace
+
 namespace core {
 namespace ubuntu {
 namespace media {
@@ -47,24 +59,32 @@ class TrackListImplementationPrivate
     Q_DECLARE_PUBLIC(TrackListImplementation)
 
 public:
-    typedef QMap<Track::Id, QPair<QUrl, Track::MetaData>> MetaDataCache;
+    typedef QHash<Track::Id, QPair<QUrl, Track::MetaData>> MetaDataCache;
 
     TrackListImplementationPrivate(
         const QSharedPointer<media::Engine::MetaDataExtractor> &extractor,
         TrackListImplementation *q);
 
-    TrackList::ConstIterator empty_iterator() const { return m_tracks.begin(); }
-    bool is_first_track(const TrackList::ConstIterator &it) const {
-        return it == m_tracks.begin();
-    }
-    bool is_last_track(const TrackList::ConstIterator &it) const {
-        return it == m_tracks.end();
+    bool is_first_track(const Track::Id &id) const {
+        return !m_tracks.isEmpty() && id == m_tracks.first();
     }
 
-    TrackList::ConstIterator current_iterator() const;
+    int current_index() const;
+    const Track::Id &current_id() const {
+        current_index();
+        return current_track;
+    }
     void set_current_track(const Track::Id &id);
     Track::Id get_current_track() const;
-    TrackList::ConstIterator get_current_shuffled() const;
+    int get_current_shuffled() const;
+    int insert_index_for(const Track::Id &position) const {
+        const int index = m_tracks.indexOf(position);
+        return index >= 0 ? index : m_tracks.count();
+    }
+
+    Track::Id next_track_id() {
+        return Track::Id(session, track_counter++);
+    }
 
     void add_track_with_uri_at(const QUrl &uri,
                                const Track::Id &position,
@@ -83,33 +103,50 @@ public:
         } else {
             i.value().first = uri;
         }
+        // Remote streams would need to be downloaded, leave them to the playbin
+        if (extractor && max_prefetch_requests > 0 && uri.isLocalFile()) {
+            prefetch_pending.insert(id);
+        }
     }
 
-    media::TrackList::Container::iterator get_shuffled_insert_it()
-    {
-        auto random_it = shuffled_tracks.begin();
-        if (random_it == shuffled_tracks.end())
-            return random_it;
-
-        uint32_t random = QRandomGenerator::global()->generate();
-        // This is slightly biased, but not much, as RAND_MAX >= 32767, which is
-        // much more than the average number of tracks.
-        // Note that for N tracks we have N + 1 possible insertion positions.
-        std::advance(random_it, random % (shuffled_tracks.count() + 1));
-        return random_it;
+    /* The metadata of the queued tracks is extracted in the background, a
+     * few tracks at a time, starting from the ones closest to the current
+     * track in playback order. */
+    void restart_prefetch() {
+        prefetch_step = 0;
+        prefetch_timer.start();
     }
+    void prefetch_meta_data();
+    void request_meta_data(const Track::Id &id, const QUrl &uri);
+    void on_meta_data_fetched(const Track::Id &id, const QUrl &uri,
+                              const QVariantMap &metadata);
+    void notify_meta_data_changed();
 
-    size_t track_counter;
+    quint32 session;
+    quint32 track_counter;
     MetaDataCache meta_data_cache;
     QSharedPointer<Engine::MetaDataExtractor> extractor;
-    // Used for caching the original tracklist order to be used to restore the order
-    // to the live TrackList after shuffle is turned off
-    TrackList::Container shuffled_tracks;
     TrackList::Container m_tracks;
+    // The playback order when shuffle is on; it's drawn as playback goes on
+    mutable TrackList::ShuffleOrder shuffled_tracks;
     bool shuffle;
     mutable media::Track::Id current_track;
     media::Player::LoopStatus loop_status;
     uint64_t current_position;
+    // Tracks whose metadata has not been requested yet
+    QSet<Track::Id> prefetch_pending;
+    // Tracks whose metadata changed since the last notification
+    QSet<Track::Id> changed_meta_data;
+    QTimer prefetch_timer;
+    QTimer meta_data_changed_timer;
+    // The prefetch visits the tracks around this one, `prefetch_step` tells
+    // how far it got
+    Track::Id prefetch_origin;
+    int prefetch_step;
+    int prefetch_in_flight;
+    int max_prefetch_requests;
+    bool prefetch_throttled;
+    bool prefetching;
     TrackListImplementation *q_ptr;
 };
 
@@ -118,21 +155,149 @@ public:
 TrackListImplementationPrivate::TrackListImplementationPrivate(
         const QSharedPointer<media::Engine::MetaDataExtractor> &extractor,
         TrackListImplementation *q):
+    session(0),
     track_counter(0),
     extractor(extractor),
+    shuffled_tracks(&m_tracks),
     shuffle(false),
     loop_status(media::Player::LoopStatus::none),
     current_position(0),
+    prefetch_step(0),
+    prefetch_in_flight(0),
+    max_prefetch_requests(
+        qEnvironmentVariableIsSet("MEDIA_HUB_METADATA_PREFETCH") ?
+        qEnvironmentVariableIntValue("MEDIA_HUB_METADATA_PREFETCH") : 1),
+    prefetch_throttled(false),
+    prefetching(false),
     q_ptr(q)
 {
+    prefetch_timer.setSingleShot(true);
+    prefetch_timer.setInterval(0);
+    prefetch_timer.callOnTimeout(q, [this]() { prefetch_meta_data(); });
+
+    meta_data_changed_timer.setSingleShot(true);
+    meta_data_changed_timer.setInterval(metaDataChangedInterval);
+    meta_data_changed_timer.callOnTimeout(q, [this]() {
+        notify_meta_data_changed();
+    });
+}
+
+void TrackListImplementationPrivate::prefetch_meta_data()
+{
+    // Also called by the extractor callbacks, which might run synchronously
+    if (prefetch_throttled || prefetching) return;
+
+    if (prefetch_origin != current_track) {
+        prefetch_origin = current_track;
+        prefetch_step = 0;
+    }
+    const int count = m_tracks.count();
+    const int origin = qMax(shuffle ?
+                            shuffled_tracks.place(prefetch_origin) :
+                            m_tracks.indexOf(prefetch_origin), 0);
+
+    /* In shuffle mode, only the tracks already drawn are visited around the
+     * origin, so that the prefetch doesn't draw the whole order; the others
+     * follow in list order. */
+    const int aroundOrigin = 2 * count;
+    const int lastStep = shuffle ? aroundOrigin + count : aroundOrigin;
+
+    prefetching = true;
+    int started = 0;
+    while (!prefetch_pending.isEmpty() &&
+           prefetch_in_flight < max_prefetch_requests) {
+        if (prefetch_step > lastStep) {
+            // Whatever is left is not in the list anymore
+            prefetch_pending.clear();
+            break;
+        }
+        if (started == prefetchBatchSize) {
+            // Cached metadata is delivered at once, don't block the main loop
+            prefetch_timer.start();
+            break;
+        }
+
+        const int step = prefetch_step++;
+        int index;
+        if (step <= aroundOrigin) {
+            // Alternate between the tracks following and preceding the origin
+            index = step % 2 ? origin + (step + 1) / 2 : origin - step / 2;
+            const int end = shuffle ? shuffled_tracks.drawnCount() : count;
+            if (index < 0 || index >= end) continue;
+        } else {
+            index = step - aroundOrigin - 1;
+            if (index >= count) continue;
+        }
+
+        const Track::Id &id = shuffle && step <= aroundOrigin ?
+            shuffled_tracks.drawnAt(index) : m_tracks.at(index);
+        if (!prefetch_pending.remove(id)) continue;
+
+        started++;
+        request_meta_data(id, meta_data_cache.value(id).first);
+    }
+    prefetching = false;
+}
+
+void TrackListImplementationPrivate::request_meta_data(const Track::Id &id,
+                                                       const QUrl &uri)
+{
+    Q_Q(TrackListImplementation);
+    QPointer<TrackListImplementation> guard(q);
+    prefetch_in_flight++;
+    try {
+        extractor->meta_data_for_track_with_uri(uri,
+                [this, guard, id, uri](const QVariantMap &metadata) {
+            if (!guard) return;
+            prefetch_in_flight--;
+            on_meta_data_fetched(id, uri, metadata);
+            prefetch_meta_data();
+        });
+    } catch (const std::runtime_error &e) {
+        prefetch_in_flight--;
+        MH_WARNING("Cannot extract metadata for %s: %s",
+                   qUtf8Printable(uri.toString()), e.what());
+    }
+}
+
+void TrackListImplementationPrivate::on_meta_data_fetched(
+        const Track::Id &id, const QUrl &uri, const QVariantMap &metadata)
+{
+    auto i = meta_data_cache.find(id);
+    // The track might have been removed or changed in the meantime
+    if (i == meta_data_cache.end() || i.value().first != uri) return;
+    // Failed extractions have nothing to report
+    if (metadata.isEmpty()) return;
+
+    i.value().second = Track::MetaData::fromMap(metadata);
+    changed_meta_data.insert(id);
+    // Not restarted on further updates, to bound the notification delay
+    if (!meta_data_changed_timer.isActive()) {
+        meta_data_changed_timer.start();
+    }
+}
+
+void TrackListImplementationPrivate::notify_meta_data_changed()
+{
+    Q_Q(TrackListImplementation);
+
+    QVector<Track::Id> ids;
+    ids.reserve(changed_meta_data.count());
+    for (const Track::Id &id: changed_meta_data) {
+        if (m_tracks.contains(id)) ids.append(id);
+    }
+    changed_meta_data.clear();
+
+    if (!ids.isEmpty()) {
+        Q_EMIT q->tracksMetadataChanged(ids);
+    }
 }
 
-TrackList::ConstIterator
-TrackListImplementationPrivate::current_iterator() const
+int TrackListImplementationPrivate::current_index() const
 {
     // Prevent the TrackList from sitting at the end which will cause
     // a segfault when calling current()
-    if (!m_tracks.isEmpty() && current_track.isEmpty())
+    if (!m_tracks.isEmpty() && current_track.isNull())
     {
         MH_DEBUG("Wrapping d->current_track back to begin()");
         current_track = m_tracks.first();
@@ -142,7 +307,7 @@ TrackListImplementationPrivate::current_iterator() const
         MH_ERROR("TrackList is empty therefore there is no valid current track");
     }
 
-    return std::find(m_tracks.begin(), m_tracks.end(), current_track);
+    return m_tracks.indexOf(current_track);
 }
 
 void TrackListImplementationPrivate::set_current_track(const Track::Id &id)
@@ -159,11 +324,9 @@ Track::Id TrackListImplementationPrivate::get_current_track() const
     return current_track;
 }
 
-TrackList::ConstIterator
-TrackListImplementationPrivate::get_current_shuffled() const
+int TrackListImplementationPrivate::get_current_shuffled() const
 {
-    auto current_id = get_current_track();
-    return std::find(shuffled_tracks.begin(), shuffled_tracks.end(), current_id);
+    return shuffled_tracks.place(get_current_track());
 }
 
 void TrackListImplementationPrivate::add_track_with_uri_at(
@@ -174,20 +337,21 @@ void TrackListImplementationPrivate::add_track_with_uri_at(
     Q_Q(TrackListImplementation);
     MH_TRACE("");
 
-    Track::Id id = q->objectName() + '/' + QString::number(track_counter++);
+    const Track::Id id = next_track_id();
 
-    MH_DEBUG("Adding Track::Id: %s", qUtf8Printable(id));
+    MH_DEBUG("Adding Track::Id: %s", qUtf8Printable(id.toString()));
     MH_DEBUG("\tURI: %s", qUtf8Printable(uri.toString()));
 
     const auto current = get_current_track();
 
-    auto it = std::find(m_tracks.begin(), m_tracks.end(), position);
-    m_tracks.insert(it, id);
+    m_tracks.insert(insert_index_for(position), id);
 
     updateCachedTrackMetadata(id, uri);
 
     if (shuffle)
-        shuffled_tracks.insert(get_shuffled_insert_it(), id);
+        shuffled_tracks.trackAdded(id);
+
+    restart_prefetch();
 
     if (make_current) {
         set_current_track(id);
@@ -196,7 +360,7 @@ void TrackListImplementationPrivate::add_track_with_uri_at(
         set_current_track(current);
     }
 
-    MH_DEBUG("Signaling that we just added track id: %s", qUtf8Printable(id));
+    MH_DEBUG("Signaling that we just added track id: %s", qUtf8Printable(id.toString()));
     // Signal to the client that a track was added to the TrackList
     Q_EMIT q->trackAdded(id);
 
@@ -216,40 +380,36 @@ void TrackListImplementationPrivate::add_tracks_with_uri_at(
     const auto current = get_current_track();
 
     Track::Id current_id;
-    QVector<QUrl> tmp;
+    QVector<Track::Id> tmp;
+    int insert_index = insert_index_for(position);
     for (const auto uri : uris)
     {
         // TODO: Refactor this code to use a smaller common function shared with add_track_with_uri_at()
-        Track::Id id = q->objectName() + '/' +
-            QString::number(track_counter++);
-        MH_DEBUG("Adding Track::Id: %s", qUtf8Printable(id));
+        const Track::Id id = next_track_id();
+        MH_DEBUG("Adding Track::Id: %s", qUtf8Printable(id.toString()));
         MH_DEBUG("\tURI: %s", qUtf8Printable(uri.toString()));
 
         tmp.push_back(id);
 
-        Track::Id insert_position = position;
-
-        auto it = std::find(m_tracks.begin(), m_tracks.end(), insert_position);
-        m_tracks.insert(it, id);
-        // Make sure the next insert position is after the current insert position
-        // Update the Track::Id after which to insert the next one from uris
-        insert_position = id;
+        // Make sure the next track is inserted after the current one
+        m_tracks.insert(insert_index++, id);
 
         updateCachedTrackMetadata(id, uri);
 
         if (shuffle)
-            shuffled_tracks.insert(get_shuffled_insert_it(), id);
+            shuffled_tracks.trackAdded(id);
 
         if (m_tracks.count() == 1)
             current_id = id;
     }
 
     set_current_track(current);
+    restart_prefetch();
 
     MH_DEBUG("Signaling that we just added %d tracks to the TrackList", tmp.size());
     Q_EMIT q->tracksAdded(tmp);
 
-    if (!current_id.isEmpty()) {
+    if (!current_id.isNull()) {
         Q_EMIT q->trackChanged(current_id);
     }
 }
@@ -259,7 +419,7 @@ bool TrackListImplementationPrivate::move_track(const media::Track::Id &id,
 {
     Q_Q(TrackListImplementation);
     MH_DEBUG("-----------------------------------------------------");
-    if (id.isEmpty() or to.isEmpty())
+    if (id.isNull() or to.isNull())
     {
         MH_ERROR("Can't move track since 'id' or 'to' are empty");
         return false;
@@ -277,40 +437,29 @@ bool TrackListImplementationPrivate::move_track(const media::Track::Id &id,
         return false;
     }
 
-    MH_DEBUG("current_track id: %s", qUtf8Printable(current_track));
-    // Get an iterator that points to the track that is the insertion point
-    auto insert_point_it = std::find(m_tracks.begin(), m_tracks.end(), to);
-    if (insert_point_it == m_tracks.end()) {
+    MH_DEBUG("current_track id: %s", qUtf8Printable(current_track.toString()));
+    // Get the position of the track that is the insertion point
+    const int insert_point = m_tracks.indexOf(to);
+    if (insert_point < 0) {
         throw media::TrackList::Errors::FailedToFindMoveTrackSource
-                ("Failed to find source track " + id);
+                ("Failed to find source track " + id.toString());
     }
 
-    // Get an iterator that points to the track to move within the TrackList
-    auto to_move_it = std::find(m_tracks.begin(), m_tracks.end(), id);
-    if (to_move_it != m_tracks.end())
-    {
-        m_tracks.erase(to_move_it);
-    }
-    else
-    {
+    // Get the position of the track to move within the TrackList
+    const int to_move = m_tracks.indexOf(id);
+    if (to_move < 0) {
         throw media::TrackList::Errors::FailedToFindMoveTrackDest
-                ("Failed to find destination track " + to);
+                ("Failed to find destination track " + to.toString());
     }
 
-    // Insert id at the location just before insert_point_it
-    m_tracks.insert(insert_point_it, id);
+    // The moved track takes the position currently occupied by 'to'
+    m_tracks.move(to_move, insert_point);
+    restart_prefetch();
 
-    const auto new_current_track_it = std::find(m_tracks.begin(), m_tracks.end(), current_track);
-    if (!current_track.isEmpty() && new_current_track_it == m_tracks.end()) {
-        MH_ERROR("Can't update current_iterator - failed to find track after move");
+    if (!current_track.isNull() && !m_tracks.contains(current_track)) {
+        MH_ERROR("Can't update current track - failed to find track after move");
         throw media::TrackList::Errors::FailedToMoveTrack();
     }
-
-    MH_DEBUG("TrackList after move");
-    for(const auto track : m_tracks)
-    {
-        MH_DEBUG("%s", qUtf8Printable(track));
-    }
     // Signal to the client that track 'id' was moved within the TrackList
     Q_EMIT q->trackMoved(id, to);
 
@@ -325,9 +474,9 @@ void TrackListImplementationPrivate::remove_track(const Track::Id &id)
 
     media::Track::Id track = id;
 
-    auto id_it = std::find(m_tracks.begin(), m_tracks.end(), track);
-    if (id_it == m_tracks.end()) {
-        QString err_str = QString("Track ") + track + " not found in track list";
+    const int index = m_tracks.indexOf(track);
+    if (index < 0) {
+        QString err_str = QString("Track ") + track.toString() + " not found in track list";
         MH_WARNING() << err_str;
         throw media::TrackList::Errors::TrackNotFound(err_str);
     }
@@ -340,17 +489,17 @@ void TrackListImplementationPrivate::remove_track(const Track::Id &id)
         MH_DEBUG("Removing current track");
         deleting_current = true;
 
-        auto next_it = std::next(id_it);
+        int next_index = index + 1;
 
-        if (next_it == m_tracks.end() &&
+        if (next_index == m_tracks.count() &&
             loop_status == media::Player::LoopStatus::playlist)
         {
             // Removed the last track, current is the first track and make sure that
             // the player starts playing it
-            next_it = m_tracks.begin();
+            next_index = 0;
         }
 
-        if (next_it == m_tracks.end())
+        if (next_index == m_tracks.count())
         {
             current_track.clear();
             // Nothing else to play, stop playback
@@ -358,27 +507,29 @@ void TrackListImplementationPrivate::remove_track(const Track::Id &id)
         }
         else
         {
-            current_track = *next_it;
+            current_track = m_tracks.at(next_index);
         }
     }
 
     do_remove_track(track);
 
-    if (!current_track.isEmpty() and deleting_current)
+    if (!current_track.isNull() and deleting_current)
         go_to(current_track);
 }
 
 void TrackListImplementationPrivate::do_remove_track(const Track::Id &id)
 {
     Q_Q(TrackListImplementation);
-    int removed = m_tracks.removeAll(id);
-
-    if (removed > 0)
+    if (m_tracks.remove(id))
     {
         meta_data_cache.remove(id);
+        prefetch_pending.remove(id);
+        changed_meta_data.remove(id);
+        // The following tracks got closer to the origin
+        prefetch_step = 0;
 
         if (shuffle)
-            shuffled_tracks.removeAll(id);
+            shuffled_tracks.trackRemoved(id);
 
         Q_EMIT q->trackRemoved(id);
 
@@ -414,11 +565,11 @@ void TrackListImplementation::setShuffle(bool shuffle)
     Q_D(TrackListImplementation);
     d->shuffle = shuffle;
 
-    if (shuffle) {
-        d->shuffled_tracks = d->m_tracks;
-        std::random_shuffle(d->shuffled_tracks.begin(),
-                            d->shuffled_tracks.end());
-    }
+    // The new order starts from the current track; this is constant-time,
+    // since the other tracks are only drawn when needed
+    d->shuffled_tracks.reset(shuffle ? d->current_track : Track::Id());
+    // The playback order changed
+    d->restart_prefetch();
 }
 
 bool TrackListImplementation::shuffle() const
@@ -449,6 +600,25 @@ Track::MetaData TrackListImplementation::query_meta_data_for_track(const Track::
     return it.value().second;
 }
 
+void TrackListImplementation::query_tracks(const QVector<Track::Id> &ids,
+                                           QVector<QUrl> *uris,
+                                           QVector<Track::MetaData> *meta_data)
+{
+    Q_D(const TrackListImplementation);
+
+    if (uris) uris->fill(QUrl(), ids.count());
+    if (meta_data) meta_data->fill(Track::MetaData{}, ids.count());
+
+    const auto &cache = d->meta_data_cache;
+    for (int index = 0; index < ids.count(); index++) {
+        const auto it = cache.constFind(ids[index]);
+        if (it == cache.constEnd()) continue;
+
+        if (uris) (*uris)[index] = it.value().first;
+        if (meta_data) (*meta_data)[index] = it.value().second;
+    }
+}
+
 void media::TrackListImplementation::add_track_with_uri_at(
         const QUrl &uri,
         const media::Track::Id& position,
@@ -488,12 +658,6 @@ void media::TrackListImplementation::go_to(const media::Track::Id& track)
     d->go_to(track);
 }
 
-const TrackList::Container &TrackListImplementation::shuffled_tracks() const
-{
-    Q_D(const TrackListImplementation);
-    return d->shuffled_tracks;
-}
-
 void media::TrackListImplementation::reset()
 {
     Q_D(TrackListImplementation);
@@ -506,7 +670,9 @@ void media::TrackListImplementation::reset()
     // And make sure there is no "current" track
     d->m_tracks.clear();
     d->track_counter = 0;
-    d->shuffled_tracks.clear();
+    d->shuffled_tracks.reset();
+    d->prefetch_pending.clear();
+    d->changed_meta_data.clear();
 
     Q_EMIT trackListReset();
 }
@@ -530,13 +696,9 @@ bool TrackListImplementation::hasNext() const
     if (n_tracks == 0)
         return false;
 
-    // TODO Using current_iterator() makes media-hub crash later. Logic for
-    // handling the iterators must be reviewed. As a minimum updates to the
-    // track list should update current_track instead of the list being sneakly
-    // changed in player_implementation.cpp.
-    // To avoid the crash we consider that current_track will be eventually
-    // initialized to the first track when current_iterator() gets called.
-    if (d->current_track == d->empty_iterator())
+    // We consider that current_track will be eventually initialized to the
+    // first track when current_index() gets called.
+    if (d->current_track.isNull() || d->is_first_track(d->current_track))
     {
         if (n_tracks < 2)
             return false;
@@ -546,13 +708,11 @@ bool TrackListImplementation::hasNext() const
 
     if (shuffle())
     {
-        auto it = d->get_current_shuffled();
-        return ++it != d->shuffled_tracks.end();
+        return d->get_current_shuffled() + 1 < d->shuffled_tracks.count();
     }
     else
     {
-        const auto next_track = std::next(d->current_iterator());
-        return !d->is_last_track(next_track);
+        return d->current_index() + 1 < n_tracks;
     }
 }
 
@@ -564,14 +724,15 @@ bool TrackListImplementation::hasNext() const
 bool TrackListImplementation::hasPrevious() const
 {
     Q_D(const TrackListImplementation);
-    if (d->m_tracks.isEmpty() || d->current_track == d->empty_iterator())
+    if (d->m_tracks.isEmpty() || d->current_track.isNull() ||
+        d->is_first_track(d->current_track))
         return false;
 
     MH_DEBUG() << "shuffle is" << shuffle();
     if (shuffle())
-        return d->get_current_shuffled() != d->shuffled_tracks.begin();
+        return d->get_current_shuffled() != 0;
     else
-        return d->current_track != d->m_tracks.begin();
+        return d->current_index() > 0;
 }
 
 media::Track::Id media::TrackListImplementation::next()
@@ -602,15 +763,13 @@ media::Track::Id media::TrackListImplementation::next()
             /* Re-shuffle the tracks, but make sure that the new first track
              * is not the same as the current one */
             const auto currentId = d->get_current_track();
-            std::random_shuffle(d->shuffled_tracks.begin(),
-                                d->shuffled_tracks.end());
-            auto id = *d->shuffled_tracks.begin();
-            if (id == currentId) {
-                std::iter_swap(d->shuffled_tracks.begin(),
-                               d->shuffled_tracks.end() - 1);
-                id = *d->shuffled_tracks.begin();
+            d->shuffled_tracks.reset();
+            if (d->shuffled_tracks.count() > 1 &&
+                d->shuffled_tracks.first() == currentId) {
+                // Put the current track back into the pool
+                d->shuffled_tracks.reset(d->shuffled_tracks.at(1));
             }
-            d->set_current_track(id);
+            d->set_current_track(d->shuffled_tracks.first());
         }
         else
         {
@@ -622,33 +781,35 @@ media::Track::Id media::TrackListImplementation::next()
     {
         if (shuffle())
         {
-            auto it = d->get_current_shuffled();
-            if (it == d->shuffled_tracks.end()) {
+            const int index = d->get_current_shuffled();
+            if (index < 0) {
                 d->set_current_track(d->shuffled_tracks.first());
                 go_to_track = true;
-            } else if (++it != d->shuffled_tracks.end()) {
-                MH_INFO("Advancing to next track: %s", qUtf8Printable(*it));
-                d->set_current_track(*it);
+            } else if (index + 1 < d->shuffled_tracks.count()) {
+                const auto &id = d->shuffled_tracks.at(index + 1);
+                MH_INFO("Advancing to next track: %s", qUtf8Printable(id.toString()));
+                d->set_current_track(id);
                 go_to_track = true;
             }
         }
         else
         {
-            const auto it = std::next(d->current_iterator());
-            if (not d->is_last_track(it))
+            const int index = d->current_index() + 1;
+            if (index < d->m_tracks.count())
             {
-                MH_INFO("Advancing to next track: %s", qUtf8Printable(*it));
-                d->current_track = *it;
+                const auto &id = d->m_tracks.at(index);
+                MH_INFO("Advancing to next track: %s", qUtf8Printable(id.toString()));
+                d->current_track = id;
                 go_to_track = true;
             }
         }
 
     }
 
-    const media::Track::Id id = *(d->current_iterator());
+    const media::Track::Id id = d->current_id();
     if (go_to_track)
     {
-        MH_DEBUG("next track id is %s", qUtf8Printable(id));
+        MH_DEBUG("next track id is %s", qUtf8Printable(id.toString()));
         Q_EMIT trackChanged(id);
         // Signal the PlayerImplementation to play the next track
         Q_EMIT onGoToTrack(id);
@@ -663,6 +824,39 @@ media::Track::Id media::TrackListImplementation::next()
     return id;
 }
 
+media::Track::Id media::TrackListImplementation::peek_next() const
+{
+    Q_D(const TrackListImplementation);
+    if (d->m_tracks.isEmpty())
+        return media::Track::Id{};
+
+    if (d->loop_status == media::Player::LoopStatus::track)
+        return d->current_id();
+
+    if (d->loop_status == media::Player::LoopStatus::playlist && not hasNext())
+    {
+        // When shuffling, next() will pick a random track
+        return shuffle() ? media::Track::Id{} : d->m_tracks.first();
+    }
+
+    if (shuffle())
+    {
+        const int index = d->get_current_shuffled();
+        if (index < 0)
+            return d->shuffled_tracks.first();
+        if (index + 1 < d->shuffled_tracks.count())
+            return d->shuffled_tracks.at(index + 1);
+    }
+    else
+    {
+        const int index = d->current_index() + 1;
+        if (index < d->m_tracks.count())
+            return d->m_tracks.at(index);
+    }
+
+    return media::Track::Id{};
+}
+
 media::Track::Id media::TrackListImplementation::previous()
 {
     Q_D(TrackListImplementation);
@@ -697,8 +891,7 @@ media::Track::Id media::TrackListImplementation::previous()
 
         if (shuffle())
         {
-            const auto id = *std::prev(d->shuffled_tracks.end());
-            d->set_current_track(id);
+            d->set_current_track(d->shuffled_tracks.last());
         }
         else
         {
@@ -711,21 +904,23 @@ media::Track::Id media::TrackListImplementation::previous()
     {
         if (shuffle())
         {
-            auto it = d->get_current_shuffled();
-            if (it != d->shuffled_tracks.begin()) {
-                d->set_current_track(*(--it));
+            const int index = d->get_current_shuffled();
+            if (index != 0) {
+                d->set_current_track(index > 0 ?
+                                     d->shuffled_tracks.at(index - 1) :
+                                     d->shuffled_tracks.last());
                 go_to_track = true;
             }
         }
-        else if (not d->is_first_track(d->current_iterator()))
+        else if (d->current_index() > 0)
         {
             // Keep returning the previous track until the first track is reached
-            d->current_track = *std::prev(d->current_iterator());
+            d->current_track = d->m_tracks.at(d->current_index() - 1);
             go_to_track = true;
         }
     }
 
-    const media::Track::Id id = *(d->current_iterator());
+    const media::Track::Id id = d->current_id();
     if (go_to_track)
     {
         Q_EMIT trackChanged(id);
@@ -744,7 +939,7 @@ media::Track::Id media::TrackListImplementation::previous()
 const Track::Id &TrackListImplementation::current() const
 {
     Q_D(const TrackListImplementation);
-    return *(d->current_iterator());
+    return d->current_id();
 }
 
 void TrackListImplementation::setLoopStatus(Player::LoopStatus loop_status)
@@ -759,6 +954,35 @@ Player::LoopStatus TrackListImplementation::loopStatus() const
     return d->loop_status;
 }
 
+void TrackListImplementation::setSession(Player::PlayerKey session)
+{
+    Q_D(TrackListImplementation);
+    d->session = session;
+}
+
+Player::PlayerKey TrackListImplementation::session() const
+{
+    Q_D(const TrackListImplementation);
+    return d->session;
+}
+
+void TrackListImplementation::setPrefetchThrottled(bool throttled)
+{
+    Q_D(TrackListImplementation);
+    if (throttled == d->prefetch_throttled) return;
+
+    d->prefetch_throttled = throttled;
+    if (!throttled) {
+        d->prefetch_timer.start();
+    }
+}
+
+bool TrackListImplementation::prefetchThrottled() const
+{
+    Q_D(const TrackListImplementation);
+    return d->prefetch_throttled;
+}
+
 void TrackListImplementation::setCurrentPosition(uint64_t position)
 {
     Q_D(TrackListImplementation);
@@ -772,6 +996,6 @@ bool TrackListImplementation::canEditTracks() const
 
 const Track::Id &TrackListImplementation::afterEmptyTrack()
 {
-    static const media::Track::Id id{"/org/mpris/MediaPlayer2/TrackList/NoTrack"};
+    static const media::Track::Id id = media::Track::Id::noTrack();
     return id;
 }
@@ -21,6 +21,7 @@
 
 #include "engine.h"
 #include "track.h"
+#include "track_list_container.h"
 
 #include <QObject>
 #include <QScopedPointer>
@@ -65,7 +66,6 @@ namespace TrackList
         };
     };
 
-    typedef QVector<Track::Id> Container;
     typedef Container::ConstIterator ConstIterator;
 } // namespace TrackList
 
@@ -80,18 +80,34 @@ public:
             QObject *parent = nullptr);
     ~TrackListImplementation();
 
+    /* The session of the player owning the track list, which is part of
+     * the ID of the tracks added from now on */
+    void setSession(Player::PlayerKey session);
+    Player::PlayerKey session() const;
+
     void setLoopStatus(Player::LoopStatus status);
     Player::LoopStatus loopStatus() const;
 
     void setShuffle(bool shuffle);
     bool shuffle() const;
 
+    /* The metadata of the queued tracks is prefetched in the background;
+     * while throttled, no new extraction is started */
+    void setPrefetchThrottled(bool throttled);
+    bool prefetchThrottled() const;
+
     void setCurrentPosition(uint64_t position);
 
     bool canEditTracks() const;
 
     QUrl query_uri_for_track(const Track::Id& id);
     Track::MetaData query_meta_data_for_track(const Track::Id& id);
+    /* Batch version of the two methods above: the returned vectors have the
+     * same length as `ids`, and either of them can be omitted. Unknown tracks
+     * get an empty URI and empty metadata. */
+    void query_tracks(const QVector<Track::Id> &ids,
+                      QVector<QUrl> *uris,
+                      QVector<Track::MetaData> *meta_data);
 
     static const Track::Id &afterEmptyTrack();
     void add_track_with_uri_at(const QUrl &uri, const Track::Id& position, bool make_current);
@@ -100,13 +116,15 @@ public:
     void remove_track(const Track::Id& id);
 
     void go_to(const Track::Id& track);
-    const TrackList::Container &shuffled_tracks() const;
     void reset();
     const TrackList::Container &tracks() const;
 
     bool hasNext() const;
     bool hasPrevious() const;
     Track::Id next();
+    /* Returns the track that next() would go to, or an empty ID if that
+     * cannot be known in advance (end of the list, or a re-shuffle) */
+    Track::Id peek_next() const;
     Track::Id previous();
     const Track::Id& current() const;
 
@@ -114,11 +132,14 @@ Q_SIGNALS:
     void endOfTrackList();
     void onGoToTrack(const media::Track::Id &id);
     void trackAdded(const media::Track::Id &id);
-    void tracksAdded(const QVector<QUrl> &tracks);
+    void tracksAdded(const QVector<media::Track::Id> &tracks);
     void trackRemoved(const media::Track::Id &id);
     void trackMoved(const media::Track::Id &id,
                     const media::Track::Id &to);
     void trackListReset();
+    // Emitted at most every few hundred milliseconds, for all the tracks
+    // whose metadata changed in the meantime
+    void tracksMetadataChanged(const QVector<media::Track::Id> &ids);
     void trackChanged(const media::Track::Id &id);
     void trackListReplaced(const QVector<media::Track::Id> &tracks,
                            const Track::Id &currentTrack);
@@ -0,0 +1,114 @@
+/*
+ * Copyright © 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "track_list_shuffle.h"
+
+#include <QtGlobal>
+
+#include <algorithm>
+
+namespace media = core::ubuntu::media;
+
+using namespace media;
+using namespace media::TrackList;
+
+ShuffleOrder::ShuffleOrder(const Container *tracks):
+    m_tracks(tracks),
+    m_random(QRandomGenerator::global()->generate())
+{
+}
+
+void ShuffleOrder::reset(const Track::Id &first)
+{
+    // `first` might be a reference to one of our own tracks
+    const Track::Id id = first;
+    m_drawn.clear();
+    if (!id.isNull() && m_tracks->contains(id)) {
+        m_drawn.append(id);
+    }
+}
+
+const Track::Id &ShuffleOrder::at(int index)
+{
+    Q_ASSERT(index >= 0 && index < count());
+    while (m_drawn.count() <= index) {
+        draw();
+    }
+    return m_drawn.at(index);
+}
+
+int ShuffleOrder::place(const Track::Id &id)
+{
+    const int index = m_drawn.indexOf(id);
+    if (index >= 0) return index;
+
+    if (!m_tracks->contains(id)) return -1;
+    m_drawn.append(id);
+    return m_drawn.count() - 1;
+}
+
+void ShuffleOrder::trackAdded(const Track::Id &id)
+{
+    /* The new track takes any of the count() possible positions with the
+     * same probability; ending up after the drawn tracks is the same as
+     * being left in the pool. */
+    const int index = m_random.bounded(count());
+    if (index < m_drawn.count()) {
+        m_drawn.insert(index, id);
+    }
+}
+
+QVector<Track::Id> ShuffleOrder::toVector()
+{
+    drawAll();
+    return m_drawn.toVector();
+}
+
+void ShuffleOrder::draw()
+{
+    const int total = count();
+    Q_ASSERT(m_drawn.count() < total);
+
+    /* As long as at least half of the tracks are still in the pool, a random
+     * track of the list is picked in less than two attempts on average; past
+     * that point, shuffling the whole pool at once is cheaper. */
+    if (2 * m_drawn.count() > total) {
+        drawAll();
+        return;
+    }
+
+    while (true) {
+        const Track::Id &id = m_tracks->at(m_random.bounded(total));
+        if (!m_drawn.contains(id)) {
+            m_drawn.append(id);
+            return;
+        }
+    }
+}
+
+void ShuffleOrder::drawAll()
+{
+    QVector<Track::Id> pool;
+    pool.reserve(count() - m_drawn.count());
+    for (const Track::Id &id: *m_tracks) {
+        if (!m_drawn.contains(id)) pool.append(id);
+    }
+
+    std::shuffle(pool.begin(), pool.end(), m_random);
+    for (const Track::Id &id: pool) {
+        m_drawn.append(id);
+    }
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright © 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CORE_UBUNTU_MEDIA_TRACK_LIST_SHUFFLE_H_
+#define CORE_UBUNTU_MEDIA_TRACK_LIST_SHUFFLE_H_
+
+#include "track_list_container.h"
+
+#include <QRandomGenerator>
+#include <QVector>
+
+namespace core
+{
+namespace ubuntu
+{
+namespace media
+{
+namespace TrackList
+{
+
+/*
+ * Random playback order of the tracks of a Container.
+ *
+ * The order is a Fisher–Yates shuffle which is only carried out as far as
+ * it's needed: the tracks whose position has already been drawn are kept in
+ * a Container, while all the other tracks of the list make up the pool from
+ * which the following ones will be drawn. Starting a new order is therefore
+ * a constant-time operation, moving to the next or previous track costs
+ * O(log n), and so do track insertions and removals, which keep the order
+ * of the tracks drawn so far.
+ *
+ * The list must outlive the order, and trackAdded() and trackRemoved() must
+ * be called whenever the list is edited.
+ */
+class ShuffleOrder
+{
+public:
+    ShuffleOrder(const Container *tracks);
+
+    // Same as the number of tracks in the list
+    int count() const { return m_tracks->count(); }
+    // Number of tracks whose position has already been drawn
+    int drawnCount() const { return m_drawn.count(); }
+
+    // Starts a new order, beginning with `first` unless this is null
+    void reset(const Track::Id &first = Track::Id());
+
+    // Returns the track at `index`, drawing the tracks up to it if needed
+    const Track::Id &at(int index);
+    const Track::Id &first() { return at(0); }
+    const Track::Id &last() { return at(count() - 1); }
+    // Returns the track at `index`, which must be lower than drawnCount()
+    const Track::Id &drawnAt(int index) const { return m_drawn.at(index); }
+
+    // Returns the position of the track, or -1 if it hasn't been drawn yet
+    int indexOf(const Track::Id &id) const { return m_drawn.indexOf(id); }
+    /* Like indexOf(), but a track which hasn't been drawn yet is placed
+     * right after the drawn ones. Returns -1 if the track is not in the
+     * list. */
+    int place(const Track::Id &id);
+
+    // To be called after the track has been added to the list
+    void trackAdded(const Track::Id &id);
+    // To be called after the track has been removed from the list
+    void trackRemoved(const Track::Id &id) { m_drawn.remove(id); }
+
+    // Draws all the remaining tracks
+    QVector<Track::Id> toVector();
+
+private:
+    Q_DISABLE_COPY(ShuffleOrder)
+
+    void draw();
+    void drawAll();
+
+    const Container *m_tracks;
+    Container m_drawn;
+    QRandomGenerator m_random;
+};
+
+} // namespace TrackList
+}
+}
+}
+
+#endif // CORE_UBUNTU_MEDIA_TRACK_LIST_SHUFFLE_H_
@@ -21,14 +21,20 @@
 #include "apparmor/ubuntu.h"
 #include "logging.h"
 #include "track_list_implementation.h"
+#include "xesam.h"
 
 #include "mpris.h"
 
-#include "util/uri_check.h"
+#include "util/uri_batch_check.h"
 
 #include <QDBusConnection>
+#include <QDBusError>
+#include <QDBusMetaType>
 #include <QDBusMessage>
+#include <QQueue>
+#include <QSharedPointer>
 
+#include <functional>
 #include <limits>
 #include <cstdint>
 
@@ -36,6 +42,30 @@ namespace media = core::ubuntu::media;
 
 using namespace media;
 
+namespace {
+
+QVariantMap trackMetadataMap(const Track::MetaData &metaData,
+                             const QDBusObjectPath &id,
+                             const QUrl &uri)
+{
+    QVariantMap map = metaData.toMap();
+    map.insert(Track::MetaData::TrackIdKey, QVariant::fromValue(id));
+    if (!map.contains(xesam::Url::name)) {
+        map.insert(xesam::Url::name, uri.toString());
+    }
+    return map;
+}
+
+// Answers a call whose track list went away while its URIs were checked
+void sendTrackListGoneReply(QDBusConnection bus, const QDBusMessage &in)
+{
+    bus.send(in.createErrorReply(QDBusError::Failed,
+        QStringLiteral("The track list was destroyed before the tracks "
+                       "could be added")));
+}
+
+} // namespace
+
 namespace core {
 namespace ubuntu {
 namespace media {
@@ -58,16 +88,47 @@ public:
     {
     }
 
+    /* Additions are validated asynchronously, but must be applied in the
+     * order in which they were requested: each one gets a slot in this
+     * queue, which is filled once the validation completes. */
+    struct Addition {
+        bool ready = false;
+        std::function<void()> apply;
+    };
+    QSharedPointer<Addition> beginAddition();
+    void completeAddition(const QSharedPointer<Addition> &addition,
+                          const std::function<void()> &apply);
+
 private:
     QDBusConnection m_connection;
     media::apparmor::ubuntu::RequestContextResolver::Ptr request_context_resolver;
     media::apparmor::ubuntu::RequestAuthenticator::Ptr request_authenticator;
     TrackListImplementation *m_impl;
+    QQueue<QSharedPointer<Addition>> m_additions;
     TrackListSkeleton *q_ptr;
 };
 
 }}} // namespace
 
+QSharedPointer<TrackListSkeletonPrivate::Addition>
+TrackListSkeletonPrivate::beginAddition()
+{
+    auto addition = QSharedPointer<Addition>::create();
+    m_additions.enqueue(addition);
+    return addition;
+}
+
+void TrackListSkeletonPrivate::completeAddition(
+        const QSharedPointer<Addition> &addition,
+        const std::function<void()> &apply)
+{
+    addition->apply = apply;
+    addition->ready = true;
+    while (!m_additions.isEmpty() && m_additions.head()->ready) {
+        m_additions.dequeue()->apply();
+    }
+}
+
 media::TrackListSkeleton::TrackListSkeleton(const QDBusConnection &bus,
         const media::apparmor::ubuntu::RequestContextResolver::Ptr& request_context_resolver,
         const media::apparmor::ubuntu::RequestAuthenticator::Ptr& request_authenticator,
@@ -84,29 +145,50 @@ media::TrackListSkeleton::TrackListSkeleton(const QDBusConnection &bus,
                                   const Track::Id &currentTrack) {
         QStringList trackList;
         for (const auto id: tracks) {
-            trackList.append(id);
+            trackList.append(id.toString());
         }
-        Q_EMIT TrackListReplaced(trackList, currentTrack);
+        Q_EMIT TrackListReplaced(trackList, currentTrack.toString());
     });
     QObject::connect(impl, &TrackListImplementation::trackAdded,
-                     this, &TrackListSkeleton::TrackAdded);
+                     this, [this](const Track::Id &id) {
+        Q_EMIT TrackAdded(id.toString());
+    });
     QObject::connect(impl, &TrackListImplementation::tracksAdded,
-                     this, [this](const QVector<QUrl> &tracks) {
+                     this, [this](const QVector<media::Track::Id> &tracks) {
         QStringList trackList;
-        for (const auto uri: tracks) {
-            trackList.append(uri.toString());
+        for (const auto id: tracks) {
+            trackList.append(id.toString());
         }
         Q_EMIT TracksAdded(trackList);
     });
     QObject::connect(impl, &TrackListImplementation::trackRemoved,
-                     this, &TrackListSkeleton::TrackRemoved);
+                     this, [this](const Track::Id &id) {
+        Q_EMIT TrackRemoved(id.toString());
+    });
     QObject::connect(impl, &TrackListImplementation::trackMoved,
-                     this, &TrackListSkeleton::TrackMoved);
+                     this, [this](const Track::Id &id, const Track::Id &to) {
+        Q_EMIT TrackMoved(id.toString(), to.toString());
+    });
     QObject::connect(impl, &TrackListImplementation::trackChanged,
-                     this, &TrackListSkeleton::TrackChanged);
+                     this, [this](const Track::Id &id) {
+        Q_EMIT TrackChanged(id.toString());
+    });
     QObject::connect(impl, &TrackListImplementation::trackListReset,
                      this, &TrackListSkeleton::TrackListReset);
-    // FIXME TrackMetadataChanged is never invoked
+    QObject::connect(impl, &TrackListImplementation::tracksMetadataChanged,
+                     this, [this, impl](const QVector<media::Track::Id> &ids) {
+        QVector<QUrl> uris;
+        QVector<Track::MetaData> metaData;
+        impl->query_tracks(ids, &uris, &metaData);
+        for (int i = 0; i < ids.count(); i++) {
+            if (uris[i].isEmpty()) continue;
+            const QDBusObjectPath path(ids[i].toString());
+            Q_EMIT TrackMetadataChanged(
+                trackMetadataMap(metaData[i], path, uris[i]), path);
+        }
+    });
+
+    qDBusRegisterMetaType<QList<QVariantMap>>();
 }
 
 media::TrackListSkeleton::~TrackListSkeleton()
@@ -117,9 +199,9 @@ QStringList TrackListSkeleton::tracks() const
 {
     Q_D(const TrackListSkeleton);
     QStringList trackList;
-    const auto tracks = d->m_impl->tracks();
+    const auto &tracks = d->m_impl->tracks();
     for (const auto id: tracks) {
-        trackList.append(id);
+        trackList.append(id.toString());
     }
     return trackList;
 }
@@ -142,10 +224,57 @@ QMap<QString,QString> TrackListSkeleton::GetTracksMetadata(const QString &track)
     return QMap<QString,QString>();
 }
 
+QList<QVariantMap> TrackListSkeleton::GetTracksMetadata(
+        const QList<QDBusObjectPath> &ids)
+{
+    Q_D(TrackListSkeleton);
+
+    QVector<Track::Id> trackIds;
+    trackIds.reserve(ids.count());
+    for (const QDBusObjectPath &id: ids) {
+        trackIds.append(Track::Id::fromString(id.path()));
+    }
+
+    QVector<QUrl> uris;
+    QVector<Track::MetaData> metaData;
+    d->m_impl->query_tracks(trackIds, &uris, &metaData);
+
+    QList<QVariantMap> ret;
+    ret.reserve(trackIds.count());
+    for (int i = 0; i < trackIds.count(); i++) {
+        // An empty URI means that the track is not in the list
+        if (uris[i].isEmpty()) continue;
+        ret.append(trackMetadataMap(metaData[i], ids[i], uris[i]));
+    }
+    return ret;
+}
+
 QString TrackListSkeleton::GetTracksUri(const QString &track)
 {
     Q_D(TrackListSkeleton);
-    return d->m_impl->query_uri_for_track(track).toString();
+    return d->m_impl->query_uri_for_track(
+        Track::Id::fromString(track)).toString();
+}
+
+QStringList TrackListSkeleton::GetTracksUris(const QList<QDBusObjectPath> &ids)
+{
+    Q_D(TrackListSkeleton);
+
+    QVector<Track::Id> trackIds;
+    trackIds.reserve(ids.count());
+    for (const QDBusObjectPath &id: ids) {
+        trackIds.append(Track::Id::fromString(id.path()));
+    }
+
+    QVector<QUrl> uris;
+    d->m_impl->query_tracks(trackIds, &uris, nullptr);
+
+    QStringList ret;
+    ret.reserve(uris.count());
+    for (const QUrl &uri: uris) {
+        ret.append(uri.toString());
+    }
+    return ret;
 }
 
 void TrackListSkeleton::AddTrack(const QString &uri, const QString &after,
@@ -164,54 +293,65 @@ void TrackListSkeleton::AddTrack(const QString &uri, const QString &after,
         bool makeCurrent;
     } params = { uri, after, makeCurrent };
 
+    const auto addition = d->beginAddition();
     d->request_context_resolver->resolve_context_for_dbus_name_async
-        (in.service(), [this, in, bus, params](const media::apparmor::ubuntu::Context& context)
+        (in.service(), [this, in, bus, params, addition](const media::apparmor::ubuntu::Context& context)
     {
         Q_D(TrackListSkeleton);
         QUrl uri = QUrl::fromUserInput(params.uri);
-        media::Track::Id after = params.after;
+        const Track::Id after = Track::Id::fromString(params.after);
         bool makeCurrent = params.makeCurrent;
 
         // Make sure the client has adequate apparmor permissions to open the URI
         const auto result = d->request_authenticator->authenticate_open_uri_request(context, uri);
 
-        UriCheck uri_check(uri);
-        const bool valid_uri = !uri_check.is_local_file() or
-                (uri_check.is_local_file() and uri_check.file_exists());
-        QDBusMessage reply = in.createReply();
-        if (!valid_uri)
-        {
-            const QString err_str = {"Warning: Not adding track " + uri.toString() +
-                 " to TrackList because it can't be found."};
-            MH_WARNING() << err_str;
-            reply = in.createErrorReply(
-                        mpris::Player::Error::UriNotFound::name,
-                        err_str);
-        }
-        else
+        // Looking for the file can be slow: do it off the main thread
+        UriBatchCheck::run({ uri }, this,
+                           [=](const QVector<bool> &valid)
         {
-            // Only add the track to the TrackList if it passes the apparmor permissions check
-            if (std::get<0>(result))
-            {
-                d->m_impl->add_track_with_uri_at(uri, after, makeCurrent);
-            }
-            else
+            Q_D(TrackListSkeleton);
+            QDBusMessage reply = in.createReply();
+            bool add = false;
+            if (!valid[0])
             {
                 const QString err_str = {"Warning: Not adding track " + uri.toString() +
-                    " to TrackList because of inadequate client apparmor permissions."};
+                     " to TrackList because it can't be found."};
                 MH_WARNING() << err_str;
                 reply = in.createErrorReply(
-                            mpris::TrackList::Error::InsufficientPermissionsToAddTrack::name,
+                            mpris::Player::Error::UriNotFound::name,
                             err_str);
             }
-        }
+            else
+            {
+                // Only add the track to the TrackList if it passes the apparmor permissions check
+                if (std::get<0>(result))
+                {
+                    add = true;
+                }
+                else
+                {
+                    const QString err_str = {"Warning: Not adding track " + uri.toString() +
+                        " to TrackList because of inadequate client apparmor permissions."};
+                    MH_WARNING() << err_str;
+                    reply = in.createErrorReply(
+                                mpris::TrackList::Error::InsufficientPermissionsToAddTrack::name,
+                                err_str);
+                }
+            }
 
-        bus.send(reply);
+            d->completeAddition(addition, [=]() {
+                Q_D(TrackListSkeleton);
+                if (add) {
+                    d->m_impl->add_track_with_uri_at(uri, after, makeCurrent);
+                }
+                bus.send(reply);
+            });
+        }, [bus, in]() { sendTrackListGoneReply(bus, in); });
     });
 }
 
-void TrackListSkeleton::AddTracks(const QStringList &uris,
-                                  const QString &after)
+QStringList TrackListSkeleton::AddTracks(const QStringList &uris,
+                                         const QString &after)
 {
     Q_D(TrackListSkeleton);
     MH_TRACE("");
@@ -224,68 +364,90 @@ void TrackListSkeleton::AddTracks(const QStringList &uris,
         QString after;
     } params = { uris, after };
 
+    const auto addition = d->beginAddition();
     d->request_context_resolver->resolve_context_for_dbus_name_async
-        (in.service(), [this, in, bus, params](const media::apparmor::ubuntu::Context& context)
+        (in.service(), [this, in, bus, params, addition](const media::apparmor::ubuntu::Context& context)
     {
         Q_D(TrackListSkeleton);
         const QStringList &uris = params.uris;
-        const media::Track::Id after = params.after;
-
-        bool valid_uri = false;
-        media::apparmor::ubuntu::RequestAuthenticator::Result result;
-        QString uri_err_str, err_str;
-        QVector<QUrl> trackUris;
-        QDBusMessage reply;
-        for (const auto uri : uris)
-        {
-            UriCheck uri_check(uri);
-            valid_uri = !uri_check.is_local_file() or
-                    (uri_check.is_local_file() and uri_check.file_exists());
-            if (!valid_uri)
-            {
-                uri_err_str = {"Warning: Not adding track " + uri +
-                     " to TrackList because it can't be found."};
-                MH_WARNING() << uri_err_str;
-                reply = in.createErrorReply(
-                            mpris::Player::Error::UriNotFound::name,
-                            err_str);
-            }
 
+        /* Error names for each URI, or empty strings for the URIs which can
+         * be added */
+        QStringList results;
+        QStringList errors;
+        QVector<QUrl> candidates;
+        QVector<int> candidateIndexes;
+        for (int i = 0; i < uris.count(); i++)
+        {
+            const QString &uri = uris[i];
             // Make sure the client has adequate apparmor permissions to open the URI
-            result = d->request_authenticator->authenticate_open_uri_request(context, uri);
+            const auto result =
+                d->request_authenticator->authenticate_open_uri_request(context, uri);
             if (not std::get<0>(result))
             {
-                err_str = {"Warning: Not adding track " + uri +
+                const QString err_str = {"Warning: Not adding track " + uri +
                     " to TrackList because of inadequate client apparmor permissions."};
-                break;
+                MH_WARNING() << err_str;
+                results.append(mpris::TrackList::Error::InsufficientPermissionsToAddTrack::name);
+                errors.append(err_str);
+                continue;
             }
 
-            trackUris.append(QUrl::fromUserInput(uri));
+            results.append(QString());
+            errors.append(QString());
+            candidates.append(QUrl::fromUserInput(uri));
+            candidateIndexes.append(i);
         }
 
-        // Only add the track to the TrackList if it passes the apparmor permissions check
-        if (std::get<0>(result))
-        {
-            reply = in.createReply();
-            d->m_impl->add_tracks_with_uri_at(trackUris, after);
-        }
-        else
+        // Looking for the files can be slow: do it off the main thread
+        UriBatchCheck::run(candidates, this,
+                           [=](const QVector<bool> &valid) mutable
         {
-            MH_WARNING() << err_str;
-            reply = in.createErrorReply(
-                        mpris::TrackList::Error::InsufficientPermissionsToAddTrack::name,
-                        err_str);
-        }
+            Q_D(TrackListSkeleton);
+            QVector<QUrl> trackUris;
+            for (int i = 0; i < candidates.count(); i++)
+            {
+                if (valid[i])
+                {
+                    trackUris.append(candidates[i]);
+                    continue;
+                }
+
+                const QString err_str = {"Warning: Not adding track " +
+                    candidates[i].toString() +
+                    " to TrackList because it can't be found."};
+                MH_WARNING() << err_str;
+                results[candidateIndexes[i]] = mpris::Player::Error::UriNotFound::name;
+                errors[candidateIndexes[i]] = err_str;
+            }
 
-        bus.send(reply);
+            d->completeAddition(addition, [=]() {
+                Q_D(TrackListSkeleton);
+                /* A single bad URI does not fail the whole batch; but if none
+                 * can be added, report why */
+                if (trackUris.isEmpty() && !results.isEmpty())
+                {
+                    bus.send(in.createErrorReply(results.first(),
+                                                 errors.first()));
+                    return;
+                }
+
+                d->m_impl->add_tracks_with_uri_at(
+                    trackUris, Track::Id::fromString(params.after));
+                bus.send(in.createReply(results));
+            });
+        }, [bus, in]() { sendTrackListGoneReply(bus, in); });
     });
+
+    return QStringList();
 }
 
 void TrackListSkeleton::MoveTrack(const QString &id, const QString &to)
 {
     Q_D(TrackListSkeleton);
     try {
-        const bool ret = d->m_impl->move_track(id, to);
+        const bool ret = d->m_impl->move_track(Track::Id::fromString(id),
+                                               Track::Id::fromString(to));
         if (!ret)
         {
             const QString err_str = {"Error: Not moving track " + id +
@@ -314,7 +476,7 @@ void TrackListSkeleton::RemoveTrack(const QString &id)
 {
     Q_D(TrackListSkeleton);
     try {
-        d->m_impl->remove_track(id);
+        d->m_impl->remove_track(Track::Id::fromString(id));
     } catch(media::TrackList::Errors::TrackNotFound& e) {
         sendErrorReply(
                 mpris::TrackList::Error::TrackNotFound::name,
@@ -325,7 +487,7 @@ void TrackListSkeleton::RemoveTrack(const QString &id)
 void TrackListSkeleton::GoTo(const QString &id)
 {
     Q_D(TrackListSkeleton);
-    d->m_impl->go_to(id);
+    d->m_impl->go_to(Track::Id::fromString(id));
 }
 
 void TrackListSkeleton::Reset()
@@ -27,6 +27,7 @@
 #include <QScopedPointer>
 #include <QStringList>
 #include <QMap>
+#include <QVariantMap>
 
 class QDBusConnection;
 
@@ -60,9 +61,11 @@ public:
     bool canEditTracks() const;
 
 public Q_SLOTS:
+    /* The MPRIS variant: returns the metadata of all the given tracks in
+     * one message; tracks which are not in the list are skipped. */
+    QList<QVariantMap> GetTracksMetadata(const QList<QDBusObjectPath> &ids);
     // FIXME: these should all be QDBusObjectPath, and not QStrings!
-    // FIXME: this should take a list, not just a single track;
-    // and it should return an aa{sv}, not a{ss}
+    // Deprecated: always returns an empty map
     QMap<QString,QString> GetTracksMetadata(const QString &id);
     void AddTrack(const QString &uri, const QString &after, bool makeCurrent);
     void RemoveTrack(const QString &id);
@@ -70,7 +73,12 @@ public Q_SLOTS:
 
     // Not in MPRIS:
     QString GetTracksUri(const QString &id);
-    void AddTracks(const QStringList &uris, const QString &after);
+    /* Returns a list as long as `ids`, with empty strings for the tracks
+     * which are not in the list */
+    QStringList GetTracksUris(const QList<QDBusObjectPath> &ids);
+    /* Returns, for each URI, an empty string if the track was added, or the
+     * name of the error which prevented it */
+    QStringList AddTracks(const QStringList &uris, const QString &after);
     void MoveTrack(const QString &id, const QString &to);
     void Reset();
 
@@ -19,75 +19,281 @@
 #include "track.h"
 #include "xesam.h"
 
+#include <QHash>
+#include <QMutex>
+#include <QSet>
+#include <QStringList>
+
 namespace media = core::ubuntu::media;
 
+namespace {
+
+/* Artist, album and genre names are shared by many tracks, so we keep a
+ * single copy of each. The pool only grows, but its size is bounded by the
+ * size of the user's music collection. */
+QString intern(const QString &s)
+{
+    if (s.isEmpty()) return s;
+
+    static QMutex mutex;
+    static QSet<QString> pool;
+    QMutexLocker locker(&mutex);
+    return *pool.insert(s);
+}
+
+// The keys of the metadata fields, in the order of MetaData::Field
+const QStringList &fieldKeys()
+{
+    static const QStringList keys {
+        xesam::Title::name,
+        xesam::Album::name,
+        xesam::Artist::name,
+        xesam::AlbumArtist::name,
+        xesam::Genre::name,
+        media::Track::MetaData::TrackIdKey,
+        media::Track::MetaData::TrackArtlUrlKey,
+        xesam::LastUsed::name,
+        media::Track::MetaData::TrackLengthKey,
+        xesam::TrackNumber::name,
+        xesam::DiscNumber::name,
+        tags::Image::name,
+        tags::PreviewImage::name,
+    };
+    return keys;
+}
+
+} // namespace
+
+media::Track::MetaData::MetaData():
+    m_length(0),
+    m_trackNumber(0),
+    m_discNumber(0),
+    m_flags(0)
+{
+}
+
+int media::Track::MetaData::fieldFor(const QString &key)
+{
+    static const QHash<QString, int> fields = []() {
+        QHash<QString, int> fields;
+        const QStringList &keys = fieldKeys();
+        for (int field = 0; field < keys.count(); field++) {
+            fields.insert(keys[field], field);
+        }
+        return fields;
+    }();
+    return fields.value(key, -1);
+}
+
+bool media::Track::MetaData::setField(int field, const QVariant &value)
+{
+    if (field < StringFieldCount) {
+        if (value.userType() != QMetaType::QString) return false;
+        const QString s = value.toString();
+        const bool shared =
+            field == Album || field == Artist ||
+            field == AlbumArtist || field == Genre;
+        m_strings[field] = shared ? intern(s) : s;
+        return true;
+    }
+
+    // Keep the types that the tags have, as they are sent over D-Bus
+    switch (field) {
+    case Length:
+        if (value.userType() != QMetaType::LongLong) return false;
+        m_length = value.toLongLong();
+        break;
+    case TrackNumber:
+        if (value.userType() != QMetaType::UInt) return false;
+        m_trackNumber = value.toUInt();
+        break;
+    case DiscNumber:
+        if (value.userType() != QMetaType::UInt) return false;
+        m_discNumber = value.toUInt();
+        break;
+    case Image:
+    case PreviewImage:
+        if (value.userType() != QMetaType::Bool || !value.toBool()) {
+            return false;
+        }
+        break;
+    }
+    m_flags |= 1 << field;
+    return true;
+}
+
+void media::Track::MetaData::clearField(int field)
+{
+    if (field < StringFieldCount) {
+        m_strings[field] = QString();
+    } else {
+        m_flags &= ~(1 << field);
+    }
+}
+
+QVariant media::Track::MetaData::fieldValue(int field) const
+{
+    if (field < StringFieldCount) {
+        const QString &s = m_strings[field];
+        return s.isNull() ? QVariant() : QVariant(s);
+    }
+
+    if (!hasField(field)) return QVariant();
+    switch (field) {
+    case Length: return QVariant(m_length);
+    case TrackNumber: return QVariant(m_trackNumber);
+    case DiscNumber: return QVariant(m_discNumber);
+    default: return QVariant(true);
+    }
+}
+
+media::Track::MetaData
+media::Track::MetaData::fromMap(const QVariantMap &map)
+{
+    MetaData metaData;
+    for (auto i = map.begin(); i != map.end(); i++) {
+        metaData.insert(i.key(), i.value());
+    }
+    return metaData;
+}
+
+QVariantMap media::Track::MetaData::toMap() const
+{
+    QVariantMap map(m_extra);
+    for (int field = 0; field < FieldCount; field++) {
+        const QVariant v = fieldValue(field);
+        if (v.isValid()) {
+            map.insert(fieldKeys()[field], v);
+        }
+    }
+    return map;
+}
+
+bool media::Track::MetaData::isEmpty() const
+{
+    for (const QString &s: m_strings) {
+        if (!s.isNull()) return false;
+    }
+    return m_flags == 0 && m_extra.isEmpty();
+}
+
+bool media::Track::MetaData::contains(const QString &key) const
+{
+    const int field = fieldFor(key);
+    if (field >= 0 && fieldValue(field).isValid()) return true;
+    return m_extra.contains(key);
+}
+
+QVariant media::Track::MetaData::value(const QString &key) const
+{
+    const int field = fieldFor(key);
+    if (field >= 0) {
+        const QVariant v = fieldValue(field);
+        if (v.isValid()) return v;
+    }
+    return m_extra.value(key);
+}
+
+void media::Track::MetaData::insert(const QString &key, const QVariant &value)
+{
+    const int field = fieldFor(key);
+    if (field >= 0) {
+        if (setField(field, value)) {
+            m_extra.remove(key);
+            return;
+        }
+        // Unexpected types are kept as they are
+        clearField(field);
+    }
+    m_extra.insert(key, value);
+}
+
+void media::Track::MetaData::remove(const QString &key)
+{
+    const int field = fieldFor(key);
+    if (field >= 0) clearField(field);
+    m_extra.remove(key);
+}
+
+void media::Track::MetaData::clear()
+{
+    *this = MetaData();
+}
+
+bool media::Track::MetaData::operator==(const MetaData &other) const
+{
+    for (int field = 0; field < FieldCount; field++) {
+        if (fieldValue(field) != other.fieldValue(field)) return false;
+    }
+    return m_extra == other.m_extra;
+}
+
 void media::Track::MetaData::setAlbum(const QString &album)
 {
-    insert(xesam::Album::name, album);
+    m_strings[Album] = intern(album);
 }
 
 void media::Track::MetaData::setArtist(const QString &artist)
 {
-    insert(xesam::Artist::name, artist);
+    m_strings[Artist] = intern(artist);
 }
 
 void media::Track::MetaData::setTitle(const QString &title)
 {
-    insert(xesam::Title::name, title);
+    m_strings[Title] = title;
 }
 
 void media::Track::MetaData::setTrackId(const QString &id)
 {
-    insert(media::Track::MetaData::TrackIdKey, id);
+    m_strings[TrackId] = id;
 }
 
 void media::Track::MetaData::setTrackLength(int64_t length)
 {
-    insert(media::Track::MetaData::TrackLengthKey,
-           QVariant(qint64(length)));
+    setField(Length, QVariant(qint64(length)));
 }
 
 void media::Track::MetaData::setArtUrl(const QUrl &url)
 {
-    insert(media::Track::MetaData::TrackArtlUrlKey, url.toString());
+    m_strings[ArtUrl] = url.toString();
 }
 
 void media::Track::MetaData::setLastUsed(const QString &datetime)
 {
-    insert(xesam::LastUsed::name, datetime);
+    m_strings[LastUsed] = datetime;
 }
 
 QString media::Track::MetaData::album() const
 {
-    return value(xesam::Album::name).toString();
+    return m_strings[Album];
 }
 
 QString media::Track::MetaData::artist() const
 {
-    return value(xesam::Artist::name).toString();
+    return m_strings[Artist];
 }
 
 QString media::Track::MetaData::title() const
 {
-    return value(xesam::Title::name).toString();
+    return m_strings[Title];
 }
 
 QString media::Track::MetaData::trackId() const
 {
-    return value(media::Track::MetaData::TrackIdKey).toString();
+    return m_strings[TrackId];
 }
 
 int64_t media::Track::MetaData::trackLength() const
 {
-    return value(media::Track::MetaData::TrackLengthKey).value<int64_t>();
+    return hasField(Length) ? m_length : 0;
 }
 
 QUrl media::Track::MetaData::artUrl() const
 {
-    return value(media::Track::MetaData::TrackArtlUrlKey).toUrl();
+    return QUrl(m_strings[ArtUrl]);
 }
 
 QString media::Track::MetaData::lastUsed() const
 {
-    return value(xesam::LastUsed::name).toString();
+    return m_strings[LastUsed];
 }
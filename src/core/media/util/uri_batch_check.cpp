@@ -0,0 +1,135 @@
+/*
+ * Copyright © 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "uri_batch_check.h"
+
+#include <QAtomicInt>
+#include <QCoreApplication>
+#include <QFileInfo>
+#include <QMetaObject>
+#include <QPointer>
+#include <QRunnable>
+#include <QSharedPointer>
+#include <QThreadPool>
+
+using namespace core::ubuntu::media;
+
+namespace {
+
+// Number of files checked by a single job
+const int chunkSize = 32;
+
+QThreadPool *threadPool()
+{
+    static QThreadPool *pool = []() {
+        QThreadPool *p = new QThreadPool;
+        /* These threads mostly wait on I/O, so there's no point in tying
+         * their number to the CPUs */
+        p->setMaxThreadCount(
+            qEnvironmentVariableIsSet("MEDIA_HUB_URI_CHECK_THREADS") ?
+            qMax(qEnvironmentVariableIntValue("MEDIA_HUB_URI_CHECK_THREADS"), 1) :
+            4);
+        return p;
+    }();
+    return pool;
+}
+
+struct Batch
+{
+    QVector<QString> paths;
+    // Indexes of the local files in the results vector
+    QVector<int> indexes;
+    QVector<bool> valid;
+    QAtomicInt pendingJobs;
+    QPointer<QObject> context;
+    UriBatchCheck::Callback callback;
+    std::function<void()> cancelled;
+};
+
+bool isPlayableFile(const QString &path)
+{
+    const QFileInfo info(path);
+    // Follows symlinks; directories, devices and sockets can't be played
+    return info.isFile() && info.isReadable();
+}
+
+class CheckJob: public QRunnable
+{
+public:
+    CheckJob(const QSharedPointer<Batch> &batch, int start, int end):
+        m_batch(batch), m_start(start), m_end(end)
+    {
+    }
+
+    void run() override
+    {
+        // Each job writes to its own elements; the vector is never resized
+        bool *valid = m_batch->valid.data();
+        for (int i = m_start; i < m_end; i++) {
+            valid[m_batch->indexes[i]] = isPlayableFile(m_batch->paths[i]);
+        }
+
+        if (!m_batch->pendingJobs.deref()) {
+            QSharedPointer<Batch> batch = m_batch;
+            QMetaObject::invokeMethod(QCoreApplication::instance(), [batch]() {
+                if (batch->context) {
+                    batch->callback(batch->valid);
+                } else if (batch->cancelled) {
+                    batch->cancelled();
+                }
+            }, Qt::QueuedConnection);
+        }
+    }
+
+private:
+    QSharedPointer<Batch> m_batch;
+    int m_start;
+    int m_end;
+};
+
+} // namespace
+
+void UriBatchCheck::run(const QVector<QUrl> &uris, QObject *context,
+                        const Callback &cb,
+                        const std::function<void()> &cancelled)
+{
+    QSharedPointer<Batch> batch = QSharedPointer<Batch>::create();
+    // Remote URIs are always considered valid
+    batch->valid.fill(true, uris.count());
+    for (int i = 0; i < uris.count(); i++) {
+        if (!uris[i].isLocalFile()) continue;
+        batch->paths.append(uris[i].toLocalFile());
+        batch->indexes.append(i);
+    }
+
+    if (batch->paths.isEmpty()) {
+        cb(batch->valid);
+        return;
+    }
+
+    batch->context = context;
+    batch->callback = cb;
+    batch->cancelled = cancelled;
+    const int count = batch->paths.count();
+    const int jobs = (count + chunkSize - 1) / chunkSize;
+    // Set before starting any job, since they might complete right away
+    batch->pendingJobs.store(jobs);
+    for (int start = 0; start < count; start += chunkSize) {
+        threadPool()->start(new CheckJob(batch, start,
+                                         qMin(start + chunkSize, count)));
+    }
+}
@@ -0,0 +1,67 @@
+/*
+ * Copyright © 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef URI_BATCH_CHECK_H_
+#define URI_BATCH_CHECK_H_
+
+#include <QUrl>
+#include <QVector>
+
+#include <functional>
+
+class QObject;
+
+namespace core
+{
+namespace ubuntu
+{
+namespace media
+{
+
+/*
+ * Checks that many local files exist and can be played (readable regular
+ * files), without blocking the caller.
+ *
+ * The files are checked on a dedicated pool of worker threads, so that slow
+ * storage (SD cards, network mounts) does not stall the main loop. The size
+ * of the pool can be set with the MEDIA_HUB_URI_CHECK_THREADS environment
+ * variable.
+ */
+class UriBatchCheck
+{
+public:
+    /* `valid` is as long as the list of checked URIs: an element is false if
+     * the URI refers to a local file which does not exist, is not a regular
+     * file or can't be read. */
+    typedef std::function<void(const QVector<bool> &valid)> Callback;
+
+    /* Invokes `cb` in the main thread once all the URIs have been checked.
+     * If `context` has been destroyed in the meantime, `cancelled` is
+     * invoked instead, so that the caller can still answer whoever is
+     * waiting. If no URI needs to be checked, `cb` is invoked before this
+     * method returns. */
+    static void run(const QVector<QUrl> &uris, QObject *context,
+                    const Callback &cb,
+                    const std::function<void()> &cancelled =
+                        std::function<void()>());
+};
+
+}
+}
+}
+
+#endif // URI_BATCH_CHECK_H_
@@ -18,6 +18,8 @@
 #ifndef CORE_UBUNTU_MEDIA_VIDEO_SOCKET_TYPES_H_
 #define CORE_UBUNTU_MEDIA_VIDEO_SOCKET_TYPES_H_
 
+#include <cstdint>
+
 namespace core
 {
 namespace ubuntu
@@ -27,6 +29,22 @@ namespace media
 namespace video
 {
 
+/*
+ * The server sends two kinds of datagrams to the consumer socket:
+ * - a BufferMetadata, along with the buffer fd as ancillary data, for each
+ *   buffer in the ring of exported buffers; a buffer which is announced
+ *   again with the same index replaces the previous one;
+ * - a FrameReady, without ancillary data, when a new frame can be shown;
+ *   timestamps are -1 when unknown.
+ * The consumer never hands buffers back: it keeps showing the last ready
+ * buffer until the next FrameReady. Tearing is only avoided if the sink
+ * doesn't reuse a buffer before the consumer has moved to a newer one, so
+ * the ring must be deep enough for the consumer's frame latency.
+ */
+
+// Upper bound to the number of buffers in the ring
+const int maxExportedBuffers = 8;
+
 struct BufferMetadata
 {
     int width;
@@ -34,6 +52,8 @@ struct BufferMetadata
     int fourcc;
     int stride;
     int offset;
+    // Position of the buffer in the ring
+    int index;
 };
 
 struct BufferData
@@ -42,6 +62,23 @@ struct BufferData
     BufferMetadata meta;
 };
 
+struct FrameReady
+{
+    // The buffer holding the new frame
+    int32_t index;
+    // Incremented by one for each frame, starting from 0
+    uint32_t sequence;
+    // Presentation time of the frame, in nanoseconds of stream time
+    int64_t pts;
+    // Playback position when the frame was ready, in nanoseconds
+    int64_t position;
+    // Number of frames dropped by the server so far
+    uint64_t dropped;
+    /* How fast the position advances after it was taken: the playback rate
+     * while playing, 0 otherwise */
+    double rate;
+};
+
 }
 }
 }
@@ -26,13 +26,17 @@
 #include <GLES2/gl2.h>
 #include <GLES2/gl2ext.h>
 
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QVector>
+
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/un.h>
 
 #include <sstream>
 #include <thread>
-#include <future>
 #include <cstring>
 #include <unistd.h>
 
@@ -46,11 +50,17 @@ class EglVideoSinkPrivate: public VideoSinkPrivate
 {
     friend class EglVideoSink;
 
-    static bool receive_buff(int socket, BufferData *data)
+    /* Receives the next message from the socket: if it carries a file
+     * descriptor, it's a buffer description, otherwise a frame
+     * notification. */
+    static bool receive_message(int socket, BufferData *data,
+                                FrameReady *frame, bool *is_buffer)
     {
         struct msghdr msg{};
-        struct iovec io = { .iov_base = &data->meta,
-                            .iov_len = sizeof data->meta };
+        char payload[sizeof(BufferMetadata) > sizeof(FrameReady) ?
+                     sizeof(BufferMetadata) : sizeof(FrameReady)];
+        struct iovec io = { .iov_base = payload,
+                            .iov_len = sizeof payload };
         char c_buffer[256];
         ssize_t res;
 
@@ -61,18 +71,38 @@ class EglVideoSinkPrivate: public VideoSinkPrivate
         msg.msg_controllen = sizeof c_buffer;
 
         if ((res = recvmsg(socket, &msg, 0)) == -1) {
-            MH_ERROR("Failed to receive message");
+            MH_ERROR("Failed to receive message: %s (%d)",
+                     strerror(errno), errno);
             return false;
         } else if (res == 0) {
-            MH_ERROR("Socket shutdown while receiving buffer data");
+            MH_DEBUG("Socket shutdown");
             return false;
         }
 
         struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+        *is_buffer = cmsg && cmsg->cmsg_level == SOL_SOCKET &&
+            cmsg->cmsg_type == SCM_RIGHTS;
+        if (!*is_buffer) {
+            if (size_t(res) < sizeof(FrameReady)) {
+                MH_WARNING("Short frame notification (%zd bytes)", res);
+                *frame = FrameReady { 0, 0, -1, -1, 0, 0.0 };
+            } else {
+                memcpy(frame, payload, sizeof(FrameReady));
+            }
+            return true;
+        }
 
         memmove(&data->fd, CMSG_DATA(cmsg), sizeof data->fd);
+        if (size_t(res) < sizeof(BufferMetadata)) {
+            MH_ERROR("Short buffer description (%zd bytes)", res);
+            close(data->fd);
+            data->fd = -1;
+            return true;
+        }
+        memcpy(&data->meta, payload, sizeof(BufferMetadata));
 
         MH_DEBUG("Extracted fd %d", data->fd);
+        MH_DEBUG("index    %d", data->meta.index);
         MH_DEBUG("width    %d", data->meta.width);
         MH_DEBUG("height   %d", data->meta.height);
         MH_DEBUG("fourcc 0x%X", data->meta.fourcc);
@@ -84,14 +114,13 @@ class EglVideoSinkPrivate: public VideoSinkPrivate
 
     static void read_sock_events(PlayerKey key,
                                  int sock_fd,
-                                 promise<BufferData>& prom_buff,
+                                 EglVideoSinkPrivate *d,
                                  EglVideoSink *q)
     {
         static const char *consumer_socket = "media-consumer";
 
         struct sockaddr_un local;
         int len;
-        BufferData buff_data;
 
         if (sock_fd == -1) {
             MH_ERROR("Cannot create buffer consumer socket: %s (%d)",
@@ -111,28 +140,39 @@ class EglVideoSinkPrivate: public VideoSinkPrivate
             return;
         }
 
-        // Wait for buffer descriptions, pass them to rendering thread
-        if (!receive_buff(sock_fd, &buff_data))
-            return;
-
-        prom_buff.set_value(buff_data);
-
-        // Now signal frame syncs
-        while(true) {
-            ssize_t res;
-            char c;
-
-            res = recv(sock_fd, &c, sizeof c, 0);
-            if (res == -1) {
-                MH_ERROR("while waiting sync: %s (%d)",
-                         strerror(errno), errno);
+        /* Buffer descriptions are handed to the rendering thread, which
+         * imports them; frame notifications just tell it which one to show */
+        while (true) {
+            BufferData buff_data;
+            FrameReady frame;
+            bool is_buffer;
+            if (!receive_message(sock_fd, &buff_data, &frame, &is_buffer))
                 return;
-            } else if (res == 0) {
-                MH_DEBUG("Socket shutdown");
-                return;
-            }
 
-            Q_EMIT q->frameAvailable();
+            if (is_buffer) {
+                if (buff_data.fd == -1) continue;
+                if (buff_data.meta.index < 0 ||
+                    buff_data.meta.index >= maxExportedBuffers) {
+                    MH_ERROR("Buffer index %d out of range",
+                             buff_data.meta.index);
+                    close(buff_data.fd);
+                    continue;
+                }
+                QMutexLocker locker(&d->pending_lock);
+                d->pending_buffers.append(buff_data);
+            } else {
+                if (frame.index < 0 || frame.index >= maxExportedBuffers) {
+                    MH_ERROR("Frame index %d out of range", frame.index);
+                    continue;
+                }
+                {
+                    QMutexLocker locker(&d->pending_lock);
+                    d->ready_frame = frame;
+                    d->ready_timer.start();
+                    d->has_ready_frame = true;
+                }
+                Q_EMIT q->frameAvailable();
+            }
         }
     }
 
@@ -156,13 +196,9 @@ public:
     EglVideoSinkPrivate(uint32_t gl_texture, PlayerKey key,
                         EglVideoSink *q):
         gl_texture{gl_texture},
-        prom_buff{},
-        fut_buff{prom_buff.get_future()},
-        sock_fd{socket(AF_UNIX, SOCK_DGRAM, 0)},
-        sock_thread{read_sock_events, key, sock_fd,
-            ref(prom_buff), q},
-        egl_image{EGL_NO_IMAGE_KHR},
-        buf_fd{-1}
+        has_ready_frame{false},
+        bound_index{-1},
+        sock_fd{socket(AF_UNIX, SOCK_DGRAM, 0)}
     {
         const char *extensions;
         const char *egl_needed[] = {"EGL_KHR_image_base",
@@ -210,21 +246,60 @@ public:
         if (_eglCreateImageKHR == nullptr || _eglDestroyImageKHR == nullptr ||
             _glEGLImageTargetTexture2DOES == nullptr)
             throw runtime_error {"Error when loading extensions"};
+
+        // Only start reading once everything is set up
+        sock_thread = thread{read_sock_events, key, sock_fd, this, q};
     }
 
     ~EglVideoSinkPrivate()
     {
         if (sock_fd != -1) {
             shutdown(sock_fd, SHUT_RDWR);
-            sock_thread.join();
+            if (sock_thread.joinable())
+                sock_thread.join();
             close(sock_fd);
         }
 
-        if (buf_fd != -1)
-            close(buf_fd);
+        for (const BufferData &buf_data: pending_buffers)
+            close(buf_data.fd);
 
-        if (egl_image != EGL_NO_IMAGE_KHR)
-            _eglDestroyImageKHR(eglGetCurrentDisplay(), egl_image);
+        for (int i = 0; i < buffers.count(); i++)
+            release_buffer(i);
+    }
+
+    void release_buffer(int index)
+    {
+        ImportedBuffer &buffer = buffers[index];
+        if (buffer.egl_image != EGL_NO_IMAGE_KHR) {
+            _eglDestroyImageKHR(eglGetCurrentDisplay(), buffer.egl_image);
+            buffer.egl_image = EGL_NO_IMAGE_KHR;
+        }
+        if (buffer.fd != -1) {
+            close(buffer.fd);
+            buffer.fd = -1;
+        }
+        if (bound_index == index)
+            bound_index = -1;
+    }
+
+    // Imports the buffers received since the last call
+    void import_pending_buffers()
+    {
+        QVector<BufferData> received;
+        {
+            QMutexLocker locker(&pending_lock);
+            if (pending_buffers.isEmpty()) return;
+            received.swap(pending_buffers);
+        }
+
+        for (const BufferData &buf_data: received) {
+            const int index = buf_data.meta.index;
+            if (index >= buffers.count())
+                buffers.resize(index + 1);
+            // The producer has reallocated this buffer
+            release_buffer(index);
+            import_buffer(&buf_data);
+        }
     }
 
     // This imports dma_buf buffers by using the EGL_EXT_image_dma_buf_import
@@ -233,7 +308,6 @@ public:
     // to the app texture by using GL_OES_EGL_image_external extension.
     bool import_buffer(const BufferData *buf_data)
     {
-        GLenum err;
         EGLDisplay egl_display = eglGetCurrentDisplay();
         EGLint image_attrs[] = {
             EGL_WIDTH, buf_data->meta.width,
@@ -245,33 +319,54 @@ public:
             EGL_NONE
         };
 
-        buf_fd = buf_data->fd;
-        egl_image = _eglCreateImageKHR(egl_display, EGL_NO_CONTEXT,
-                                       EGL_LINUX_DMA_BUF_EXT, NULL, image_attrs);
-        if (egl_image == EGL_NO_IMAGE_KHR) {
+        ImportedBuffer &buffer = buffers[buf_data->meta.index];
+        buffer.fd = buf_data->fd;
+        buffer.egl_image = _eglCreateImageKHR(egl_display, EGL_NO_CONTEXT,
+                                              EGL_LINUX_DMA_BUF_EXT, NULL,
+                                              image_attrs);
+        if (buffer.egl_image == EGL_NO_IMAGE_KHR) {
             MH_ERROR("eglCreateImageKHR error 0x%X", eglGetError());
             return false;
         }
 
-        // TODO Do this when swapping if we end up importing more than one buffer
+        MH_DEBUG("Image %d successfully imported", buf_data->meta.index);
+
+        return true;
+    }
+
+    // Points the app texture to the buffer; this is cheap, as no data is copied
+    void bind_buffer(int index)
+    {
+        GLenum err;
+
         glBindTexture(GL_TEXTURE_2D, gl_texture);
-        _glEGLImageTargetTexture2DOES(GL_TEXTURE_2D, egl_image);
+        _glEGLImageTargetTexture2DOES(GL_TEXTURE_2D, buffers[index].egl_image);
 
         while((err = glGetError()) != GL_NO_ERROR)
             MH_WARNING("OpenGL error 0x%X", err);
 
-        MH_DEBUG("Image successfully imported");
-
-        return true;
+        bound_index = index;
     }
 
+    struct ImportedBuffer
+    {
+        int fd = -1;
+        EGLImageKHR egl_image = EGL_NO_IMAGE_KHR;
+    };
+
     uint32_t gl_texture;
-    promise<BufferData> prom_buff;
-    future<BufferData> fut_buff;
+    // Written by the socket thread, read by the rendering thread
+    QMutex pending_lock;
+    QVector<BufferData> pending_buffers;
+    FrameReady ready_frame;
+    // Started when ready_frame was received
+    QElapsedTimer ready_timer;
+    bool has_ready_frame;
+    // Only accessed by the rendering thread, indexed by buffer index
+    QVector<ImportedBuffer> buffers;
+    int bound_index;
     int sock_fd;
     thread sock_thread;
-    EGLImageKHR egl_image;
-    int buf_fd;
     PFNEGLCREATEIMAGEKHRPROC _eglCreateImageKHR;
     PFNEGLDESTROYIMAGEKHRPROC _eglDestroyImageKHR;
     PFNGLEGLIMAGETARGETTEXTURE2DOESPROC _glEGLImageTargetTexture2DOES;
@@ -302,15 +397,32 @@ bool EglVideoSink::swapBuffers()
 {
     Q_D(EglVideoSink);
 
-    // First time called, import buffers
-    if (d->egl_image == EGL_NO_IMAGE_KHR) {
-        BufferData buf_data = d->fut_buff.get();
-        if (!d->import_buffer(&buf_data))
-            return false;
+    d->import_pending_buffers();
+
+    FrameReady frame;
+    qint64 since_ready;
+    {
+        QMutexLocker locker(&d->pending_lock);
+        if (!d->has_ready_frame) return false;
+        frame = d->ready_frame;
+        since_ready = d->ready_timer.nsecsElapsed();
     }
 
-    // We need to do nothing here, as the only buffer has already been mapped.
-    // TODO Change when we implement a buffer queue.
+    const int index = frame.index;
+    if (index >= d->buffers.count() ||
+        d->buffers[index].egl_image == EGL_NO_IMAGE_KHR)
+        return false;
 
+    // The image of each buffer is created once, and reused afterwards
+    if (index != d->bound_index)
+        d->bind_buffer(index);
+
+    d->m_frameStatistics.framePresented({
+        frame.sequence,
+        frame.pts,
+        frame.position,
+        frame.rate,
+        frame.dropped,
+    }, since_ready);
     return true;
 }
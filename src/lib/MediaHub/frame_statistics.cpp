@@ -0,0 +1,91 @@
+/*
+ * Copyright © 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "frame_statistics.h"
+
+#include <QMutexLocker>
+
+using namespace lomiri::MediaHub;
+
+namespace {
+
+/* A frame is late if, when it is presented, the playback position is
+ * already past its presentation time by this much (in nanoseconds) */
+const qint64 lateThreshold = 20 * 1000 * 1000;
+
+} // namespace
+
+void FrameStatistics::framePresented(const Frame &frame, qint64 sinceReady)
+{
+    QMutexLocker locker(&m_lock);
+
+    if (m_hasRendered) {
+        if (frame.sequence == m_lastSequence) return;
+
+        /* The sequence restarts from 0 when the service resets the
+         * pipeline: that's not a gap */
+        const quint32 gap = frame.sequence - m_lastSequence;
+        if (gap > 1 && gap < 0x80000000u) {
+            m_skippedFrames += gap - 1;
+        }
+    }
+    m_hasRendered = true;
+    m_lastSequence = frame.sequence;
+    m_renderedFrames++;
+    m_serviceDroppedFrames = frame.serviceDropped;
+
+    m_presentationTime = frame.pts >= 0 ? frame.pts / 1000 : -1;
+    if (frame.pts >= 0 && frame.position >= 0) {
+        // Where the playback got to while the frame waited to be shown
+        const qint64 position =
+            frame.position + qint64(qMax<qint64>(sinceReady, 0) * frame.rate);
+        const qint64 drift = position - frame.pts;
+        m_avSyncDrift = drift / 1000;
+        if (drift > lateThreshold) {
+            m_lateFrames++;
+        }
+    }
+}
+
+qint64 FrameStatistics::presentationTime() const
+{
+    QMutexLocker locker(&m_lock);
+    return m_presentationTime;
+}
+
+quint64 FrameStatistics::renderedFrames() const
+{
+    QMutexLocker locker(&m_lock);
+    return m_renderedFrames;
+}
+
+quint64 FrameStatistics::lateFrames() const
+{
+    QMutexLocker locker(&m_lock);
+    return m_lateFrames;
+}
+
+quint64 FrameStatistics::droppedFrames() const
+{
+    QMutexLocker locker(&m_lock);
+    return m_skippedFrames + m_serviceDroppedFrames;
+}
+
+qint64 FrameStatistics::avSyncDrift() const
+{
+    QMutexLocker locker(&m_lock);
+    return m_avSyncDrift;
+}
@@ -0,0 +1,70 @@
+/*
+ * Copyright © 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LOMIRI_MEDIAHUB_FRAME_STATISTICS_H
+#define LOMIRI_MEDIAHUB_FRAME_STATISTICS_H
+
+#include <QMutex>
+
+namespace lomiri {
+namespace MediaHub {
+
+/* Timing statistics of the frames presented by a video sink. They are
+ * updated by the rendering thread, and can be read from any thread. */
+class FrameStatistics
+{
+public:
+    struct Frame
+    {
+        quint32 sequence;
+        // All in nanoseconds, -1 if unknown
+        qint64 pts;
+        // Playback position when the service reported the frame as ready
+        qint64 position;
+        // How fast the position advances; 0 when not playing
+        double rate;
+        // Frames dropped by the service so far
+        quint64 serviceDropped;
+    };
+
+    /* Called when `frame` is presented, `sinceReady` nanoseconds after the
+     * service reported it as ready */
+    void framePresented(const Frame &frame, qint64 sinceReady);
+
+    // In microseconds, -1 if unknown
+    qint64 presentationTime() const;
+    quint64 renderedFrames() const;
+    quint64 lateFrames() const;
+    quint64 droppedFrames() const;
+    // In microseconds
+    qint64 avSyncDrift() const;
+
+private:
+    mutable QMutex m_lock;
+    bool m_hasRendered = false;
+    quint32 m_lastSequence = 0;
+    qint64 m_presentationTime = -1;
+    qint64 m_avSyncDrift = 0;
+    quint64 m_renderedFrames = 0;
+    quint64 m_lateFrames = 0;
+    quint64 m_skippedFrames = 0;
+    quint64 m_serviceDroppedFrames = 0;
+};
+
+} // namespace MediaHub
+} // namespace lomiri
+
+#endif // LOMIRI_MEDIAHUB_FRAME_STATISTICS_H
@@ -39,6 +39,8 @@
 #include <QDebug>
 #include <functional>
 
+#include <time.h>
+
 using namespace lomiri::MediaHub;
 
 typedef std::function<void(const QDBusMessage &)> MethodCb;
@@ -69,6 +71,7 @@ public Q_SLOTS:
                              const QStringList &invalidated);
     void onVideoDimensionChanged(quint32 height, quint32 width);
     void onError(quint16 code);
+    void onPositionAnchor(qint64 position, qint64 timestamp, double rate);
 
 private:
     PlayerPrivate *d;
@@ -89,6 +92,8 @@ public:
     void updateProperties(const QVariantMap &properties);
     void onVideoDimensionChanged(quint32 height, quint32 width);
     void onError(quint16 dbusCode);
+    void onPositionAnchor(qint64 position, qint64 timestamp, double rate);
+    quint64 extrapolatedPosition() const;
     void watchErrors(const QDBusPendingCall &call);
     void onSuccessfulCompletion(const QDBusPendingCall &call,
                                 MethodCb callback);
@@ -125,6 +130,15 @@ private:
 
     Player::PlaybackStatus m_playbackStatus = Player::Null;
 
+    struct PositionAnchor {
+        qint64 position = 0;
+        qint64 timestamp = -1; // CLOCK_MONOTONIC, in nanoseconds
+        double rate = 0.0;
+        bool isValid() const { return timestamp >= 0; }
+    };
+    int m_positionUpdateInterval = -1;
+    PositionAnchor m_positionAnchor;
+
     AVBackend::Backend m_backend = AVBackend::Backend::None;
     QHash<quint32, VideoSink*> m_videoSinks;
 
@@ -192,6 +206,12 @@ void DBusPlayer::onError(quint16 code)
     d->onError(code);
 }
 
+void DBusPlayer::onPositionAnchor(qint64 position, qint64 timestamp,
+                                  double rate)
+{
+    d->onPositionAnchor(position, timestamp, rate);
+}
+
 PlayerPrivate::PlayerPrivate(Player *q):
     m_serviceWatcher(m_service.service(), m_service.connection()),
     q_ptr(q)
@@ -218,6 +238,9 @@ PlayerPrivate::PlayerPrivate(Player *q):
     QObject::connect(&m_serviceWatcher,
                      &QDBusServiceWatcher::serviceUnregistered,
                      q, &Player::serviceDisconnected);
+    QObject::connect(&m_serviceWatcher,
+                     &QDBusServiceWatcher::serviceUnregistered,
+                     q, [this]() { m_positionAnchor = PositionAnchor(); });
 
     QDBusConnection c(m_service.connection());
 
@@ -240,6 +263,8 @@ PlayerPrivate::PlayerPrivate(Player *q):
               m_proxy.data(), SLOT(onError(quint16)));
     c.connect(service, path, interface, QStringLiteral("Buffering"),
               q, SLOT(bufferingChanged(int)));
+    c.connect(service, path, interface, QStringLiteral("PositionAnchor"),
+              m_proxy.data(), SLOT(onPositionAnchor(qint64,qint64,double)));
 
     // Blocking call to get the initial properties
     QDBusMessage msg = QDBusMessage::createMethodCall(
@@ -326,6 +351,15 @@ void PlayerPrivate::updateProperties(const QVariantMap &properties)
             m_orientation =
                 static_cast<Player::Orientation>(i.value().toInt());
             Q_EMIT q->orientationChanged();
+        } else if (name == "PlaybackRate") {
+            m_playbackRate = i.value().toDouble();
+            Q_EMIT q->playbackRateChanged();
+        } else if (name == "MinimumRate") {
+            m_minimumPlaybackRate = i.value().toDouble();
+            Q_EMIT q->minimumPlaybackRateChanged();
+        } else if (name == "MaximumRate") {
+            m_maximumPlaybackRate = i.value().toDouble();
+            Q_EMIT q->maximumPlaybackRateChanged();
         } else if (name == "TypedBackend") {
             m_backend =
                 static_cast<AVBackend::Backend>(i.value().toInt());
@@ -355,6 +389,28 @@ void PlayerPrivate::onError(quint16 dbusCode)
     }
 }
 
+void PlayerPrivate::onPositionAnchor(qint64 position, qint64 timestamp,
+                                     double rate)
+{
+    Q_Q(Player);
+    if (m_positionUpdateInterval < 0) return;
+
+    m_positionAnchor.position = position;
+    m_positionAnchor.timestamp = timestamp;
+    m_positionAnchor.rate = rate;
+    Q_EMIT q->positionChanged(position);
+}
+
+quint64 PlayerPrivate::extrapolatedPosition() const
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    const qint64 now = qint64(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+    const qint64 position = m_positionAnchor.position +
+        qint64((now - m_positionAnchor.timestamp) * m_positionAnchor.rate);
+    return position > 0 ? position : 0;
+}
+
 void PlayerPrivate::watchErrors(const QDBusPendingCall &call)
 {
     Q_Q(Player);
@@ -556,6 +612,13 @@ void Player::seekTo(uint64_t microseconds)
     d->call(QStringLiteral("Seek"), quint64(microseconds));
 }
 
+void Player::seekTo(uint64_t microseconds, SeekMode mode)
+{
+    Q_D(Player);
+    d->call(QStringLiteral("SeekWithMode"), quint64(microseconds),
+            qint16(mode));
+}
+
 bool Player::canPlay() const
 {
     Q_D(const Player);
@@ -665,9 +728,36 @@ Player::PlaybackRate Player::maximumPlaybackRate() const
 quint64 Player::position() const
 {
     Q_D(const Player);
+    if (d->m_positionAnchor.isValid()) {
+        return d->extrapolatedPosition();
+    }
     return d->getProperty(QStringLiteral("Position")).toULongLong();
 }
 
+void Player::setPositionUpdateInterval(int msecs)
+{
+    Q_D(Player);
+    // The service applies the same bounds
+    if (msecs < 0) msecs = -1;
+    else if (msecs > 0) msecs = qMax(msecs, 10);
+    if (msecs == d->m_positionUpdateInterval) return;
+
+    /* Set it right away, since the service will emit the first anchor
+     * before replying to our call */
+    d->m_positionUpdateInterval = msecs;
+    if (msecs < 0) {
+        d->m_positionAnchor = PlayerPrivate::PositionAnchor();
+    }
+    d->setProperty(QStringLiteral("PositionUpdateInterval"), msecs);
+    Q_EMIT positionUpdateIntervalChanged();
+}
+
+int Player::positionUpdateInterval() const
+{
+    Q_D(const Player);
+    return d->m_positionUpdateInterval;
+}
+
 quint64 Player::duration() const
 {
     Q_D(const Player);
@@ -67,6 +67,9 @@ class MH_EXPORT Player: public QObject
                NOTIFY maximumPlaybackRateChanged)
 
     Q_PROPERTY(quint64 position READ position NOTIFY positionChanged)
+    Q_PROPERTY(int positionUpdateInterval READ positionUpdateInterval
+               WRITE setPositionUpdateInterval
+               NOTIFY positionUpdateIntervalChanged)
     Q_PROPERTY(quint64 duration READ duration NOTIFY durationChanged)
     Q_PROPERTY(Orientation orientation READ orientation
                NOTIFY orientationChanged)
@@ -111,6 +114,17 @@ public:
     };
     Q_ENUM(AudioStreamRole)
 
+    /**
+     * Fast seeks land on the closest key frame, which is cheap but not
+     * exact: they are suitable while the user is dragging a slider.
+     * Accurate seeks land exactly on the requested position.
+     */
+    enum SeekMode {
+        FastSeek,
+        AccurateSeek,
+    };
+    Q_ENUM(SeekMode)
+
     enum Orientation {
         Rotate0,
         Rotate90,
@@ -146,6 +160,7 @@ public:
     void pause();
     void stop();
     void seekTo(uint64_t microseconds);
+    void seekTo(uint64_t microseconds, SeekMode mode);
 
     /*
      * Property accessors
@@ -170,6 +185,19 @@ public:
     PlaybackRate minimumPlaybackRate() const;
     PlaybackRate maximumPlaybackRate() const;
     quint64 position() const;
+    /*
+     * By default, position() queries the service every time it's called.
+     * If the interval is set to a non negative value, the service pushes
+     * the position along with the current playback rate, and position()
+     * extrapolates it locally without any D-Bus traffic; the
+     * positionChanged() signal is then emitted whenever the playback state
+     * changes and, if the interval is greater than zero, every `msecs`
+     * milliseconds while playing. Intervals shorter than 10 ms are raised
+     * to 10 ms. The setting only affects this client, even if the player
+     * session is shared with others.
+     */
+    void setPositionUpdateInterval(int msecs);
+    int positionUpdateInterval() const;
     quint64 duration() const;
     Orientation orientation() const;
     void setLoopStatus(LoopStatus loopStatus);
@@ -190,6 +218,7 @@ Q_SIGNALS:
     void minimumPlaybackRateChanged();
     void maximumPlaybackRateChanged();
     void positionChanged(quint64 microseconds);
+    void positionUpdateIntervalChanged();
     void durationChanged(quint64 microseconds);
     void audioStreamRoleChanged();
     void orientationChanged();
@@ -30,6 +30,7 @@ namespace lomiri {
 namespace MediaHub {
 
 class Track;
+class TrackListPrivate;
 
 class TrackData: public QSharedData
 {
@@ -39,6 +40,7 @@ public:
 private:
     friend class Track;
     QUrl m_uri;
+    QVariantMap m_metaData;
 };
 
 class MH_EXPORT Track
@@ -58,7 +60,13 @@ public:
 
     QUrl uri() const { return d->m_uri; }
 
+    /** Empty until fetched with TrackList::fetchMetaData() */
+    MetaData metaData() const { return d->m_metaData; }
+
 private:
+    friend class TrackListPrivate;
+    void setMetaData(const QVariantMap &metaData) { d->m_metaData = metaData; }
+
     QSharedDataPointer<TrackData> d;
 };
 
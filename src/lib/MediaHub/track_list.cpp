@@ -19,16 +19,30 @@
 #include "track_list_p.h"
 
 #include "dbus_constants.h"
-#include "dbus_utils.h"
+#include "error_p.h"
 
 #include <QDBusAbstractInterface>
+#include <QDBusMetaType>
+#include <QDBusObjectPath>
 #include <QDBusPendingCall>
 #include <QDBusPendingCallWatcher>
 #include <QDBusPendingReply>
 #include <QDebug>
+#include <QEventLoop>
 
 using namespace lomiri::MediaHub;
 
+namespace {
+
+/* Number of tracks whose metadata is retrieved with a single D-Bus call */
+const int metaDataPageSize = 50;
+
+/* Prefix of the local IDs given to the tracks added optimistically; it's not
+ * a valid object path, so it cannot clash with the IDs from the service */
+const char placeholderPrefix[] = "pending:";
+
+} // namespace
+
 class DBusTrackList: public QDBusAbstractInterface
 {
     Q_OBJECT
@@ -46,6 +60,11 @@ private Q_SLOTS:
     void onTrackRemoved(const QString &id) { d->onTrackRemoved(id); }
     void onTrackListReset() { d->onTrackListReset(); }
     void onTrackChanged(const QString &id) { d->onTrackChanged(id); }
+    void onTrackMetadataChanged(QVariantMap metaData,
+                                const QDBusObjectPath &id) {
+        metaData.insert(Track::MetaData::TrackIdKey, QVariant::fromValue(id));
+        d->onTracksMetaData({ metaData });
+    }
 
 private:
     TrackListPrivate *d;
@@ -75,6 +94,10 @@ DBusTrackList::DBusTrackList(const QDBusConnection &conn,
 
     c.connect(service(), path, interface(), QStringLiteral("TrackChanged"),
               this, SLOT(onTrackChanged(QString)));
+    // Emitted by the service as the metadata of the queued tracks is read
+    c.connect(service(), path, interface(),
+              QStringLiteral("TrackMetadataChanged"),
+              this, SLOT(onTrackMetadataChanged(QVariantMap,QDBusObjectPath)));
 
     // Blocking call to get the initial properties
     QDBusMessage msg = QDBusMessage::createMethodCall(
@@ -93,11 +116,86 @@ DBusTrackList::DBusTrackList(const QDBusConnection &conn,
     }
 }
 
+namespace lomiri {
+namespace MediaHub {
+
+class TrackListOperationPrivate
+{
+    Q_DECLARE_PUBLIC(TrackListOperation)
+
+public:
+    TrackListOperationPrivate(TrackListOperation *q):
+        m_finished(false),
+        q_ptr(q)
+    {
+    }
+
+    void finish(const Error &error = Error());
+
+private:
+    bool m_finished;
+    Error m_error;
+    TrackListOperation *q_ptr;
+};
+
+}} // namespace
+
+void TrackListOperationPrivate::finish(const Error &error)
+{
+    Q_Q(TrackListOperation);
+
+    if (m_finished) return;
+    m_finished = true;
+    m_error = error;
+
+    /* Always emit the signal asynchronously, so that the client has a chance
+     * to connect to it even if the operation failed right away */
+    QMetaObject::invokeMethod(q, [q]() {
+        Q_EMIT q->finished();
+        q->deleteLater();
+    }, Qt::QueuedConnection);
+}
+
+TrackListOperation::TrackListOperation(QObject *parent):
+    QObject(parent),
+    d_ptr(new TrackListOperationPrivate(this))
+{
+}
+
+TrackListOperation::~TrackListOperation() = default;
+
+bool TrackListOperation::isFinished() const
+{
+    Q_D(const TrackListOperation);
+    return d->m_finished;
+}
+
+Error TrackListOperation::error() const
+{
+    Q_D(const TrackListOperation);
+    return d->m_error;
+}
+
+bool TrackListOperation::waitForFinished()
+{
+    Q_D(TrackListOperation);
+    if (!d->m_finished) {
+        QEventLoop loop;
+        QObject::connect(this, &TrackListOperation::finished,
+                         &loop, &QEventLoop::quit);
+        loop.exec(QEventLoop::ExcludeUserInputEvents);
+    }
+    return !d->m_error.isError();
+}
+
 TrackListPrivate::TrackListPrivate(TrackList *q):
     m_canEditTracks(true),
     m_currentTrack(-1),
+    m_placeholderCounter(0),
+    m_expectedResets(0),
     q_ptr(q)
 {
+    qDBusRegisterMetaType<QList<QVariantMap>>();
 }
 
 void TrackListPrivate::createProxy(const QDBusConnection &conn,
@@ -129,70 +227,416 @@ void TrackListPrivate::initialize(const QVariantMap &properties)
     // The tracklist is always empty here, no need to retrieve it
 }
 
-void TrackListPrivate::addTrackWithUriAt(const QUrl &uri, int position,
-                                         bool makeCurrent)
+TrackListOperation *TrackListPrivate::addTrackWithUriAt(const QUrl &uri,
+                                                        int position,
+                                                        bool makeCurrent,
+                                                        bool optimistic)
 {
-    if (!ensureProxy()) return;
-
-    QDBusPendingCall call =
-        m_proxy->asyncCall(QStringLiteral("AddTrack"),
-                           uri.toString(), remotePos(position), makeCurrent);
-    m_indexForNextAddition = position;
-    m_urisForNextAddition = { uri };
-    DBusUtils::waitForFinished(call);
+    return enqueueAddition(QStringLiteral("AddTrack"),
+                           { uri.toString(), remotePos(position), makeCurrent },
+                           { uri }, position, optimistic);
 }
 
-void TrackListPrivate::addTracksWithUriAt(const QVector<QUrl> &uris,
-                                          int position)
+TrackListOperation *TrackListPrivate::addTracksWithUriAt(
+        const QVector<QUrl> &uris, int position, bool optimistic)
 {
-    if (!ensureProxy()) return;
-
     QStringList urisAsStrings;
     for (const QUrl &uri: uris) {
         urisAsStrings.append(uri.toString());
     }
-    QDBusPendingCall call =
-        m_proxy->asyncCall(QStringLiteral("AddTracks"),
-                           urisAsStrings, remotePos(position));
-    m_indexForNextAddition = position;
-    m_urisForNextAddition = uris;
-    DBusUtils::waitForFinished(call);
+    return enqueueAddition(QStringLiteral("AddTracks"),
+                           { urisAsStrings, remotePos(position) },
+                           uris, position, optimistic);
 }
 
-void TrackListPrivate::moveTrack(int index, int to)
+TrackListOperation *TrackListPrivate::moveTrack(int index, int to,
+                                                bool optimistic)
 {
-    if (!ensureProxy()) return;
+    Q_Q(TrackList);
 
-    QDBusPendingCall call =
-        m_proxy->asyncCall(QStringLiteral("MoveTrack"),
-                           remotePos(index), remotePos(to));
-    DBusUtils::waitForFinished(call);
+    if (!ensureProxy()) return disconnectedOperation();
+
+    const QString id = remotePos(index);
+    const QString toId = remotePos(to);
+    optimistic = optimistic &&
+        index >= 0 && index < m_trackIds.count() &&
+        to >= 0 && to < m_trackIds.count();
+    TrackListOperation *operation =
+        enqueueCall(QStringLiteral("MoveTrack"), { id, toId }, { 0, 1 },
+                    optimistic);
+    if (optimistic) {
+        m_expectedMoves.enqueue(qMakePair(id, toId));
+        m_trackIds.move(index, to);
+        m_tracks.move(index, to);
+        Q_EMIT q->trackMoved(index, to);
+    }
+    sendPendingCalls();
+    return operation;
 }
 
-void TrackListPrivate::removeTrack(int index)
+TrackListOperation *TrackListPrivate::removeTrack(int index, bool optimistic)
 {
-    if (!ensureProxy()) return;
+    Q_Q(TrackList);
 
-    QDBusPendingCall call =
-        m_proxy->asyncCall(QStringLiteral("RemoveTrack"), remotePos(index));
-    DBusUtils::waitForFinished(call);
+    if (!ensureProxy()) return disconnectedOperation();
+
+    const QString id = remotePos(index);
+    optimistic = optimistic && index >= 0 && index < m_trackIds.count();
+    TrackListOperation *operation =
+        enqueueCall(QStringLiteral("RemoveTrack"), { id }, { 0 }, optimistic);
+    if (optimistic) {
+        // The TrackRemoved signal will then find nothing to remove
+        m_trackIds.remove(index);
+        m_tracks.remove(index);
+        m_metaDataRequested.remove(id);
+        Q_EMIT q->trackRemoved(index);
+    }
+    sendPendingCalls();
+    return operation;
 }
 
-void TrackListPrivate::goTo(int index)
+TrackListOperation *TrackListPrivate::goTo(int index, bool optimistic)
 {
-    if (!ensureProxy()) return;
+    Q_Q(TrackList);
+
+    if (!ensureProxy()) return disconnectedOperation();
+
+    optimistic = optimistic && index >= 0 && index < m_trackIds.count();
+    TrackListOperation *operation =
+        enqueueCall(QStringLiteral("GoTo"), { remotePos(index) }, { 0 },
+                    optimistic);
+    if (optimistic && index != m_currentTrack) {
+        m_currentTrack = index;
+        Q_EMIT q->currentTrackChanged();
+    }
+    sendPendingCalls();
+    return operation;
+}
+
+TrackListOperation *TrackListPrivate::reset(bool optimistic)
+{
+    Q_Q(TrackList);
+
+    if (!ensureProxy()) return disconnectedOperation();
+
+    TrackListOperation *operation =
+        enqueueCall(QStringLiteral("Reset"), {}, {}, optimistic);
+    if (optimistic) {
+        m_expectedResets++;
+        m_trackIds.clear();
+        m_tracks.clear();
+        m_metaDataRequested.clear();
+        m_currentTrack = -1;
+        Q_EMIT q->trackListReset();
+    }
+    sendPendingCalls();
+    return operation;
+}
+
+bool TrackListPrivate::isPlaceholder(const QString &id)
+{
+    return id.startsWith(QLatin1String(placeholderPrefix));
+}
+
+QString TrackListPrivate::resolvedId(const QString &id) const
+{
+    return isPlaceholder(id) ? m_resolvedIds.value(id) : id;
+}
+
+TrackListOperation *TrackListPrivate::disconnectedOperation()
+{
+    Q_Q(TrackList);
+    auto operation = new TrackListOperation(q);
+    operation->d_ptr->finish(Error(Error::ServiceMissingError,
+                                   QStringLiteral("Track list not connected")));
+    return operation;
+}
+
+TrackListOperation *TrackListPrivate::enqueueCall(const QString &method,
+                                                  const QVariantList &args,
+                                                  const QVector<int> &idArgs,
+                                                  bool optimistic)
+{
+    Q_Q(TrackList);
+    auto operation = new TrackListOperation(q);
+    m_pendingCalls.enqueue({ method, args, idArgs, optimistic, operation });
+    return operation;
+}
+
+TrackListOperation *TrackListPrivate::enqueueAddition(const QString &method,
+                                                      const QVariantList &args,
+                                                      const QVector<QUrl> &uris,
+                                                      int position,
+                                                      bool optimistic)
+{
+    Q_Q(TrackList);
+
+    if (!ensureProxy()) return disconnectedOperation();
+
+    // In both AddTrack and AddTracks, the second argument is the position
+    Addition addition {
+        position, uris, {}, enqueueCall(method, args, { 1 }, optimistic)
+    };
+    if (optimistic && !uris.isEmpty()) {
+        if (position < 0 || position > m_trackIds.count()) {
+            position = m_trackIds.count();
+        }
+        /* The service will tell us the IDs of the new tracks only later;
+         * until then, use some local IDs */
+        for (int i = 0; i < uris.count(); i++) {
+            const QString placeholder = QLatin1String(placeholderPrefix) +
+                QString::number(m_placeholderCounter++);
+            addition.placeholders.append(placeholder);
+            m_tracks.insert(position + i, Track(uris[i]));
+            m_trackIds.insert(position + i, placeholder);
+        }
+        Q_EMIT q->tracksAdded(position, position + uris.count() - 1);
+    }
+    m_pendingAdditions.enqueue(addition);
+    sendPendingCalls();
+    return addition.operation;
+}
+
+void TrackListPrivate::sendPendingCalls()
+{
+    Q_Q(TrackList);
+
+    /* Calls are sent in order, and a call referring to a track whose ID is
+     * not known yet blocks the ones following it */
+    while (!m_pendingCalls.isEmpty()) {
+        Call &head = m_pendingCalls.head();
+        bool ready = true;
+        bool trackFailed = false;
+        for (int i: head.idArgs) {
+            const QString id = head.args[i].toString();
+            if (!isPlaceholder(id)) continue;
+            const auto it = m_resolvedIds.constFind(id);
+            if (it == m_resolvedIds.constEnd()) {
+                ready = false;
+                break;
+            }
+            trackFailed = trackFailed || it.value().isEmpty();
+            head.args[i] = it.value();
+        }
+        if (!ready) break;
+
+        const Call call = m_pendingCalls.dequeue();
+        if (trackFailed) {
+            onCallFailed(call.operation, call.optimistic,
+                         Error(Error::ResourceError,
+                               QStringLiteral("Track could not be added")));
+            continue;
+        }
+
+        QDBusPendingCall pendingCall =
+            m_proxy->asyncCallWithArgumentList(call.method, call.args);
+        auto watcher = new QDBusPendingCallWatcher(pendingCall,
+                                                   call.operation);
+        QObject::connect(watcher, &QDBusPendingCallWatcher::finished,
+                         q, [this, call](QDBusPendingCallWatcher *watcher) {
+            watcher->deleteLater();
+            const QDBusMessage reply =
+                QDBusPendingReply<void>(*watcher).reply();
+            if (Q_UNLIKELY(reply.type() == QDBusMessage::ErrorMessage)) {
+                onCallFailed(call.operation, call.optimistic,
+                             errorFromDBus(reply));
+                sendPendingCalls();
+            } else {
+                if (call.method == QLatin1String("AddTracks")) {
+                    onAddTracksReply(call.operation,
+                                     reply.arguments().value(0).toStringList());
+                }
+                call.operation->d_ptr->finish();
+            }
+        });
+    }
 
-    QDBusPendingCall call =
-        m_proxy->asyncCall(QStringLiteral("GoTo"), remotePos(index));
-    DBusUtils::waitForFinished(call);
+    if (m_pendingCalls.isEmpty() && m_expectedMoves.isEmpty()) {
+        m_resolvedIds.clear();
+    }
 }
 
-void TrackListPrivate::reset()
+void TrackListPrivate::onCallFailed(TrackListOperation *operation,
+                                    bool optimistic, const Error &error)
 {
+    Q_Q(TrackList);
+
+    qWarning() << "Track list operation failed:" << error;
+
+    for (auto i = m_pendingAdditions.begin();
+         i != m_pendingAdditions.end(); i++) {
+        if (i->operation != operation) continue;
+
+        // No TrackAdded signal will come: drop our local copies
+        for (const QString &placeholder: i->placeholders) {
+            m_resolvedIds.insert(placeholder, QString());
+            const int index = m_trackIds.indexOf(placeholder);
+            if (index < 0) continue;
+            m_trackIds.remove(index);
+            m_tracks.remove(index);
+            Q_EMIT q->trackRemoved(index);
+        }
+        m_pendingAdditions.erase(i);
+        optimistic = false;
+        break;
+    }
+
+    // We can't tell how to undo the other changes
+    if (optimistic) {
+        resync();
+    }
+
+    operation->d_ptr->finish(error);
+}
+
+void TrackListPrivate::resync()
+{
+    Q_Q(TrackList);
+
+    QDBusMessage msg = QDBusMessage::createMethodCall(
+        m_proxy->service(),
+        m_proxy->path(),
+        QStringLiteral(FDO_PROPERTIES_INTERFACE),
+        QStringLiteral("Get"));
+    msg.setArguments({
+        QStringLiteral(MPRIS_TRACKLIST_INTERFACE),
+        QStringLiteral("Tracks"),
+    });
+    auto watcher =
+        new QDBusPendingCallWatcher(m_proxy->connection().asyncCall(msg));
+    QObject::connect(watcher, &QDBusPendingCallWatcher::finished,
+                     q, [this, q](QDBusPendingCallWatcher *call) {
+        call->deleteLater();
+        QDBusPendingReply<QDBusVariant> reply(*call);
+        if (reply.isError()) {
+            qWarning() << "Cannot reload the track list:" <<
+                reply.error().message();
+            return;
+        }
+
+        const QStringList ids = reply.value().variant().toStringList();
+        QList<QDBusObjectPath> paths;
+        for (const QString &id: ids) {
+            paths.append(QDBusObjectPath(id));
+        }
+        auto uriWatcher = new QDBusPendingCallWatcher(
+            m_proxy->asyncCall(QStringLiteral("GetTracksUris"),
+                               QVariant::fromValue(paths)));
+        QObject::connect(uriWatcher, &QDBusPendingCallWatcher::finished,
+                         q, [this, ids](QDBusPendingCallWatcher *call) {
+            call->deleteLater();
+            QDBusPendingReply<QStringList> reply(*call);
+            if (reply.isError()) {
+                qWarning() << "Cannot reload the track list:" <<
+                    reply.error().message();
+                return;
+            }
+            if (reply.value().count() != ids.count()) {
+                qWarning() << "Mismatching counters when reloading tracks";
+                return;
+            }
+            onTracksReloaded(ids, reply.value());
+        });
+    });
+}
+
+void TrackListPrivate::onTracksReloaded(const QStringList &ids,
+                                        const QStringList &uris)
+{
+    Q_Q(TrackList);
+
+    const QString currentId =
+        m_currentTrack >= 0 ? remotePos(m_currentTrack) : QString();
+
+    m_trackIds = ids.toVector();
+    m_tracks.clear();
+    for (const QString &uri: uris) {
+        m_tracks.append(Track(QUrl(uri)));
+    }
+    m_metaDataRequested.clear();
+    m_expectedMoves.clear();
+    m_expectedResets = 0;
+    m_currentTrack = m_trackIds.indexOf(currentId);
+
+    Q_EMIT q->trackListReset();
+    if (!m_tracks.isEmpty()) {
+        Q_EMIT q->tracksAdded(0, m_tracks.count() - 1);
+    }
+    Q_EMIT q->currentTrackChanged();
+}
+
+void TrackListPrivate::fetchMetaData(int start, int end)
+{
+    Q_Q(TrackList);
+
     if (!ensureProxy()) return;
 
-    QDBusPendingCall call = m_proxy->asyncCall(QStringLiteral("Reset"));
-    DBusUtils::waitForFinished(call);
+    const int count = m_trackIds.count();
+    start = qMax(start, 0);
+    end = qMin(end, count - 1);
+    if (start > end) return;
+
+    // Extend the range to whole pages, as it's likely that the client will
+    // soon ask for the neighbouring tracks too
+    start -= start % metaDataPageSize;
+    end = qMin(end - end % metaDataPageSize + metaDataPageSize, count) - 1;
+
+    for (int page = start; page <= end; page += metaDataPageSize) {
+        const int pageEnd = qMin(page + metaDataPageSize - 1, end);
+        QList<QDBusObjectPath> ids;
+        for (int i = page; i <= pageEnd; i++) {
+            const QString &id = m_trackIds[i];
+            // Skip the tracks which have not been added yet
+            if (isPlaceholder(id) || m_metaDataRequested.contains(id)) continue;
+            m_metaDataRequested.insert(id);
+            ids.append(QDBusObjectPath(id));
+        }
+        if (ids.isEmpty()) continue;
+
+        QDBusPendingCall call =
+            m_proxy->asyncCall(QStringLiteral("GetTracksMetadata"),
+                               QVariant::fromValue(ids));
+        auto watcher = new QDBusPendingCallWatcher(call);
+        QObject::connect(watcher, &QDBusPendingCallWatcher::finished,
+                         q, [this, ids](QDBusPendingCallWatcher *call) {
+            call->deleteLater();
+            QDBusPendingReply<QList<QVariantMap>> reply(*call);
+            if (reply.isError()) {
+                qWarning() << "Cannot get tracks metadata:" <<
+                    reply.error().message();
+                // Allow the client to try again
+                for (const QDBusObjectPath &id: ids) {
+                    m_metaDataRequested.remove(id.path());
+                }
+                return;
+            }
+            onTracksMetaData(reply.value());
+        });
+    }
+}
+
+void TrackListPrivate::onTracksMetaData(const QList<QVariantMap> &tracks)
+{
+    Q_Q(TrackList);
+
+    int first = m_trackIds.count();
+    int last = -1;
+    for (QVariantMap metaData: tracks) {
+        const QString id =
+            metaData.take(Track::MetaData::TrackIdKey).
+            value<QDBusObjectPath>().path();
+        const int index = m_trackIds.indexOf(id);
+        // The track might have been removed in the meantime
+        if (index < 0) continue;
+
+        m_tracks[index].setMetaData(metaData);
+        first = qMin(first, index);
+        last = qMax(last, index);
+    }
+
+    if (last >= 0) {
+        Q_EMIT q->tracksMetaDataChanged(first, last);
+    }
 }
 
 void TrackListPrivate::onTrackAdded(const QString &id)
@@ -202,30 +646,107 @@ void TrackListPrivate::onTrackAdded(const QString &id)
 
 void TrackListPrivate::onTracksAdded(const QStringList &ids)
 {
-    Q_Q(TrackList);
     // TODO: rewrite once we change the service to be spec-compliant
-    if (ids.count() != m_urisForNextAddition.count()) {
+    if (m_pendingAdditions.isEmpty() ||
+        ids.count() > m_pendingAdditions.head().uris.count()) {
         qWarning() << "Mismatching counters for TrackAdded signal";
         return;
     }
-    if (m_indexForNextAddition < 0 || m_indexForNextAddition > m_trackIds.count()) {
-        m_indexForNextAddition = m_trackIds.count();
+
+    if (ids.count() < m_pendingAdditions.head().uris.count()) {
+        // Wait for the reply to know which tracks are missing
+        m_pendingAdditions.head().partialIds = ids;
+        return;
+    }
+
+    const Addition addition = m_pendingAdditions.dequeue();
+    applyAddition(addition, ids, QVector<bool>(ids.count(), true));
+}
+
+void TrackListPrivate::onAddTracksReply(TrackListOperation *operation,
+                                        const QStringList &results)
+{
+    if (m_pendingAdditions.isEmpty() ||
+        m_pendingAdditions.head().operation != operation ||
+        m_pendingAdditions.head().partialIds.isEmpty()) {
+        return;
+    }
+
+    const Addition addition = m_pendingAdditions.dequeue();
+    QVector<bool> added;
+    for (int i = 0; i < addition.uris.count(); i++) {
+        added.append(results.value(i).isEmpty());
+    }
+    if (added.count(true) != addition.partialIds.count()) {
+        qWarning() << "Mismatching counters for AddTracks reply";
+        resync();
+        return;
+    }
+    applyAddition(addition, addition.partialIds, added);
+}
+
+void TrackListPrivate::applyAddition(const Addition &addition,
+                                     const QStringList &ids,
+                                     const QVector<bool> &added)
+{
+    Q_Q(TrackList);
+
+    if (!addition.placeholders.isEmpty()) {
+        // The tracks are already in the list, we just learn their real IDs
+        auto id = ids.cbegin();
+        for (int i = 0; i < addition.placeholders.count(); i++) {
+            const QString &placeholder = addition.placeholders[i];
+            const QString realId = added[i] ? *id++ : QString();
+            m_resolvedIds.insert(placeholder, realId);
+            const int index = m_trackIds.indexOf(placeholder);
+            if (index < 0) continue;
+            if (added[i]) {
+                m_trackIds[index] = realId;
+            } else {
+                m_trackIds.remove(index);
+                m_tracks.remove(index);
+                Q_EMIT q->trackRemoved(index);
+            }
+        }
+        sendPendingCalls();
+        return;
+    }
+
+    if (ids.isEmpty()) return;
+
+    int position = addition.index;
+    if (position < 0 || position > m_trackIds.count()) {
+        position = m_trackIds.count();
     }
-    for (int i = 0; i < m_urisForNextAddition.count(); i++) {
-        const QUrl &uri = m_urisForNextAddition[i];
-        m_tracks.insert(m_indexForNextAddition + i, Track(uri));
-        m_trackIds.insert(m_indexForNextAddition + i, ids[i]);
+    auto id = ids.cbegin();
+    int index = position;
+    for (int i = 0; i < addition.uris.count(); i++) {
+        if (!added[i]) continue;
+        m_tracks.insert(index, Track(addition.uris[i]));
+        m_trackIds.insert(index, *id++);
+        index++;
     }
 
-    Q_EMIT q->tracksAdded(m_indexForNextAddition,
-                          m_indexForNextAddition + ids.count() - 1);
+    Q_EMIT q->tracksAdded(position, position + ids.count() - 1);
 }
 
 void TrackListPrivate::onTrackMoved(const QString &id, const QString &to)
 {
     Q_Q(TrackList);
+
+    if (!m_expectedMoves.isEmpty()) {
+        const auto &expected = m_expectedMoves.head();
+        if (resolvedId(expected.first) == id &&
+            resolvedId(expected.second) == to) {
+            // We already moved it
+            m_expectedMoves.dequeue();
+            return;
+        }
+    }
+
     int idIndex = m_trackIds.indexOf(id);
     int toIndex = m_trackIds.indexOf(to);
+    if (idIndex < 0 || toIndex < 0) return;
     m_trackIds.move(idIndex, toIndex);
     m_tracks.move(idIndex, toIndex);
     Q_EMIT q->trackMoved(idIndex, toIndex);
@@ -235,16 +756,25 @@ void TrackListPrivate::onTrackRemoved(const QString &id)
 {
     Q_Q(TrackList);
     int idIndex = m_trackIds.indexOf(id);
+    // Might have been removed already by removeTrackAsync()
+    if (idIndex < 0) return;
     m_trackIds.remove(idIndex);
     m_tracks.remove(idIndex);
+    m_metaDataRequested.remove(id);
     Q_EMIT q->trackRemoved(idIndex);
 }
 
 void TrackListPrivate::onTrackListReset()
 {
     Q_Q(TrackList);
+    if (m_expectedResets > 0) {
+        // We already cleared the list
+        m_expectedResets--;
+        return;
+    }
     m_trackIds.clear();
     m_tracks.clear();
+    m_metaDataRequested.clear();
     m_currentTrack = -1;
     Q_EMIT q->trackListReset();
 }
@@ -252,7 +782,9 @@ void TrackListPrivate::onTrackListReset()
 void TrackListPrivate::onTrackChanged(const QString &id)
 {
     Q_Q(TrackList);
-    m_currentTrack = m_trackIds.indexOf(id);
+    const int index = m_trackIds.indexOf(id);
+    if (index == m_currentTrack) return;
+    m_currentTrack = index;
     Q_EMIT q->currentTrackChanged();
 }
 
@@ -286,37 +818,82 @@ void TrackList::addTrackWithUriAt(const QUrl &uri, int position,
                                   bool makeCurrent)
 {
     Q_D(TrackList);
-    d->addTrackWithUriAt(uri, position, makeCurrent);
+    d->addTrackWithUriAt(uri, position, makeCurrent, false)->waitForFinished();
 }
 
 void TrackList::addTracksWithUriAt(const QVector<QUrl> &uris, int position)
 {
     Q_D(TrackList);
-    d->addTracksWithUriAt(uris, position);
+    d->addTracksWithUriAt(uris, position, false)->waitForFinished();
 }
 
 void TrackList::moveTrack(int index, int to)
 {
     Q_D(TrackList);
-    d->moveTrack(index, to);
+    d->moveTrack(index, to, false)->waitForFinished();
 }
 
 void TrackList::removeTrack(int index)
 {
     Q_D(TrackList);
-    d->removeTrack(index);
+    d->removeTrack(index, false)->waitForFinished();
 }
 
 void TrackList::goTo(int index)
 {
     Q_D(TrackList);
-    d->goTo(index);
+    d->goTo(index, false)->waitForFinished();
 }
 
 void TrackList::reset()
 {
     Q_D(TrackList);
-    d->reset();
+    d->reset(false)->waitForFinished();
+}
+
+TrackListOperation *TrackList::addTrackWithUriAtAsync(const QUrl &uri,
+                                                      int position,
+                                                      bool makeCurrent)
+{
+    Q_D(TrackList);
+    return d->addTrackWithUriAt(uri, position, makeCurrent, true);
+}
+
+TrackListOperation *TrackList::addTracksWithUriAtAsync(
+        const QVector<QUrl> &uris, int position)
+{
+    Q_D(TrackList);
+    return d->addTracksWithUriAt(uris, position, true);
+}
+
+TrackListOperation *TrackList::moveTrackAsync(int index, int to)
+{
+    Q_D(TrackList);
+    return d->moveTrack(index, to, true);
+}
+
+TrackListOperation *TrackList::removeTrackAsync(int index)
+{
+    Q_D(TrackList);
+    return d->removeTrack(index, true);
+}
+
+TrackListOperation *TrackList::goToAsync(int index)
+{
+    Q_D(TrackList);
+    return d->goTo(index, true);
+}
+
+TrackListOperation *TrackList::resetAsync()
+{
+    Q_D(TrackList);
+    return d->reset(true);
+}
+
+void TrackList::fetchMetaData(int start, int end)
+{
+    Q_D(TrackList);
+    d->fetchMetaData(start, end);
 }
 
 #include "track_list.moc"
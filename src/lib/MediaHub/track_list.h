@@ -19,6 +19,7 @@
 #ifndef LOMIRI_MEDIAHUB_TRACK_LIST_H
 #define LOMIRI_MEDIAHUB_TRACK_LIST_H
 
+#include "error.h"
 #include "global.h"
 #include "track.h"
 
@@ -32,6 +33,36 @@ namespace MediaHub {
 class PlayerPrivate;
 
 class TrackListPrivate;
+
+class TrackListOperationPrivate;
+/** Handle to an edit operation issued with one of the asynchronous
+ * TrackList methods. The object is owned by the TrackList and is deleted
+ * automatically once the finished() signal has been emitted. */
+class MH_EXPORT TrackListOperation: public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(TrackListOperation)
+
+public:
+    ~TrackListOperation();
+
+    bool isFinished() const;
+    /** Only meaningful once the operation has finished */
+    Error error() const;
+
+    /** Blocks until the operation is finished; returns false on error */
+    bool waitForFinished();
+
+Q_SIGNALS:
+    void finished();
+
+private:
+    friend class TrackListPrivate;
+    TrackListOperation(QObject *parent);
+    Q_DECLARE_PRIVATE(TrackListOperation)
+    QScopedPointer<TrackListOperationPrivate> d_ptr;
+};
+
 class MH_EXPORT TrackList: public QObject
 {
     Q_OBJECT
@@ -86,6 +117,28 @@ public:
     /** Clears and resets the TrackList to the same as a newly constructed instance. */
     void reset();
 
+    /*
+     * Non-blocking variants of the methods above: the local list of tracks
+     * is updated (and the corresponding signals emitted) immediately, without
+     * waiting for the service to confirm the change. Operations can be issued
+     * without waiting for the previous ones to complete: they are executed by
+     * the service in the same order. If an operation fails, the local list is
+     * reloaded from the service.
+     */
+    TrackListOperation *addTrackWithUriAtAsync(const QUrl &uri, int position,
+                                               bool makeCurrent);
+    TrackListOperation *addTracksWithUriAtAsync(const QVector<QUrl> &uris,
+                                                int position);
+    TrackListOperation *moveTrackAsync(int index, int to);
+    TrackListOperation *removeTrackAsync(int index);
+    TrackListOperation *goToAsync(int index);
+    TrackListOperation *resetAsync();
+
+    /** Retrieves the metadata of the tracks from `start` to `end`, if not
+     * already done. The metadata is fetched asynchronously, in pages of
+     * tracks, and tracksMetaDataChanged() is emitted once it's available. */
+    void fetchMetaData(int start, int end);
+
 Q_SIGNALS:
     void canEditTracksChanged();
     void currentTrackChanged(); // D-Bus: TrackChanged
@@ -94,6 +147,7 @@ Q_SIGNALS:
     void trackRemoved(int index);
     void trackMoved(int index, int to);
     void trackListReset();
+    void tracksMetaDataChanged(int start, int end);
 
 private:
     friend class PlayerPrivate;
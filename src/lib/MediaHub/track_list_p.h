@@ -21,6 +21,12 @@
 
 #include "track_list.h"
 
+#include <QHash>
+#include <QPair>
+#include <QQueue>
+#include <QSet>
+#include <QVariantList>
+
 class DBusTrackList;
 
 class QDBusConnection;
@@ -43,15 +49,45 @@ public:
 
     void initialize(const QVariantMap &properties);
 
-    void addTrackWithUriAt(const QUrl &uri, int position, bool makeCurrent);
-    void addTracksWithUriAt(const QVector<QUrl> &uris, int position);
-    void moveTrack(int index, int to);
-    void removeTrack(int index);
-    void goTo(int index);
-    void reset();
+    /* When `optimistic` is true, the local state is updated immediately,
+     * instead of waiting for the service signals */
+    TrackListOperation *addTrackWithUriAt(const QUrl &uri, int position,
+                                          bool makeCurrent, bool optimistic);
+    TrackListOperation *addTracksWithUriAt(const QVector<QUrl> &uris,
+                                           int position, bool optimistic);
+    TrackListOperation *moveTrack(int index, int to, bool optimistic);
+    TrackListOperation *removeTrack(int index, bool optimistic);
+    TrackListOperation *goTo(int index, bool optimistic);
+    TrackListOperation *reset(bool optimistic);
+    void fetchMetaData(int start, int end);
+
+    void onTracksMetaData(const QList<QVariantMap> &tracks);
+
+    static bool isPlaceholder(const QString &id);
+    QString resolvedId(const QString &id) const;
+    /* Queues a D-Bus call; `idArgs` are the positions of the arguments
+     * which are track IDs, and which might still be placeholders */
+    TrackListOperation *enqueueCall(const QString &method,
+                                    const QVariantList &args,
+                                    const QVector<int> &idArgs,
+                                    bool optimistic);
+    TrackListOperation *enqueueAddition(const QString &method,
+                                        const QVariantList &args,
+                                        const QVector<QUrl> &uris,
+                                        int position, bool optimistic);
+    TrackListOperation *disconnectedOperation();
+    void sendPendingCalls();
+    void onCallFailed(TrackListOperation *operation, bool optimistic,
+                      const Error &error);
+    // Reloads the list of tracks from the service
+    void resync();
+    void onTracksReloaded(const QStringList &ids, const QStringList &uris);
 
     void onTrackAdded(const QString &id);
     void onTracksAdded(const QStringList &ids);
+    // `results` has an error name for each URI which was not added
+    void onAddTracksReply(TrackListOperation *operation,
+                          const QStringList &results);
     void onTrackMoved(const QString &id, const QString &to);
     void onTrackRemoved(const QString &id);
     void onTrackListReset();
@@ -62,10 +98,41 @@ private:
     QVector<QString> m_trackIds;
     bool m_canEditTracks;
     int m_currentTrack;
+    // Tracks whose metadata has been requested (or already received)
+    QSet<QString> m_metaDataRequested;
+
+    struct Call {
+        QString method;
+        QVariantList args;
+        QVector<int> idArgs;
+        bool optimistic;
+        TrackListOperation *operation;
+    };
+    // Calls waiting for the IDs of the tracks they refer to
+    QQueue<Call> m_pendingCalls;
 
     // TODO: remove once service is spec-compliant
-    int m_indexForNextAddition;
-    QVector<QUrl> m_urisForNextAddition;
+    struct Addition {
+        int index;
+        QVector<QUrl> uris;
+        // Only set for optimistic additions
+        QStringList placeholders;
+        TrackListOperation *operation;
+        /* Set if some of the URIs were rejected: the reply to AddTracks will
+         * tell us which ones */
+        QStringList partialIds;
+    };
+    void applyAddition(const Addition &addition, const QStringList &ids,
+                       const QVector<bool> &added);
+    // Additions whose TrackAdded signal has not been received yet
+    QQueue<Addition> m_pendingAdditions;
+    // Maps the placeholder IDs to the real ones (empty if the addition failed)
+    QHash<QString, QString> m_resolvedIds;
+    int m_placeholderCounter;
+
+    // Signals which confirm our optimistic updates, and must be ignored
+    QQueue<QPair<QString, QString>> m_expectedMoves;
+    int m_expectedResets;
 
 
     QScopedPointer<DBusTrackList> m_proxy;
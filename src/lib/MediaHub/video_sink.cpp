@@ -50,6 +50,36 @@ const QMatrix4x4 &VideoSink::transformationMatrix() const
     return d->m_transformationMatrix;
 }
 
+qint64 VideoSink::presentationTime() const
+{
+    Q_D(const VideoSink);
+    return d->m_frameStatistics.presentationTime();
+}
+
+quint64 VideoSink::renderedFrames() const
+{
+    Q_D(const VideoSink);
+    return d->m_frameStatistics.renderedFrames();
+}
+
+quint64 VideoSink::lateFrames() const
+{
+    Q_D(const VideoSink);
+    return d->m_frameStatistics.lateFrames();
+}
+
+quint64 VideoSink::droppedFrames() const
+{
+    Q_D(const VideoSink);
+    return d->m_frameStatistics.droppedFrames();
+}
+
+qint64 VideoSink::avSyncDrift() const
+{
+    Q_D(const VideoSink);
+    return d->m_frameStatistics.avSyncDrift();
+}
+
 VideoSinkFactory lomiri::MediaHub::createVideoSinkFactory(
     PlayerKey key,
     AVBackend::Backend backend)
@@ -52,6 +52,38 @@ public:
      */
     virtual bool swapBuffers() = 0;
 
+    /**
+     * @brief Presentation time of the current frame, in microseconds of
+     * stream time, or -1 if unknown.
+     */
+    qint64 presentationTime() const;
+
+    /**
+     * @brief Number of frames made current by swapBuffers().
+     */
+    quint64 renderedFrames() const;
+
+    /**
+     * @brief Number of rendered frames which were already behind the
+     * playback position when swapBuffers() presented them.
+     */
+    quint64 lateFrames() const;
+
+    /**
+     * @brief Number of frames which were never rendered, either because the
+     * service dropped them or because a newer frame replaced them before
+     * swapBuffers() was called.
+     */
+    quint64 droppedFrames() const;
+
+    /**
+     * @brief Difference between the playback position and the presentation
+     * time of the current frame when swapBuffers() presented it, in
+     * microseconds: a positive value means that the video is behind the
+     * audio.
+     */
+    qint64 avSyncDrift() const;
+
     /**
      * @brief The signal is emitted whenever a new frame is available and a subsequent
      * call to swapBuffers() will not block and return true.
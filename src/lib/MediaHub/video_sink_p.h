@@ -22,6 +22,7 @@
 #include "video_sink.h"
 
 #include "dbus_constants.h"
+#include "frame_statistics.h"
 #include "player.h"
 
 #include <functional>
@@ -52,6 +53,8 @@ public:
     virtual ~VideoSinkPrivate() = default;
 
     QMatrix4x4 m_transformationMatrix;
+    // Updated by the sinks as frames are presented
+    FrameStatistics m_frameStatistics;
 };
 
 } // namespace MediaHub
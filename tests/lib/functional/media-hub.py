@@ -59,6 +59,8 @@ def create_session(self):
         'Shuffle': False,
         'LoopStatus': 'None',
         'AudioStreamRole': 2,
+        'Position': dbus.Int64(0),
+        'PositionUpdateInterval': dbus.Int32(-1),
         'Metadata': dbus.Array([], signature='a{sv}'),
     }
     props.update(self.player_properties_override)
@@ -76,6 +78,7 @@ def create_session(self):
         ('Pause', '', '', ''),
         ('Stop', '', '', ''),
         ('Seek', 't', '', ''),
+        ('SeekWithMode', 'tn', '', ''),
         ('CreateVideoSink', 'u', '', ''),
     ]
     self.AddObject(player_path, MPRIS_PLAYER_INTERFACE, props, methods)
@@ -102,10 +105,13 @@ def create_track_list(self, player_path):
         ('RemoveTrack', 's', '', ''),
         ('Reset', '', '', ''),
         ('GoTo', 's', '', 'self.go_to(self, *args)'),
+        ('GetTracksMetadata', 'ao', 'aa{sv}',
+         'ret = self.get_tracks_metadata(self, *args)'),
     ]
     self.AddObject(track_list_path, MPRIS_TRACKLIST_INTERFACE, props, methods)
     track_list = dbusmock.get_object(track_list_path)
     track_list.go_to = go_to
+    track_list.get_tracks_metadata = get_tracks_metadata
 
 
 def destroy_session(self, uuid):
@@ -123,6 +129,13 @@ def go_to(self, track_id):
     self.EmitSignal(MPRIS_TRACKLIST_INTERFACE, 'TrackChanged', 's', (track_id,))
 
 
+def get_tracks_metadata(self, track_ids):
+    return [{
+        'mpris:trackid': track_id,
+        'xesam:title': 'Title of ' + track_id,
+    } for track_id in track_ids]
+
+
 def load(mock, parameters):
     mock.last_player_path = ''
     mock.next_player_id = 1
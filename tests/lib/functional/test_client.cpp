@@ -41,6 +41,7 @@
 #include <QTest>
 #include <QVariantMap>
 #include <libqtdbusmock/DBusMock.h>
+#include <time.h>
 
 namespace QTest {
 
@@ -232,12 +233,16 @@ private Q_SLOTS:
     void testOpenUriWithHeaders();
     void testPlayerMethods();
     void testPlayerSignals();
+    void testPositionAnchor();
 
     void testTracklistConstructor();
     void testEmptyTracklist();
     void testOfflineTracklist();
     void testTracklistAddSingle();
     void testTracklistEditing();
+    void testTracklistMetaData();
+    void testTracklistAsync();
+    void testTracklistPartialAddition();
     void testCurrentTrack();
 
     void testVideoSink();
@@ -528,6 +533,12 @@ void TestClient::testPlayerMethods()
     auto calls = getPlayerCalls("Seek");
     QCOMPARE(calls.count(), 1);
     QCOMPARE(calls[0].args(), QVariantList { quint64(7654321) });
+
+    player.seekTo(1234567, Player::AccurateSeek);
+    calls = getPlayerCalls("SeekWithMode");
+    QCOMPARE(calls.count(), 1);
+    QCOMPARE(calls[0].args(),
+             (QVariantList { quint64(1234567), qint16(1) }));
 }
 
 void TestClient::testPlayerSignals()
@@ -572,6 +583,51 @@ void TestClient::testPlayerSignals()
     QCOMPARE(bufferingChanged.at(0).at(0).toInt(), 32);
 }
 
+void TestClient::testPositionAnchor()
+{
+    Player player;
+    QSignalSpy positionChanged(&player, &Player::positionChanged);
+
+    // Anchors are ignored unless requested
+    emitPlayerSignal("PositionAnchor", "xxd",
+                     { qint64(5000), qint64(0), 1.0 });
+    QTest::qWait(100);
+    // Clamped like the service does
+    player.setPositionUpdateInterval(5);
+    QCOMPARE(player.positionUpdateInterval(), 10);
+    player.setPositionUpdateInterval(200);
+    QCOMPARE(player.positionUpdateInterval(), 200);
+    QTRY_COMPARE(m_mediaHub->getPlayerProperty("PositionUpdateInterval"),
+                 QVariant(200));
+    QCOMPARE(positionChanged.count(), 0);
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    const qint64 now = qint64(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+
+    // Paused: the position stays put
+    emitPlayerSignal("PositionAnchor", "xxd",
+                     { qint64(3000000000), now - 1000000000, 0.0 });
+    QTRY_COMPARE(positionChanged.count(), 1);
+    QCOMPARE(positionChanged.at(0).at(0).toULongLong(), 3000000000ULL);
+    QCOMPARE(player.position(), 3000000000ULL);
+
+    // Playing: the position is extrapolated from the anchor
+    emitPlayerSignal("PositionAnchor", "xxd",
+                     { qint64(3000000000), now - 1000000000, 1.0 });
+    QTRY_COMPARE(positionChanged.count(), 2);
+    const quint64 position = player.position();
+    QVERIFY(position >= 4000000000ULL);
+    QVERIFY(position < 14000000000ULL);
+    QTest::qWait(50);
+    QVERIFY(player.position() >= position + 50000000ULL);
+
+    /* Disabling the updates makes the player query the service again; the
+     * mock does not track the position, so this returns 0 */
+    player.setPositionUpdateInterval(-1);
+    QCOMPARE(player.position(), 0ULL);
+}
+
 void TestClient::testTracklistConstructor()
 {
     TrackList track1;
@@ -744,6 +800,206 @@ void TestClient::testTracklistEditing()
     QCOMPARE(trackList.currentTrack(), -1);
 }
 
+void TestClient::testTracklistMetaData()
+{
+    Player player;
+    TrackList trackList;
+    QSignalSpy tracksAdded(&trackList, &TrackList::tracksAdded);
+    QSignalSpy tracksMetaDataChanged(&trackList,
+                                     &TrackList::tracksMetaDataChanged);
+    player.setTrackList(&trackList);
+
+    const int trackCount = 60;
+    QVector<QUrl> uris;
+    QStringList ids;
+    for (int i = 0; i < trackCount; i++) {
+        uris.append(QUrl(QString("http://me.com/song%1.mp3").arg(i)));
+        ids.append(QString("/track/id/%1").arg(i));
+    }
+    trackList.addTracksWithUriAt(uris, 0);
+    m_mediaHub->trackListMock().EmitSignal(MPRIS_TRACKLIST_INTERFACE,
+                                           "TracksAdded", "as", { ids });
+    QVERIFY(tracksAdded.wait());
+    QCOMPARE(trackList.tracks().count(), trackCount);
+    QVERIFY(trackList.tracks()[55].metaData().isEmpty());
+
+    // The whole page containing the track is retrieved
+    trackList.fetchMetaData(55, 55);
+    QVERIFY(tracksMetaDataChanged.wait());
+    QCOMPARE(getTrackListCalls("GetTracksMetadata").count(), 1);
+    QCOMPARE(tracksMetaDataChanged[0][0].toInt(), 50);
+    QCOMPARE(tracksMetaDataChanged[0][1].toInt(), 59);
+    for (int i = 50; i < trackCount; i++) {
+        const Track::MetaData metaData = trackList.tracks()[i].metaData();
+        QCOMPARE(metaData.value("xesam:title").toString(),
+                 "Title of " + ids[i]);
+        QVERIFY(!metaData.contains(Track::MetaData::TrackIdKey));
+    }
+    QVERIFY(trackList.tracks()[49].metaData().isEmpty());
+
+    // Tracks whose metadata is known are not requested again
+    tracksMetaDataChanged.clear();
+    trackList.fetchMetaData(10, trackCount - 1);
+    QVERIFY(tracksMetaDataChanged.wait());
+    QCOMPARE(getTrackListCalls("GetTracksMetadata").count(), 2);
+    QCOMPARE(tracksMetaDataChanged[0][0].toInt(), 0);
+    QCOMPARE(tracksMetaDataChanged[0][1].toInt(), 49);
+
+    trackList.fetchMetaData(0, trackCount - 1);
+    QVERIFY(!tracksMetaDataChanged.wait(200));
+    QCOMPARE(getTrackListCalls("GetTracksMetadata").count(), 2);
+
+    // The service notifies the metadata it extracts in the background
+    QVariantMap newMetaData {
+        { "xesam:title", "Extracted title" },
+    };
+    m_mediaHub->trackListMock().EmitSignal(
+        MPRIS_TRACKLIST_INTERFACE, "TrackMetadataChanged", "a{sv}o",
+        { newMetaData, QVariant::fromValue(QDBusObjectPath(ids[7])) });
+    QVERIFY(tracksMetaDataChanged.wait());
+    QCOMPARE(tracksMetaDataChanged.last()[0].toInt(), 7);
+    QCOMPARE(tracksMetaDataChanged.last()[1].toInt(), 7);
+    QCOMPARE(trackList.tracks()[7].metaData().value("xesam:title").toString(),
+             QString("Extracted title"));
+    QCOMPARE(getTrackListCalls("GetTracksMetadata").count(), 2);
+}
+
+void TestClient::testTracklistAsync()
+{
+    Player player;
+    TrackList trackList;
+    QSignalSpy tracksAdded(&trackList, &TrackList::tracksAdded);
+    QSignalSpy trackMoved(&trackList, &TrackList::trackMoved);
+    QSignalSpy trackRemoved(&trackList, &TrackList::trackRemoved);
+    QSignalSpy trackListReset(&trackList, &TrackList::trackListReset);
+    QSignalSpy currentTrackChanged(&trackList,
+                                   &TrackList::currentTrackChanged);
+    player.setTrackList(&trackList);
+
+    /* Several additions can be issued without waiting, and the local list
+     * is updated right away */
+    for (int i = 0; i < 3; i++) {
+        trackList.addTrackWithUriAtAsync(
+            QUrl(QString("http://me.com/song%1.mp3").arg(i)), -1, false);
+    }
+    QCOMPARE(tracksAdded.count(), 3);
+    QCOMPARE(tracksAdded[2][0].toInt(), 2);
+    QCOMPARE(trackList.tracks().count(), 3);
+    QCOMPARE(trackList.tracks()[2].uri(), QUrl("http://me.com/song2.mp3"));
+
+    /* This one refers to tracks whose IDs are not known yet, so it's held
+     * back until the service has confirmed the additions */
+    TrackListOperation *move = trackList.moveTrackAsync(2, 0);
+    QSignalSpy moveFinished(move, &TrackListOperation::finished);
+    QCOMPARE(trackMoved.count(), 1);
+    QCOMPARE(trackList.tracks()[0].uri(), QUrl("http://me.com/song2.mp3"));
+
+    QTRY_COMPARE(getTrackListCalls("AddTrack").count(), 3);
+    QCOMPARE(getTrackListCalls("MoveTrack").count(), 0);
+
+    for (int i = 0; i < 3; i++) {
+        m_mediaHub->trackListMock().EmitSignal(MPRIS_TRACKLIST_INTERFACE,
+                                               "TrackAdded", "s",
+                                               { QString("/track/id/%1").arg(i) });
+    }
+    QVERIFY(moveFinished.wait());
+    auto calls = getTrackListCalls("MoveTrack");
+    QCOMPARE(calls.count(), 1);
+    QCOMPARE(calls[0].args(), (QVariantList { "/track/id/2", "/track/id/0" }));
+    // The confirmations did not add the tracks again
+    QCOMPARE(tracksAdded.count(), 3);
+
+    /* The signals confirming our changes are ignored */
+    m_mediaHub->trackListMock().EmitSignal(MPRIS_TRACKLIST_INTERFACE,
+                                           "TrackMoved", "ss",
+                                           { "/track/id/2", "/track/id/0" });
+    trackList.removeTrackAsync(1);
+    QCOMPARE(trackRemoved.count(), 1);
+    QCOMPARE(trackRemoved[0][0].toInt(), 1);
+    QCOMPARE(trackList.tracks().count(), 2);
+    QCOMPARE(trackList.tracks()[1].uri(), QUrl("http://me.com/song1.mp3"));
+    QTRY_COMPARE(getTrackListCalls("RemoveTrack").count(), 1);
+    QCOMPARE(getTrackListCalls("RemoveTrack")[0].args(),
+             QVariantList { "/track/id/0" });
+    m_mediaHub->trackListMock().EmitSignal(MPRIS_TRACKLIST_INTERFACE,
+                                           "TrackRemoved", "s",
+                                           { "/track/id/0" });
+
+    trackList.goToAsync(1);
+    QCOMPARE(currentTrackChanged.count(), 1);
+    QCOMPARE(trackList.currentTrack(), 1);
+
+    trackList.resetAsync();
+    QCOMPARE(trackListReset.count(), 1);
+    QCOMPARE(trackList.tracks().count(), 0);
+    QTRY_COMPARE(getTrackListCalls("Reset").count(), 1);
+    m_mediaHub->trackListMock().EmitSignal(MPRIS_TRACKLIST_INTERFACE,
+                                           "TrackListReset", "", {});
+
+    /* The signals are delivered in order, so once this addition is
+     * reported, all the previous signals have been processed */
+    trackList.addTrackWithUriAt(QUrl("http://me.com/song3.mp3"), -1, false);
+    m_mediaHub->trackListMock().EmitSignal(MPRIS_TRACKLIST_INTERFACE,
+                                           "TrackAdded", "s",
+                                           { "/track/id/3" });
+    QVERIFY(tracksAdded.wait());
+    QCOMPARE(trackMoved.count(), 1);
+    QCOMPARE(trackRemoved.count(), 1);
+    QCOMPARE(trackListReset.count(), 1);
+    // The TrackChanged signal sent by the mock in reply to GoTo is ignored
+    QCOMPARE(currentTrackChanged.count(), 1);
+    QCOMPARE(trackList.currentTrack(), -1);
+    QCOMPARE(trackList.tracks().count(), 1);
+    QCOMPARE(trackList.tracks()[0].uri(), QUrl("http://me.com/song3.mp3"));
+}
+
+void TestClient::testTracklistPartialAddition()
+{
+    Player player;
+    TrackList trackList;
+    QSignalSpy tracksAdded(&trackList, &TrackList::tracksAdded);
+    QSignalSpy trackRemoved(&trackList, &TrackList::trackRemoved);
+    player.setTrackList(&trackList);
+
+    /* Like the real service, emit the signal with the tracks which could be
+     * added, then reply with the reason why the others were skipped */
+    m_mediaHub->trackListMock().AddMethod(MPRIS_TRACKLIST_INTERFACE,
+        "AddTracks", "ass", "as",
+        "n = len(self.GetCalls()) * 10\n"
+        "self.EmitSignal('" MPRIS_TRACKLIST_INTERFACE "', 'TracksAdded', "
+        "'as', [['/track/id/%d' % (n + 1), '/track/id/%d' % (n + 3)]])\n"
+        "ret = ['', 'mpris.Player.Error.UriNotFound', '']").waitForFinished();
+
+    const QVector<QUrl> uris {
+        QUrl("file:///music/song1.mp3"),
+        QUrl("file:///music/missing.mp3"),
+        QUrl("file:///music/song3.mp3"),
+    };
+
+    // Blocking call: the tracks appear when the service confirms them
+    trackList.addTracksWithUriAt(uris, 0);
+    QTRY_COMPARE(tracksAdded.count(), 1);
+    QCOMPARE(tracksAdded[0][0].toInt(), 0);
+    QCOMPARE(tracksAdded[0][1].toInt(), 1);
+    QCOMPARE(trackList.tracks().count(), 2);
+    QCOMPARE(trackList.tracks()[0].uri(), uris[0]);
+    QCOMPARE(trackList.tracks()[1].uri(), uris[2]);
+
+    // Optimistic call: the rejected track is dropped from the local list
+    tracksAdded.clear();
+    TrackListOperation *operation =
+        trackList.addTracksWithUriAtAsync(uris, -1);
+    QCOMPARE(tracksAdded.count(), 1);
+    QCOMPARE(trackList.tracks().count(), 5);
+
+    // The operation succeeds, since some tracks were added
+    QVERIFY(operation->waitForFinished());
+    QCOMPARE(trackRemoved.count(), 1);
+    QCOMPARE(trackRemoved[0][0].toInt(), 3);
+    QCOMPARE(trackList.tracks().count(), 4);
+    QCOMPARE(trackList.tracks()[3].uri(), uris[2]);
+}
+
 void TestClient::testCurrentTrack()
 {
     Player player;
@@ -797,6 +1053,13 @@ void TestClient::testVideoSink()
     QCOMPARE(videoSink.transformationMatrix(), QMatrix4x4());
     QVERIFY(videoSink.swapBuffers());
 
+    // No frame timing information without a video backend
+    QCOMPARE(videoSink.presentationTime(), qint64(-1));
+    QCOMPARE(videoSink.renderedFrames(), quint64(0));
+    QCOMPARE(videoSink.lateFrames(), quint64(0));
+    QCOMPARE(videoSink.droppedFrames(), quint64(0));
+    QCOMPARE(videoSink.avSyncDrift(), qint64(0));
+
     auto calls = getPlayerCalls("CreateVideoSink");
     QCOMPARE(calls.count(), 1);
     QCOMPARE(calls[0].args(), QVariantList { quint32(textureId) });
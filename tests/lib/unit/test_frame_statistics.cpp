@@ -0,0 +1,130 @@
+/*
+ * Copyright © 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "MediaHub/frame_statistics.h"
+
+#include <QObject>
+#include <QTest>
+
+using namespace lomiri::MediaHub;
+
+namespace {
+
+const qint64 ms = 1000 * 1000;
+
+FrameStatistics::Frame frame(quint32 sequence, qint64 pts, qint64 position,
+                             double rate = 1.0, quint64 serviceDropped = 0)
+{
+    return { sequence, pts, position, rate, serviceDropped };
+}
+
+} // namespace
+
+class TestFrameStatistics: public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testInitial();
+    void testDroppedFrames();
+    void testPresentationDelay_data();
+    void testPresentationDelay();
+    void testUnknownTiming();
+};
+
+void TestFrameStatistics::testInitial()
+{
+    FrameStatistics stats;
+    QCOMPARE(stats.presentationTime(), qint64(-1));
+    QCOMPARE(stats.renderedFrames(), quint64(0));
+    QCOMPARE(stats.lateFrames(), quint64(0));
+    QCOMPARE(stats.droppedFrames(), quint64(0));
+    QCOMPARE(stats.avSyncDrift(), qint64(0));
+}
+
+void TestFrameStatistics::testDroppedFrames()
+{
+    FrameStatistics stats;
+    stats.framePresented(frame(0, 0, 0), 0);
+    // Presenting the same frame again doesn't count
+    stats.framePresented(frame(0, 0, 0), 10 * ms);
+    QCOMPARE(stats.renderedFrames(), quint64(1));
+
+    // Frames 1 and 2 were replaced before being presented
+    stats.framePresented(frame(3, 120 * ms, 120 * ms, 1.0, 4), 0);
+    QCOMPARE(stats.renderedFrames(), quint64(2));
+    QCOMPARE(stats.droppedFrames(), quint64(2 + 4));
+
+    // A reset of the service's pipeline is not a gap
+    stats.framePresented(frame(0, 0, 0), 0);
+    QCOMPARE(stats.droppedFrames(), quint64(2));
+    QCOMPARE(stats.renderedFrames(), quint64(3));
+}
+
+void TestFrameStatistics::testPresentationDelay_data()
+{
+    QTest::addColumn<qint64>("position");
+    QTest::addColumn<double>("rate");
+    QTest::addColumn<qint64>("sinceReady");
+    QTest::addColumn<qint64>("expectedDrift");
+    QTest::addColumn<bool>("expectedLate");
+
+    QTest::newRow("on time") << 1000 * ms << 1.0 << qint64(0) <<
+        qint64(0) << false;
+    QTest::newRow("ready early, shown on time") << 990 * ms << 1.0 <<
+        10 * ms << qint64(0) << false;
+    QTest::newRow("ready on time, shown late") << 1000 * ms << 1.0 <<
+        30 * ms << 30 * ms << true;
+    QTest::newRow("fast playback") << 1000 * ms << 2.0 <<
+        15 * ms << 30 * ms << true;
+    QTest::newRow("paused") << 1000 * ms << 0.0 <<
+        500 * ms << qint64(0) << false;
+    QTest::newRow("ahead") << 950 * ms << 1.0 <<
+        10 * ms << -40 * ms << false;
+}
+
+void TestFrameStatistics::testPresentationDelay()
+{
+    QFETCH(qint64, position);
+    QFETCH(double, rate);
+    QFETCH(qint64, sinceReady);
+    QFETCH(qint64, expectedDrift);
+    QFETCH(bool, expectedLate);
+
+    FrameStatistics stats;
+    stats.framePresented(frame(0, 1000 * ms, position, rate), sinceReady);
+    QCOMPARE(stats.presentationTime(), qint64(1000 * 1000));
+    QCOMPARE(stats.avSyncDrift(), expectedDrift / 1000);
+    QCOMPARE(stats.lateFrames(), quint64(expectedLate ? 1 : 0));
+}
+
+void TestFrameStatistics::testUnknownTiming()
+{
+    FrameStatistics stats;
+    stats.framePresented(frame(0, -1, 1000 * ms), 100 * ms);
+    QCOMPARE(stats.presentationTime(), qint64(-1));
+    QCOMPARE(stats.lateFrames(), quint64(0));
+
+    stats.framePresented(frame(1, 1000 * ms, -1), 100 * ms);
+    QCOMPARE(stats.presentationTime(), qint64(1000 * 1000));
+    QCOMPARE(stats.avSyncDrift(), qint64(0));
+    QCOMPARE(stats.lateFrames(), quint64(0));
+}
+
+QTEST_GUILESS_MAIN(TestFrameStatistics)
+
+#include "test_frame_statistics.moc"
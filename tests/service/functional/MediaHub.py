@@ -14,6 +14,7 @@ class Error:
     ResumingSession = 'core.ubuntu.media.Service.Error.ResumingSession'
     PlayerKeyNotFound = 'core.ubuntu.media.Service.Error.PlayerKeyNotFound'
     PermissionDenied = 'mpris.Player.Error.InsufficientAppArmorPermissions'
+    UriNotFound = 'mpris.Player.Error.UriNotFound'
 
 
 class Service(object):
@@ -84,6 +85,12 @@ class Player(object):
         self.__player.connect_to_signal(
                 'EndOfStream',
                 lambda: self.__on_signal('EndOfStream'))
+        self.__player.connect_to_signal(
+                'Seeked',
+                lambda x: self.__on_signal('Seeked', x))
+        self.__player.connect_to_signal(
+                'PositionAnchor',
+                lambda *args: self.__on_signal('PositionAnchor', *args))
 
     def __on_properties_changed(self, interface, changed, invalidated):
         assert interface == self.interface_name
@@ -149,6 +156,13 @@ class Player(object):
     def stop(self):
         self.__player.Stop()
 
+    def seek(self, microseconds):
+        self.__player.Seek(dbus.UInt64(microseconds))
+
+    def seek_with_mode(self, microseconds, mode):
+        self.__player.SeekWithMode(dbus.UInt64(microseconds),
+                                   dbus.Int16(mode))
+
     def on_properties_changed(self, callback):
         self.__prop_callbacks.append(callback)
 
@@ -171,10 +185,26 @@ class TrackList(object):
                                             introspect=False)
         self.interface_name = 'org.mpris.MediaPlayer2.TrackList'
         self.__track_list = dbus.Interface(session, self.interface_name)
+        self.__props = dbus.Interface(session, dbus.PROPERTIES_IFACE)
+
+    def tracks(self):
+        return self.__props.Get(self.interface_name, 'Tracks')
 
     def add_track(self, track_uri, position=End, set_as_current=False):
         self.__track_list.AddTrack(track_uri, position, set_as_current)
 
+    def add_tracks(self, track_uris, position=End):
+        return self.__track_list.AddTracks(
+            dbus.Array(track_uris, signature='s'), position)
+
+    def get_tracks_metadata(self, track_ids):
+        return self.__track_list.GetTracksMetadata(
+            dbus.Array(track_ids, signature='o'))
+
+    def get_tracks_uris(self, track_ids):
+        return self.__track_list.GetTracksUris(
+            dbus.Array(track_ids, signature='o'))
+
     def reset(self):
         self.__track_list.Reset()
 
@@ -21,7 +21,19 @@ def media_hub_wakelock_timeout(request):
 
 
 @pytest.fixture(scope="function")
-def media_hub_service(request, media_hub_wakelock_timeout):
+def media_hub_gapless_playback(request):
+    return '0'
+
+
+@pytest.fixture(scope="function")
+def media_hub_playbin_pool_size(request):
+    return '1'
+
+
+@pytest.fixture(scope="function")
+def media_hub_service(request, media_hub_wakelock_timeout,
+                      media_hub_gapless_playback,
+                      media_hub_playbin_pool_size):
     """ Spawn a new media-hub service instance
     """
     service_name = "core.ubuntu.media.Service"
@@ -39,6 +51,8 @@ def media_hub_service(request, media_hub_wakelock_timeout):
     environment['CORE_UBUNTU_MEDIA_SERVICE_AUDIO_SINK_NAME'] = 'fakesink'
     environment['CORE_UBUNTU_MEDIA_SERVICE_VIDEO_SINK_NAME'] = 'fakesink'
     environment['MEDIA_HUB_WAKELOCK_TIMEOUT'] = media_hub_wakelock_timeout
+    environment['MEDIA_HUB_GAPLESS_PLAYBACK'] = media_hub_gapless_playback
+    environment['MEDIA_HUB_PLAYBIN_POOL_SIZE'] = media_hub_playbin_pool_size
 
     # Spawn the service, and wait for it to appear on the bus
     args = [os.environ['SERVICE_BINARY']]
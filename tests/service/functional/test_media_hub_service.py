@@ -4,7 +4,7 @@ import subprocess
 import sys
 
 from gi.repository import GLib
-from time import sleep
+from time import monotonic, sleep
 
 import dbus
 import pytest
@@ -78,6 +78,33 @@ class TestMediaHub:
         args = calls[0][1]
         assert args[0] == "powerd-cookie"
 
+    @pytest.mark.parametrize('media_hub_playbin_pool_size', [('0'), ('2')])
+    def test_session_startup_latency(
+            self, bus_obj, media_hub_service_full, data_path,
+            media_hub_playbin_pool_size):
+        """ Measure the time from the session creation to the first frame
+        being rendered, with and without pre-warmed pipelines. """
+        media_hub = MediaHub.Service(bus_obj)
+        video_file = 'file://' + str(data_path.joinpath('small.ogv'))
+
+        latencies = []
+        for i in range(0, 3):
+            # Let the pool refill
+            sleep(0.5)
+            started = monotonic()
+            (object_path, uuid) = media_hub.create_session()
+            player = MediaHub.Player(bus_obj, object_path)
+            player.open_uri(video_file)
+            player.play()
+            assert player.wait_for_prop('PlaybackStatus', 'Playing')
+            latencies.append(monotonic() - started)
+            player.stop()
+            media_hub.destroy_session(uuid)
+
+        print('CreateSession to first frame (pool size {}): {}'.format(
+            media_hub_playbin_pool_size,
+            ', '.join('{:.1f} ms'.format(l * 1000) for l in latencies)))
+
     @pytest.mark.parametrize('apparmor_reply', [
         ('ret = { "LinuxSecurityLabel": "my_app_1.0"}'),
         # Regression test for
@@ -331,6 +358,239 @@ class TestMediaHub:
         calls = powerd.GetMethodCalls('clearSysState')
         assert len(calls) == 0
 
+    @pytest.mark.parametrize('media_hub_gapless_playback', [('0'), ('1')])
+    def test_track_transition_gap(
+            self, bus_obj, media_hub_service_full, data_path,
+            media_hub_gapless_playback):
+        """ Measure the time lost between two tracks of the track list: the
+        wall-clock playback time minus the duration of the tracks. """
+        media_hub = MediaHub.Service(bus_obj)
+        (object_path, uuid) = media_hub.create_session()
+        player = MediaHub.Player(bus_obj, object_path)
+        track_list = MediaHub.TrackList(player)
+
+        events = []
+        lengths = {}
+        def on_changed(interface, changed, invalidated):
+            now = monotonic()
+            if 'PlaybackStatus' in changed:
+                events.append((now, str(changed['PlaybackStatus'])))
+            if 'Metadata' in changed:
+                metadata = changed['Metadata']
+                track_id = str(metadata.get('mpris:trackid', ''))
+                length = int(metadata.get('mpris:length', 0))
+                if length > 0:
+                    lengths[track_id] = length
+        player.on_properties_changed(on_changed)
+
+        for name in ('test-audio.ogg', 'test-audio-1.ogg'):
+            track_list.add_track('file://' + str(data_path.joinpath(name)))
+        assert player.wait_for_prop('CanGoNext', True)
+
+        player.play()
+        assert player.wait_for_prop('PlaybackStatus', 'Playing')
+        started = events[-1][0]
+        assert player.wait_for_prop('CanGoNext', False, timeout=10000)
+        assert player.wait_for_prop('PlaybackStatus', 'Stopped',
+                                    timeout=10000)
+        finished = events[-1][0]
+        player.unsubscribe_properties_changed(on_changed)
+
+        assert len(lengths) == 2
+        played = sum(lengths.values()) / 1000000
+        gap = finished - started - played
+        print('Inter-track gap (gapless={}): {:.1f} ms'.format(
+            media_hub_gapless_playback, gap * 1000))
+
+        statuses = [status for (t, status) in events if t >= started]
+        if media_hub_gapless_playback == '1':
+            # The playback never stops between the two tracks
+            assert statuses == ['Playing', 'Stopped']
+            assert gap < 0.25
+
+    def test_position_anchor(self, bus_obj, media_hub_service_full,
+                             data_path):
+        """ Check that the position extrapolated from the pushed anchors is
+        consistent with the one reported by the service. """
+        media_hub = MediaHub.Service(bus_obj)
+        (object_path, uuid) = media_hub.create_session()
+        player = MediaHub.Player(bus_obj, object_path)
+
+        anchors = []
+        def on_signal(name, *args):
+            if name == 'PositionAnchor':
+                anchors.append((int(args[0]), int(args[1]), float(args[2])))
+        player.on_signal(on_signal)
+
+        player.set_prop('PositionUpdateInterval',
+                        dbus.Int32(100, variant_level=1))
+        assert player.get_prop('PositionUpdateInterval') == 100
+
+        audio_file = 'file://' + str(data_path.joinpath('test-audio-1.ogg'))
+        player.open_uri(audio_file)
+        player.play()
+        assert player.wait_for_prop('PlaybackStatus', 'Playing')
+        GLib.timeout_add(1000, player.loop.quit)
+        player.loop.run()
+        player.pause()
+        assert player.wait_for_prop('PlaybackStatus', 'Paused')
+        GLib.timeout_add(200, player.loop.quit)
+        player.loop.run()
+        player.unsubscribe_signal(on_signal)
+
+        playing = [a for a in anchors if a[2] == 1.0]
+        assert len(playing) >= 5
+        for (prev, anchor) in zip(playing, playing[1:]):
+            (position, timestamp, rate) = prev
+            expected = position + (anchor[1] - timestamp) * rate
+            assert abs(anchor[0] - expected) < 50000000
+
+        # Once paused, the last anchor stays valid
+        (position, timestamp, rate) = anchors[-1]
+        assert rate == 0.0
+        assert abs(player.get_prop('Position') - position) < 10000000
+
+    def test_position_update_interval_per_client(self, bus_obj,
+                                                 media_hub_service_full):
+        """ Clients sharing a session each get the anchors they asked for.
+        """
+        media_hub = MediaHub.Service(bus_obj)
+        (object_path, uuid) = media_hub.create_session()
+        player = MediaHub.Player(bus_obj, object_path)
+        other_bus = dbus.SessionBus(private=True)
+        other = MediaHub.Player(other_bus, object_path)
+
+        player.set_prop('PositionUpdateInterval',
+                        dbus.Int32(100, variant_level=1))
+        other.set_prop('PositionUpdateInterval',
+                       dbus.Int32(5, variant_level=1))
+        assert other.get_prop('PositionUpdateInterval') == 10
+
+        # Another client opting out does not affect this one
+        other.set_prop('PositionUpdateInterval',
+                       dbus.Int32(-1, variant_level=1))
+        assert other.get_prop('PositionUpdateInterval') == -1
+        assert player.get_prop('PositionUpdateInterval') == 100
+
+        other_bus.close()
+        assert player.get_prop('PositionUpdateInterval') == 100
+
+    def test_playback_rate(self, bus_obj, media_hub_service_full,
+                           data_path):
+        media_hub = MediaHub.Service(bus_obj)
+        (object_path, uuid) = media_hub.create_session()
+        player = MediaHub.Player(bus_obj, object_path)
+
+        audio_file = 'file://' + str(data_path.joinpath('test-audio-1.ogg'))
+        player.open_uri(audio_file)
+        minimum_rate = player.get_prop('MinimumRate')
+        maximum_rate = player.get_prop('MaximumRate')
+        assert 0 < minimum_rate <= 1.0 <= maximum_rate
+        if maximum_rate < 2.0:
+            pytest.skip('Pitch correction not available')
+
+        # Rewinding is not supported on audio files
+        player.set_prop('PlaybackRate', dbus.Double(-2.0, variant_level=1))
+        assert player.get_prop('PlaybackRate') == 1.0
+
+        player.set_prop('PlaybackRate', dbus.Double(2.0, variant_level=1))
+        assert player.get_prop('PlaybackRate') == 2.0
+
+        player.play()
+        assert player.wait_for_prop('PlaybackStatus', 'Playing')
+        started = monotonic()
+        assert player.wait_for_prop('PlaybackStatus', 'Stopped',
+                                    timeout=10000)
+        elapsed = monotonic() - started
+        length = int(player.props['Metadata']['mpris:length']) / 1000000
+        print('Played {:.1f} s of audio in {:.1f} s at rate 2.0'.format(
+            length, elapsed))
+        assert elapsed < length * 0.75
+
+    @pytest.mark.parametrize('seek_mode', [(0), (1)])
+    def test_seek_burst(self, bus_obj, media_hub_service_full, data_path,
+                        seek_mode):
+        """ Simulate the user dragging a slider: measure the time needed for
+        the pipeline to settle on the last requested position, and how many
+        of the intermediate seeks were dropped. """
+        media_hub = MediaHub.Service(bus_obj)
+        (object_path, uuid) = media_hub.create_session()
+        player = MediaHub.Player(bus_obj, object_path)
+
+        video_file = 'file://' + str(data_path.joinpath('small.ogv'))
+        player.open_uri(video_file)
+        player.play()
+        assert player.wait_for_prop('PlaybackStatus', 'Playing')
+        player.pause()
+        assert player.wait_for_prop('PlaybackStatus', 'Paused')
+        duration = player.get_prop('Duration') // 1000
+        assert duration > 0
+
+        seeked = []
+        def on_signal(name, *args):
+            if name == 'Seeked':
+                seeked.append((monotonic(), int(args[0])))
+        player.on_signal(on_signal)
+
+        requests = 20
+        targets = [duration * 8 // 10 * i // requests
+                   for i in range(1, requests + 1)]
+        started = monotonic()
+        for target in targets:
+            player.seek_with_mode(target, seek_mode)
+        GLib.timeout_add(2000, player.loop.quit)
+        player.loop.run()
+        player.unsubscribe_signal(on_signal)
+
+        assert 0 < len(seeked) <= requests
+        latency = seeked[-1][0] - started
+        print('Seek burst (mode {}): settled in {:.1f} ms, {} of {} seeks '
+              'dropped'.format(seek_mode, latency * 1000,
+                               requests - len(seeked), requests))
+        if seek_mode == 1:
+            # Accurate seeks land on the last requested position
+            assert abs(seeked[-1][1] - targets[-1]) < 100000
+
+    def test_seek_after_rate_change(self, bus_obj, media_hub_service_full,
+                                    data_path):
+        """ A rate change is a flushing seek too: a seek requested right
+        after it must still be reported, and must not block the next ones
+        (the watchdog only kicks in after 5 seconds). """
+        media_hub = MediaHub.Service(bus_obj)
+        (object_path, uuid) = media_hub.create_session()
+        player = MediaHub.Player(bus_obj, object_path)
+
+        video_file = 'file://' + str(data_path.joinpath('small.ogv'))
+        player.open_uri(video_file)
+        player.play()
+        assert player.wait_for_prop('PlaybackStatus', 'Playing')
+        player.pause()
+        assert player.wait_for_prop('PlaybackStatus', 'Paused')
+        if player.get_prop('MaximumRate') < 2.0:
+            pytest.skip('Playback rate changes not available')
+        duration = player.get_prop('Duration') // 1000
+        assert duration > 0
+
+        seeked = []
+        def wait_for_seek(target):
+            count = len(seeked)
+            timer_id = GLib.timeout_add(2000, player.loop.quit)
+            def on_signal(name, *args):
+                if name == 'Seeked':
+                    seeked.append(int(args[0]))
+                    GLib.source_remove(timer_id)
+                    player.loop.quit()
+            player.on_signal(on_signal)
+            player.seek_with_mode(target, 1)
+            player.loop.run()
+            player.unsubscribe_signal(on_signal)
+            return len(seeked) > count
+
+        player.set_prop('PlaybackRate', dbus.Double(2.0, variant_level=1))
+        assert wait_for_seek(duration // 4)
+        assert wait_for_seek(duration // 2)
+        assert abs(seeked[1] - duration // 2) < 100000
+
     def test_loop(self, bus_obj, media_hub_service_full, data_path):
         media_hub = MediaHub.Service(bus_obj)
         (object_path, uuid) = media_hub.create_session()
@@ -352,6 +612,73 @@ class TestMediaHub:
         assert player.wait_for_signal('AboutToFinish')
         assert player.wait_for_prop('PlaybackStatus', 'Paused')
 
+    def test_tracks_metadata(self, bus_obj, media_hub_service_full, data_path):
+        media_hub = MediaHub.Service(bus_obj)
+        (object_path, uuid) = media_hub.create_session()
+        player = MediaHub.Player(bus_obj, object_path)
+        track_list = MediaHub.TrackList(player)
+
+        uris = ['file://' + str(data_path.joinpath(name))
+                for name in ('test-audio.ogg', 'test-audio-1.ogg')]
+        for uri in uris:
+            track_list.add_track(uri)
+        assert player.wait_for_prop('CanGoNext', True)
+
+        track_ids = [str(track_id) for track_id in track_list.tracks()]
+        assert len(track_ids) == 2
+        unknown_id = '/core/ubuntu/media/Service/sessions/0/TrackList/none'
+
+        # Unknown tracks are skipped
+        metadata = track_list.get_tracks_metadata(
+            [track_ids[1], unknown_id, track_ids[0]])
+        assert [str(m['mpris:trackid']) for m in metadata] == \
+            [track_ids[1], track_ids[0]]
+        assert [str(m['xesam:url']) for m in metadata] == \
+            [uris[1], uris[0]]
+
+        # ...but not in the list of URIs
+        assert track_list.get_tracks_uris(
+            [track_ids[1], unknown_id, track_ids[0]]) == \
+            [uris[1], '', uris[0]]
+
+    def test_apparmor_context_cache(self, bus_obj, media_hub_service_full,
+                                    data_path):
+        media_hub = MediaHub.Service(bus_obj)
+        (object_path, uuid) = media_hub.create_session()
+        player = MediaHub.Player(bus_obj, object_path)
+        track_list = MediaHub.TrackList(player)
+
+        audio_file = 'file://' + str(data_path.joinpath('test-audio.ogg'))
+        for i in range(0, 20):
+            track_list.add_track(audio_file)
+        player.open_uri(audio_file)
+
+        # The context of our connection is only resolved once
+        dbus_apparmor = media_hub_service_full.dbus_apparmor
+        calls = dbus_apparmor.GetMethodCalls('GetConnectionCredentials')
+        assert len(calls) == 1
+
+    def test_add_tracks_partial(self, bus_obj, media_hub_service_full,
+                                data_path):
+        media_hub = MediaHub.Service(bus_obj)
+        (object_path, uuid) = media_hub.create_session()
+        player = MediaHub.Player(bus_obj, object_path)
+        track_list = MediaHub.TrackList(player)
+
+        uris = ['file://' + str(data_path.joinpath(name))
+                for name in ('test-audio.ogg', 'missing.ogg',
+                             'test-audio-1.ogg')]
+        # A missing file does not prevent adding the others
+        results = track_list.add_tracks(uris)
+        assert results == ['', MediaHub.Error.UriNotFound, '']
+        track_ids = track_list.tracks()
+        assert track_list.get_tracks_uris(track_ids) == [uris[0], uris[2]]
+
+        # ...but if nothing can be added, the call fails
+        with pytest.raises(dbus.exceptions.DBusException) as exception:
+            track_list.add_tracks([uris[1]])
+        assert exception.value.get_dbus_name() == MediaHub.Error.UriNotFound
+
     def test_track_reset(self, bus_obj, media_hub_service_full, data_path):
         """ Check that if the track list gets reset while a track is paused
         and a new track is added, when the playback starts again we are
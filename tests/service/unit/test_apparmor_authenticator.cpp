@@ -0,0 +1,160 @@
+/*
+ * Copyright © 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "core/media/apparmor/ubuntu.h"
+
+#include <QObject>
+#include <QTest>
+#include <QUrl>
+#include <QVector>
+
+#include <unistd.h>
+
+using namespace core::ubuntu::media::apparmor::ubuntu;
+
+namespace {
+
+const int batchSize = 10000;
+
+QVector<QUrl> makeBatch(const QString &baseDir)
+{
+    QVector<QUrl> uris;
+    uris.reserve(batchSize);
+    for (int i = 0; i < batchSize; i++) {
+        uris.append(QUrl::fromLocalFile(
+            QString("%1/Artist %2/Album %3/Track %4.ogg")
+            .arg(baseDir).arg(i / 500).arg(i / 20).arg(i)));
+    }
+    return uris;
+}
+
+} // namespace
+
+class TestApparmorAuthenticator: public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testAuthorization_data();
+    void testAuthorization();
+    void testDirectoryCache();
+
+    void benchmarkBatch();
+};
+
+void TestApparmorAuthenticator::testAuthorization_data()
+{
+    QTest::addColumn<QString>("profile");
+    QTest::addColumn<QString>("uri");
+    QTest::addColumn<bool>("allowed");
+
+    const QString uid = QString::number(geteuid());
+    const QString app = "com.example.app_app_1.0";
+    const QString music = "com.ubuntu.music_music_1.0";
+
+    QTest::newRow("unconfined") <<
+        "unconfined" << "file:///home/user/Documents/a.ogg" << true;
+    QTest::newRow("own data") <<
+        app << "file:///home/user/.local/share/com.example.app/a.ogg" << true;
+    QTest::newRow("own cache") <<
+        app << "file:///home/user/.cache/com.example.app/x/a.ogg" << true;
+    QTest::newRow("own runtime dir") <<
+        app << "file:///run/user/" + uid + "/confined/com.example.app/a.ogg" <<
+        true;
+    QTest::newRow("other app data") <<
+        app << "file:///home/user/.local/share/com.other.app/a.ogg" << false;
+    QTest::newRow("own click dir") <<
+        app << "file:///opt/click.ubuntu.com/com.example.app/1/a.ogg" << true;
+    QTest::newRow("system sounds") <<
+        app << "file:///usr/share/sounds/ubuntu/a.ogg" << true;
+    QTest::newRow("music, not whitelisted") <<
+        app << "file:///home/user/Music/a.ogg" << false;
+    QTest::newRow("streaming") <<
+        app << "https://example.com/Documents/a.ogg" << true;
+    QTest::newRow("music, whitelisted") <<
+        music << "file:///home/user/Music/a.ogg" << true;
+    QTest::newRow("removable media") <<
+        music << "file:///media/user/card/a.ogg" << true;
+    QTest::newRow("documents") <<
+        music << "file:///home/user/Documents/a.ogg" << false;
+    // Rules look for substrings, which might be found in the file name
+    QTest::newRow("file name") <<
+        music << "file:///home/user/Documents/mediafile.ogg" << true;
+    QTest::newRow("ui sounds, camera") <<
+        "com.ubuntu.camera_camera_1.0" <<
+        "file:///android/system/media/audio/ui/a.ogg" << true;
+    QTest::newRow("ui sounds, other app") <<
+        app << "file:///android/system/media/audio/ui/a.ogg" << false;
+}
+
+void TestApparmorAuthenticator::testAuthorization()
+{
+    QFETCH(QString, profile);
+    QFETCH(QString, uri);
+    QFETCH(bool, allowed);
+
+    ExistingAuthenticator authenticator;
+    const Context context(profile);
+
+    // The second time the answer might come from the cache
+    for (int i = 0; i < 2; i++) {
+        const auto result =
+            authenticator.authenticate_open_uri_request(context, QUrl(uri));
+        QCOMPARE(std::get<0>(result), allowed);
+        QVERIFY(!std::get<1>(result).isEmpty());
+    }
+}
+
+void TestApparmorAuthenticator::testDirectoryCache()
+{
+    ExistingAuthenticator authenticator;
+    const Context music("com.ubuntu.music_music_1.0");
+    const Context app("com.example.app_app_1.0");
+
+    const QUrl allowed("file:///home/user/Music/a.ogg");
+    const QUrl sibling("file:///home/user/Music/b.ogg");
+    QVERIFY(std::get<0>(
+        authenticator.authenticate_open_uri_request(music, allowed)));
+    QVERIFY(std::get<0>(
+        authenticator.authenticate_open_uri_request(music, sibling)));
+
+    // Decisions are not shared among different contexts
+    QVERIFY(!std::get<0>(
+        authenticator.authenticate_open_uri_request(app, sibling)));
+
+    // ...nor among different directories
+    QVERIFY(!std::get<0>(authenticator.authenticate_open_uri_request(
+        music, QUrl("file:///home/user/Documents/a.ogg"))));
+}
+
+void TestApparmorAuthenticator::benchmarkBatch()
+{
+    const Context context("com.ubuntu.music_music_1.0");
+    const QVector<QUrl> uris = makeBatch("/home/user/Music");
+
+    QBENCHMARK {
+        ExistingAuthenticator authenticator;
+        for (const QUrl &uri: uris) {
+            const auto result =
+                authenticator.authenticate_open_uri_request(context, uri);
+            QVERIFY(std::get<0>(result));
+        }
+    }
+}
+
+QTEST_GUILESS_MAIN(TestApparmorAuthenticator)
+
+#include "test_apparmor_authenticator.moc"
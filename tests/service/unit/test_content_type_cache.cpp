@@ -0,0 +1,147 @@
+/*
+ * Copyright © 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "core/media/content_type_cache.h"
+#include "core/media/metadata_store.h"
+
+#include <QFile>
+#include <QObject>
+#include <QScopedPointer>
+#include <QTemporaryDir>
+#include <QTest>
+#include <QVector>
+
+using namespace core::ubuntu::media;
+
+namespace {
+
+const int playlistSize = 1000;
+
+} // namespace
+
+class TestContentTypeCache: public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void init();
+
+    void testDetectOnce();
+    void testRemoteUri();
+    void testChangedFile();
+    void testSeedFromStore();
+
+    void benchmarkPlaylist();
+
+private:
+    QUrl createFile(const QString &name, const QByteArray &contents = "data");
+
+    QScopedPointer<QTemporaryDir> m_dir;
+};
+
+QUrl TestContentTypeCache::createFile(const QString &name,
+                                      const QByteArray &contents)
+{
+    QFile file(m_dir->filePath(name));
+    if (!file.open(QIODevice::WriteOnly)) return QUrl();
+    file.write(contents);
+    return QUrl::fromLocalFile(file.fileName());
+}
+
+void TestContentTypeCache::init()
+{
+    m_dir.reset(new QTemporaryDir);
+    QVERIFY(m_dir->isValid());
+}
+
+void TestContentTypeCache::testDetectOnce()
+{
+    const QUrl uri = createFile("song.ogg", "OggS");
+    ContentTypeCache cache(nullptr);
+
+    const QString contentType = cache.content_type(uri);
+    QVERIFY(!contentType.isEmpty());
+    QCOMPARE(cache.detection_count(), 1);
+
+    QCOMPARE(cache.content_type(uri), contentType);
+    QCOMPARE(cache.content_type(uri), contentType);
+    QCOMPARE(cache.detection_count(), 1);
+
+    QCOMPARE(cache.content_type(QUrl()), QString());
+}
+
+void TestContentTypeCache::testRemoteUri()
+{
+    const QUrl uri("http://example.com/video.mp4");
+    ContentTypeCache cache(nullptr);
+
+    QCOMPARE(cache.content_type(uri), QString("video/mp4"));
+    QCOMPARE(cache.content_type(uri), QString("video/mp4"));
+    QCOMPARE(cache.detection_count(), 1);
+}
+
+void TestContentTypeCache::testChangedFile()
+{
+    const QUrl uri = createFile("song.ogg", "OggS");
+    ContentTypeCache cache(nullptr);
+
+    cache.content_type(uri);
+    createFile("song.ogg", "OggS and some more");
+    cache.content_type(uri);
+    QCOMPARE(cache.detection_count(), 2);
+}
+
+void TestContentTypeCache::testSeedFromStore()
+{
+    const QUrl uri = createFile("song.ogg", "OggS");
+    auto store = QSharedPointer<MetaDataStore>::create(
+        m_dir->filePath("metadata.cache"));
+    store->store(uri, QVariantMap {{ "xesam:title", "Song" }});
+
+    QString contentType;
+    {
+        ContentTypeCache cache(store);
+        contentType = cache.content_type(uri);
+        QCOMPARE(cache.detection_count(), 1);
+    }
+
+    // A new cache (for example, after a restart) needs no detection
+    ContentTypeCache cache(store);
+    QCOMPARE(cache.content_type(uri), contentType);
+    QCOMPARE(cache.detection_count(), 0);
+}
+
+void TestContentTypeCache::benchmarkPlaylist()
+{
+    QVector<QUrl> playlist;
+    for (int i = 0; i < playlistSize; i++) {
+        playlist.append(createFile(QString("track%1.ogg").arg(i), "OggS"));
+    }
+    ContentTypeCache cache(nullptr);
+
+    // Simulates skipping through the playlist several times
+    QBENCHMARK {
+        for (const QUrl &uri: playlist) {
+            QVERIFY(!cache.content_type(uri).isEmpty());
+        }
+    }
+    QCOMPARE(cache.detection_count(), playlistSize);
+}
+
+QTEST_GUILESS_MAIN(TestContentTypeCache)
+
+#include "test_content_type_cache.moc"
@@ -0,0 +1,297 @@
+/*
+ * Copyright © 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "core/media/dbus_property_notifier.h"
+
+#include <libqtdbustest/DBusTestRunner.h>
+
+#include <QDBusArgument>
+#include <QDBusConnection>
+#include <QElapsedTimer>
+#include <QObject>
+#include <QScopedPointer>
+#include <QSignalSpy>
+#include <QTest>
+#include <QVariantMap>
+
+namespace {
+
+const QString objectPath = QStringLiteral("/test/object");
+
+} // namespace
+
+/* An object with more properties than the old notifier could handle; the
+ * numbered ones share the same NOTIFY signal. */
+class Target: public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.example.Target")
+    Q_PROPERTY(int Level READ level NOTIFY levelChanged)
+    Q_PROPERTY(QVariantMap Metadata READ metadata NOTIFY metadataChanged)
+    Q_PROPERTY(int P0 READ p0 NOTIFY numbersChanged)
+    Q_PROPERTY(int P1 READ p1 NOTIFY numbersChanged)
+    Q_PROPERTY(int P2 READ p2 NOTIFY numbersChanged)
+    Q_PROPERTY(int P3 READ p3 NOTIFY numbersChanged)
+    Q_PROPERTY(int P4 READ p4 NOTIFY numbersChanged)
+    Q_PROPERTY(int P5 READ p5 NOTIFY numbersChanged)
+    Q_PROPERTY(int P6 READ p6 NOTIFY numbersChanged)
+    Q_PROPERTY(int P7 READ p7 NOTIFY numbersChanged)
+    Q_PROPERTY(int P8 READ p8 NOTIFY numbersChanged)
+    Q_PROPERTY(int P9 READ p9 NOTIFY numbersChanged)
+    Q_PROPERTY(int P10 READ p10 NOTIFY numbersChanged)
+    Q_PROPERTY(int P11 READ p11 NOTIFY numbersChanged)
+    Q_PROPERTY(int P12 READ p12 NOTIFY numbersChanged)
+    Q_PROPERTY(int P13 READ p13 NOTIFY numbersChanged)
+    Q_PROPERTY(int P14 READ p14 NOTIFY numbersChanged)
+    Q_PROPERTY(int P15 READ p15 NOTIFY numbersChanged)
+    Q_PROPERTY(int P16 READ p16 NOTIFY numbersChanged)
+    Q_PROPERTY(int P17 READ p17 NOTIFY numbersChanged)
+    Q_PROPERTY(int P18 READ p18 NOTIFY numbersChanged)
+    Q_PROPERTY(int P19 READ p19 NOTIFY numbersChanged)
+    Q_PROPERTY(int P20 READ p20 NOTIFY numbersChanged)
+    Q_PROPERTY(int P21 READ p21 NOTIFY numbersChanged)
+    Q_PROPERTY(int Last READ last NOTIFY lastChanged)
+
+public:
+    int level() const { return m_level; }
+    void setLevel(int level) { m_level = level; Q_EMIT levelChanged(); }
+
+    QVariantMap metadata() const { return m_metadata; }
+    void setMetadata(const QVariantMap &metadata) {
+        m_metadata = metadata;
+        Q_EMIT metadataChanged();
+    }
+
+    int p0() const { return m_base; }
+    int p1() const { return m_base + 1; }
+    int p2() const { return m_base + 2; }
+    int p3() const { return m_base + 3; }
+    int p4() const { return m_base + 4; }
+    int p5() const { return m_base + 5; }
+    int p6() const { return m_base + 6; }
+    int p7() const { return m_base + 7; }
+    int p8() const { return m_base + 8; }
+    int p9() const { return m_base + 9; }
+    int p10() const { return m_base + 10; }
+    int p11() const { return m_base + 11; }
+    int p12() const { return m_base + 12; }
+    int p13() const { return m_base + 13; }
+    int p14() const { return m_base + 14; }
+    int p15() const { return m_base + 15; }
+    int p16() const { return m_base + 16; }
+    int p17() const { return m_base + 17; }
+    int p18() const { return m_base + 18; }
+    int p19() const { return m_base + 19; }
+    int p20() const { return m_base + 20; }
+    int p21() const { return m_base + 21; }
+    void setBase(int base) { m_base = base; Q_EMIT numbersChanged(); }
+
+    int last() const { return m_last; }
+    void setLast(int last) { m_last = last; Q_EMIT lastChanged(); }
+
+Q_SIGNALS:
+    void levelChanged();
+    void metadataChanged();
+    void numbersChanged();
+    void lastChanged();
+
+private:
+    int m_level = 0;
+    QVariantMap m_metadata;
+    int m_base = 0;
+    int m_last = 0;
+};
+
+class Listener: public QObject
+{
+    Q_OBJECT
+
+public:
+    Listener(const QDBusConnection &connection) {
+        QDBusConnection(connection).connect(QString(), objectPath,
+            QStringLiteral("org.freedesktop.DBus.Properties"),
+            QStringLiteral("PropertiesChanged"),
+            this, SLOT(onPropertiesChanged(QString,QVariantMap,QStringList)));
+    }
+
+    QVariantMap lastChanges() const { return m_changes.last(); }
+    QList<QVariantMap> m_changes;
+
+Q_SIGNALS:
+    void propertiesChanged();
+
+private Q_SLOTS:
+    void onPropertiesChanged(const QString &interface,
+                             const QVariantMap &changed,
+                             const QStringList &) {
+        QCOMPARE(interface, QStringLiteral("org.example.Target"));
+        m_changes.append(changed);
+        Q_EMIT propertiesChanged();
+    }
+};
+
+class TestDBusPropertyNotifier: public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void testManyProperties();
+    void testUnchangedValue();
+    void testBatching();
+    void testExplicitNotify();
+
+    void benchmarkChattyProperties();
+
+private:
+    QScopedPointer<QtDBusTest::DBusTestRunner> m_dbus;
+    QScopedPointer<Target> m_target;
+    DBusPropertyNotifier *m_notifier;
+    QScopedPointer<Listener> m_listener;
+};
+
+void TestDBusPropertyNotifier::initTestCase()
+{
+    m_dbus.reset(new QtDBusTest::DBusTestRunner());
+    m_dbus->startServices();
+}
+
+void TestDBusPropertyNotifier::init()
+{
+    QDBusConnection listenerConnection =
+        QDBusConnection::connectToBus(m_dbus->sessionBus(),
+                                      QStringLiteral("listener"));
+    m_listener.reset(new Listener(listenerConnection));
+    m_target.reset(new Target);
+    // The notifier is owned by its target
+    m_notifier = new DBusPropertyNotifier(m_dbus->sessionConnection(),
+                                          objectPath, m_target.data());
+}
+
+void TestDBusPropertyNotifier::cleanup()
+{
+    m_target.reset();
+    m_listener.reset();
+    QDBusConnection::disconnectFromBus(QStringLiteral("listener"));
+}
+
+void TestDBusPropertyNotifier::testManyProperties()
+{
+    QSignalSpy propertiesChanged(m_listener.data(),
+                                 &Listener::propertiesChanged);
+
+    m_target->setLast(7);
+    QVERIFY(propertiesChanged.wait());
+    QCOMPARE(m_listener->lastChanges(), (QVariantMap {{ "Last", 7 }}));
+
+    // A signal shared by several properties notifies all of them
+    m_target->setBase(100);
+    QVERIFY(propertiesChanged.wait());
+    const QVariantMap changes = m_listener->lastChanges();
+    QCOMPARE(changes.count(), 22);
+    QCOMPARE(changes.value("P0").toInt(), 100);
+    QCOMPARE(changes.value("P21").toInt(), 121);
+}
+
+void TestDBusPropertyNotifier::testUnchangedValue()
+{
+    QSignalSpy propertiesChanged(m_listener.data(),
+                                 &Listener::propertiesChanged);
+
+    m_target->setLevel(3);
+    QVERIFY(propertiesChanged.wait());
+    QCOMPARE(m_listener->lastChanges(), (QVariantMap {{ "Level", 3 }}));
+
+    // Setting the same value, or changing it back and forth, sends nothing
+    m_target->setLevel(3);
+    m_target->setLevel(4);
+    m_target->setLevel(3);
+    QVERIFY(!propertiesChanged.wait(200));
+}
+
+void TestDBusPropertyNotifier::testBatching()
+{
+    QSignalSpy propertiesChanged(m_listener.data(),
+                                 &Listener::propertiesChanged);
+    m_notifier->setInterval(50);
+    QCOMPARE(m_notifier->interval(), 50);
+
+    // Changes in the same event loop iteration are sent together
+    m_target->setLevel(1);
+    m_target->setMetadata({{ "xesam:title", "A song" }});
+    QVERIFY(propertiesChanged.wait());
+    const QVariantMap changes = m_listener->lastChanges();
+    QCOMPARE(changes.keys(), (QStringList { "Level", "Metadata" }));
+    QCOMPARE(changes.value("Level").toInt(), 1);
+    QCOMPARE(qdbus_cast<QVariantMap>(changes.value("Metadata")),
+             (QVariantMap {{ "xesam:title", "A song" }}));
+
+    // Changes spread over time are rate-limited
+    propertiesChanged.clear();
+    m_listener->m_changes.clear();
+    QElapsedTimer timer;
+    timer.start();
+    int level = 1;
+    while (timer.elapsed() < 250) {
+        m_target->setLevel(++level);
+        QTest::qWait(2);
+    }
+    QTest::qWait(100);
+    QVERIFY(propertiesChanged.count() > 0);
+    QVERIFY2(propertiesChanged.count() <= 250 / 50 + 1,
+             qPrintable(QString::number(propertiesChanged.count())));
+    // The last value is always delivered
+    QCOMPARE(m_listener->lastChanges().value("Level").toInt(), level);
+}
+
+void TestDBusPropertyNotifier::testExplicitNotify()
+{
+    QSignalSpy propertiesChanged(m_listener.data(),
+                                 &Listener::propertiesChanged);
+
+    // The first notification includes all properties
+    m_notifier->notify({ "Level", "Last" });
+    QVERIFY(propertiesChanged.wait());
+    QCOMPARE(m_listener->lastChanges(), (QVariantMap {
+        { "Level", 0 },
+        { "Last", 0 },
+    }));
+
+    // Properties already sent are not sent again by the queued notification
+    m_target->setLevel(5);
+    m_notifier->notify({ "Level" });
+    QVERIFY(propertiesChanged.wait());
+    QCOMPARE(m_listener->lastChanges(), (QVariantMap {{ "Level", 5 }}));
+    QVERIFY(!propertiesChanged.wait(200));
+}
+
+void TestDBusPropertyNotifier::benchmarkChattyProperties()
+{
+    QBENCHMARK {
+        for (int i = 0; i < 10000; i++) {
+            m_target->setLevel(i);
+            m_target->setMetadata({{ "xesam:title", QString::number(i) }});
+        }
+        QCoreApplication::processEvents();
+    }
+}
+
+QTEST_GUILESS_MAIN(TestDBusPropertyNotifier)
+
+#include "test_dbus_property_notifier.moc"
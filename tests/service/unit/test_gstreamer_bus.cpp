@@ -0,0 +1,223 @@
+/*
+ * Copyright © 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "core/media/gstreamer/bus.h"
+
+#include <QObject>
+#include <QTest>
+#include <QVector>
+
+using namespace gstreamer;
+
+namespace {
+
+const int qosBurstSize = 10000;
+
+} // namespace
+
+class TestGstreamerBus: public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void testTypeMask();
+    void testUnsubscribe();
+    void testDetails();
+
+    void benchmarkQosBurst_data();
+    void benchmarkQosBurst();
+
+private:
+    void post(GstMessage *message) { gst_bus_post(m_gstBus, message); }
+
+    GstElement *m_source;
+    GstBus *m_gstBus;
+};
+
+void TestGstreamerBus::initTestCase()
+{
+    gst_init(nullptr, nullptr);
+}
+
+void TestGstreamerBus::init()
+{
+    m_source = gst_bin_new("playbin");
+    m_gstBus = gst_bus_new();
+}
+
+void TestGstreamerBus::cleanup()
+{
+    gst_object_unref(m_gstBus);
+    gst_object_unref(m_source);
+}
+
+void TestGstreamerBus::testTypeMask()
+{
+    Bus bus(GST_BUS(gst_object_ref(m_gstBus)));
+
+    QVector<GstMessageType> tags, all;
+    bus.onNewMessage([&](const Bus::Message &msg) {
+        tags.append(msg.type);
+    }, GST_MESSAGE_TAG);
+    bus.onNewMessage([&](const Bus::Message &msg) {
+        all.append(msg.type);
+    });
+
+    post(gst_message_new_state_changed(GST_OBJECT(m_source), GST_STATE_NULL,
+                                       GST_STATE_READY,
+                                       GST_STATE_VOID_PENDING));
+    post(gst_message_new_tag(GST_OBJECT(m_source), gst_tag_list_new_empty()));
+    post(gst_message_new_eos(GST_OBJECT(m_source)));
+
+    QTRY_COMPARE(all.count(), 3);
+    QCOMPARE(all, (QVector<GstMessageType> {
+        GST_MESSAGE_STATE_CHANGED, GST_MESSAGE_TAG, GST_MESSAGE_EOS,
+    }));
+    QCOMPARE(tags, QVector<GstMessageType> { GST_MESSAGE_TAG });
+}
+
+void TestGstreamerBus::testUnsubscribe()
+{
+    Bus bus(GST_BUS(gst_object_ref(m_gstBus)));
+    QCOMPARE(int(bus.m_types), 0);
+
+    int errors = 0, eos = 0;
+    const int errorId = bus.onNewMessage([&](const Bus::Message &) {
+        errors++;
+    }, GST_MESSAGE_ERROR);
+    const int eosId = bus.onNewMessage([&](const Bus::Message &) {
+        eos++;
+    }, GST_MESSAGE_EOS);
+    QCOMPARE(int(bus.m_types), int(GST_MESSAGE_ERROR | GST_MESSAGE_EOS));
+
+    bus.unsubscribeFromNewMessage(errorId);
+    QCOMPARE(int(bus.m_types), int(GST_MESSAGE_EOS));
+
+    GError *error = g_error_new_literal(GST_CORE_ERROR, GST_CORE_ERROR_FAILED,
+                                        "Failure");
+    post(gst_message_new_error(GST_OBJECT(m_source), error, "debug"));
+    g_error_free(error);
+    post(gst_message_new_eos(GST_OBJECT(m_source)));
+    QTRY_COMPARE(eos, 1);
+    QCOMPARE(errors, 0);
+
+    bus.unsubscribeFromNewMessage(eosId);
+    QCOMPARE(int(bus.m_types), 0);
+}
+
+void TestGstreamerBus::testDetails()
+{
+    Bus bus(GST_BUS(gst_object_ref(m_gstBus)));
+
+    QByteArray source;
+    QString errorMessage;
+    QString title;
+    GstState newState = GST_STATE_VOID_PENDING;
+    int percent = -1;
+    bus.onNewMessage([&](const Bus::Message &msg) {
+        source = QByteArray(msg.source().constData());
+        switch (msg.type) {
+        case GST_MESSAGE_ERROR:
+            errorMessage =
+                QString::fromUtf8(msg.detail().error_warning_info.error->message);
+            break;
+        case GST_MESSAGE_STATE_CHANGED:
+            newState = msg.detail().state_changed.new_state;
+            break;
+        case GST_MESSAGE_BUFFERING:
+            percent = msg.detail().buffering.percent;
+            break;
+        case GST_MESSAGE_TAG: {
+            gchar *value = nullptr;
+            if (gst_tag_list_get_string(msg.detail().tag.tag_list,
+                                        GST_TAG_TITLE, &value)) {
+                title = QString::fromUtf8(value);
+                g_free(value);
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    });
+
+    GError *error = g_error_new_literal(GST_CORE_ERROR, GST_CORE_ERROR_FAILED,
+                                        "Failure");
+    post(gst_message_new_error(GST_OBJECT(m_source), error, "debug"));
+    g_error_free(error);
+    post(gst_message_new_state_changed(GST_OBJECT(m_source), GST_STATE_READY,
+                                       GST_STATE_PAUSED,
+                                       GST_STATE_VOID_PENDING));
+    post(gst_message_new_buffering(GST_OBJECT(m_source), 42));
+    post(gst_message_new_tag(GST_OBJECT(m_source),
+                             gst_tag_list_new(GST_TAG_TITLE, "A title",
+                                              NULL)));
+
+    QTRY_COMPARE(title, QString("A title"));
+    QCOMPARE(source, QByteArray("playbin"));
+    QCOMPARE(errorMessage, QString("Failure"));
+    QCOMPARE(newState, GST_STATE_PAUSED);
+    QCOMPARE(percent, 42);
+}
+
+void TestGstreamerBus::benchmarkQosBurst_data()
+{
+    QTest::addColumn<bool>("interested");
+
+    QTest::newRow("filtered out") << false;
+    QTest::newRow("parsed") << true;
+}
+
+void TestGstreamerBus::benchmarkQosBurst()
+{
+    QFETCH(bool, interested);
+
+    Bus bus(GST_BUS(gst_object_ref(m_gstBus)));
+    guint64 total = 0;
+    bus.onNewMessage([&](const Bus::Message &msg) {
+        if (msg.type == GST_MESSAGE_QOS) {
+            total += msg.detail().qos.duration;
+        }
+    }, interested ? GST_MESSAGE_ANY :
+        GstMessageType(GST_MESSAGE_ERROR | GST_MESSAGE_EOS));
+
+    QVector<GstMessage*> messages;
+    for (int i = 0; i < qosBurstSize; i++) {
+        messages.append(gst_message_new_qos(GST_OBJECT(m_source), FALSE,
+                                            i, i, i, 1));
+    }
+
+    // Deliver the messages directly, as the main loop would
+    QBENCHMARK {
+        for (GstMessage *message: messages) {
+            Bus::bus_watch_handler(m_gstBus, message, &bus);
+        }
+    }
+    QCOMPARE(total > 0, interested);
+
+    for (GstMessage *message: messages) {
+        gst_message_unref(message);
+    }
+}
+
+QTEST_GUILESS_MAIN(TestGstreamerBus)
+
+#include "test_gstreamer_bus.moc"
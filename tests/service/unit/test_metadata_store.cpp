@@ -0,0 +1,280 @@
+/*
+ * Copyright © 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "core/media/metadata_store.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QObject>
+#include <QScopedPointer>
+#include <QTemporaryDir>
+#include <QTest>
+
+using namespace core::ubuntu::media;
+
+namespace {
+
+const int libraryTrackCount = 10000;
+
+QVariantMap makeMetaData(int n)
+{
+    return QVariantMap {
+        { "xesam:title", QString("Title %1").arg(n) },
+        { "xesam:artist", QStringList { "Artist" } },
+        { "xesam:album", "Album" },
+        { "xesam:trackNumber", n },
+    };
+}
+
+} // namespace
+
+class TestMetaDataStore: public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void init();
+
+    void testInMemory();
+    void testRemoteUri();
+    void testPersistence();
+    void testInvalidation();
+    void testRemovedFile();
+    void testTruncatedFile();
+    void testCompaction();
+    void testContentType();
+
+    void benchmarkLoadAndLookup();
+
+private:
+    QUrl createFile(const QString &name, const QByteArray &contents = "data");
+    QString storePath() const { return m_dir->filePath("metadata.cache"); }
+
+    QScopedPointer<QTemporaryDir> m_dir;
+};
+
+QUrl TestMetaDataStore::createFile(const QString &name,
+                                   const QByteArray &contents)
+{
+    QFile file(m_dir->filePath(name));
+    if (!file.open(QIODevice::WriteOnly)) return QUrl();
+    file.write(contents);
+    return QUrl::fromLocalFile(file.fileName());
+}
+
+void TestMetaDataStore::init()
+{
+    m_dir.reset(new QTemporaryDir);
+    QVERIFY(m_dir->isValid());
+}
+
+void TestMetaDataStore::testInMemory()
+{
+    const QUrl uri = createFile("song.ogg");
+    MetaDataStore store(QString{});
+
+    QVariantMap metadata;
+    QVERIFY(!store.lookup(uri, &metadata));
+
+    store.store(uri, makeMetaData(1));
+    QVERIFY(store.lookup(uri, &metadata));
+    QCOMPARE(metadata, makeMetaData(1));
+}
+
+void TestMetaDataStore::testRemoteUri()
+{
+    const QUrl uri("http://example.com/stream.ogg");
+    MetaDataStore store(storePath());
+
+    store.store(uri, makeMetaData(1));
+    QCOMPARE(store.count(), 0);
+
+    QVariantMap metadata;
+    QVERIFY(!store.lookup(uri, &metadata));
+}
+
+void TestMetaDataStore::testPersistence()
+{
+    const QUrl first = createFile("first.ogg");
+    const QUrl second = createFile("second.ogg");
+
+    {
+        MetaDataStore store(storePath());
+        store.store(first, makeMetaData(1));
+        store.store(second, makeMetaData(2));
+        // Newer entries replace the older ones
+        store.store(first, makeMetaData(3));
+    }
+
+    MetaDataStore store(storePath());
+    QCOMPARE(store.count(), 2);
+
+    QVariantMap metadata;
+    QVERIFY(store.lookup(first, &metadata));
+    QCOMPARE(metadata, makeMetaData(3));
+    QVERIFY(store.lookup(second, &metadata));
+    QCOMPARE(metadata, makeMetaData(2));
+}
+
+void TestMetaDataStore::testInvalidation()
+{
+    const QUrl uri = createFile("song.ogg");
+
+    {
+        MetaDataStore store(storePath());
+        store.store(uri, makeMetaData(1));
+    }
+
+    // Change the size of the file
+    createFile("song.ogg", "different data");
+
+    MetaDataStore store(storePath());
+    QVariantMap metadata;
+    QVERIFY(!store.lookup(uri, &metadata));
+    QCOMPARE(store.count(), 0);
+}
+
+void TestMetaDataStore::testRemovedFile()
+{
+    const QUrl uri = createFile("song.ogg");
+
+    MetaDataStore store(storePath());
+    store.store(uri, makeMetaData(1));
+    QVERIFY(QFile::remove(uri.toLocalFile()));
+
+    QVariantMap metadata;
+    QVERIFY(!store.lookup(uri, &metadata));
+}
+
+void TestMetaDataStore::testTruncatedFile()
+{
+    const QUrl first = createFile("first.ogg");
+    const QUrl second = createFile("second.ogg");
+
+    {
+        MetaDataStore store(storePath());
+        store.store(first, makeMetaData(1));
+        store.store(second, makeMetaData(2));
+    }
+
+    // Simulate a crash while writing the last record
+    QFile file(storePath());
+    QVERIFY(file.resize(file.size() - 3));
+
+    {
+        MetaDataStore store(storePath());
+        QCOMPARE(store.count(), 1);
+        QVariantMap metadata;
+        QVERIFY(store.lookup(first, &metadata));
+        QCOMPARE(metadata, makeMetaData(1));
+
+        // The store is still writable
+        store.store(second, makeMetaData(2));
+    }
+
+    {
+        MetaDataStore store(storePath());
+        QCOMPARE(store.count(), 2);
+    }
+
+    // A file in an unknown format is just discarded
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write("garbage");
+    file.close();
+    MetaDataStore store(storePath());
+    QCOMPARE(store.count(), 0);
+}
+
+void TestMetaDataStore::testCompaction()
+{
+    const QUrl uri = createFile("song.ogg");
+
+    qint64 sizeBefore;
+    {
+        MetaDataStore store(storePath());
+        for (int i = 0; i < 500; i++) {
+            store.store(uri, makeMetaData(i));
+        }
+        sizeBefore = QFileInfo(storePath()).size();
+    }
+
+    MetaDataStore store(storePath());
+    QVERIFY(QFileInfo(storePath()).size() < sizeBefore / 100);
+
+    QVariantMap metadata;
+    QVERIFY(store.lookup(uri, &metadata));
+    QCOMPARE(metadata, makeMetaData(499));
+}
+
+void TestMetaDataStore::testContentType()
+{
+    const QUrl uri = createFile("song.ogg");
+    QString contentType;
+
+    {
+        MetaDataStore store(storePath());
+        // Only files with metadata can have a content type
+        store.store_content_type(uri, "audio/ogg");
+        QVERIFY(!store.lookup_content_type(uri, &contentType));
+
+        store.store(uri, makeMetaData(1));
+        store.store_content_type(uri, "audio/ogg");
+        QVERIFY(store.lookup_content_type(uri, &contentType));
+        QCOMPARE(contentType, QString("audio/ogg"));
+
+        // Updating the metadata preserves the content type
+        store.store(uri, makeMetaData(2));
+    }
+
+    {
+        MetaDataStore store(storePath());
+        QVERIFY(store.lookup_content_type(uri, &contentType));
+        QCOMPARE(contentType, QString("audio/ogg"));
+        QVariantMap metadata;
+        QVERIFY(store.lookup(uri, &metadata));
+        QCOMPARE(metadata, makeMetaData(2));
+    }
+
+    // A changed file needs to be examined again
+    createFile("song.ogg", "different data");
+    MetaDataStore store(storePath());
+    QVERIFY(!store.lookup_content_type(uri, &contentType));
+}
+
+void TestMetaDataStore::benchmarkLoadAndLookup()
+{
+    QVector<QUrl> library;
+    {
+        MetaDataStore store(storePath());
+        for (int i = 0; i < libraryTrackCount; i++) {
+            library.append(createFile(QString("track%1.ogg").arg(i)));
+            store.store(library.last(), makeMetaData(i));
+        }
+    }
+
+    // Simulates re-queueing the whole library after a restart
+    QBENCHMARK {
+        MetaDataStore store(storePath());
+        QVariantMap metadata;
+        for (const QUrl &uri: library) {
+            QVERIFY(store.lookup(uri, &metadata));
+        }
+    }
+}
+
+QTEST_GUILESS_MAIN(TestMetaDataStore)
+
+#include "test_metadata_store.moc"
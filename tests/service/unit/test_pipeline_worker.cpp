@@ -0,0 +1,211 @@
+/*
+ * Copyright © 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "core/media/gstreamer/pipeline_worker.h"
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QScopedPointer>
+#include <QTest>
+#include <QThread>
+#include <QVector>
+
+using namespace gstreamer;
+
+namespace {
+
+const int sessionCount = 8;
+const int slowTeardownMs = 500;
+
+} // namespace
+
+class TestPipelineWorker: public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+
+    void testOrdering();
+    void testKeepsPipelineAlive();
+    void testDestroyedContext();
+    void testStateChange();
+    void testStateChangeResult();
+
+    void benchmarkConcurrentSessions();
+};
+
+void TestPipelineWorker::initTestCase()
+{
+    gst_init(nullptr, nullptr);
+}
+
+void TestPipelineWorker::testOrdering()
+{
+    PipelineWorker worker(4);
+    QCOMPARE(worker.max_threads(), 4);
+
+    const int jobCount = 50;
+    QVector<GstElement*> pipelines;
+    QVector<QVector<int>> executed(3);
+    int doneCount = 0;
+    QThread *mainThread = QThread::currentThread();
+    for (int p = 0; p < executed.count(); p++) {
+        GstElement *pipeline = gst_pipeline_new(nullptr);
+        pipelines.append(pipeline);
+        // Jobs for the same pipeline never run concurrently
+        QVector<int> *list = &executed[p];
+        for (int i = 0; i < jobCount; i++) {
+            worker.run(pipeline, [list, i]() {
+                list->append(i);
+            }, this, [&doneCount, mainThread]() {
+                QCOMPARE(QThread::currentThread(), mainThread);
+                doneCount++;
+            });
+        }
+    }
+
+    for (GstElement *pipeline: pipelines) {
+        worker.wait(pipeline);
+        QCOMPARE(worker.pending(pipeline), 0);
+        gst_object_unref(pipeline);
+    }
+
+    QVector<int> expected;
+    for (int i = 0; i < jobCount; i++) expected.append(i);
+    for (const QVector<int> &list: executed) {
+        QCOMPARE(list, expected);
+    }
+    QTRY_COMPARE(doneCount, jobCount * executed.count());
+}
+
+void TestPipelineWorker::testKeepsPipelineAlive()
+{
+    PipelineWorker worker(1);
+    GstElement *pipeline = gst_pipeline_new(nullptr);
+
+    worker.run(pipeline, []() { QThread::msleep(50); });
+    worker.run(pipeline, []() {});
+    QCOMPARE(worker.pending(pipeline), 2);
+    QVERIFY(GST_OBJECT_REFCOUNT_VALUE(pipeline) > 1);
+
+    worker.wait(pipeline);
+    QCOMPARE(worker.pending(pipeline), 0);
+    QCOMPARE(int(GST_OBJECT_REFCOUNT_VALUE(pipeline)), 1);
+    gst_object_unref(pipeline);
+}
+
+void TestPipelineWorker::testDestroyedContext()
+{
+    PipelineWorker worker(1);
+    GstElement *pipeline = gst_pipeline_new(nullptr);
+
+    bool called = false;
+    QScopedPointer<QObject> context(new QObject);
+    worker.run(pipeline, []() {}, context.data(), [&called]() {
+        called = true;
+    });
+    worker.wait(pipeline);
+    context.reset();
+
+    // Process the posted callback, if any
+    QTest::qWait(10);
+    QVERIFY(!called);
+    gst_object_unref(pipeline);
+}
+
+void TestPipelineWorker::testStateChange()
+{
+    PipelineWorker worker(1);
+    GstElement *pipeline = gst_pipeline_new(nullptr);
+
+    worker.set_state(pipeline, GST_STATE_PAUSED);
+    worker.set_state(pipeline, GST_STATE_PLAYING);
+    worker.wait(pipeline);
+    QCOMPARE(GST_STATE(pipeline), GST_STATE_PLAYING);
+
+    worker.set_state(pipeline, GST_STATE_NULL);
+    worker.wait(pipeline);
+    QCOMPARE(GST_STATE(pipeline), GST_STATE_NULL);
+    gst_object_unref(pipeline);
+}
+
+void TestPipelineWorker::testStateChangeResult()
+{
+    PipelineWorker worker(1);
+    GstElement *pipeline =
+        gst_parse_launch("filesrc location=/nonexistent ! fakesink", nullptr);
+    QVERIFY(pipeline);
+
+    QVector<bool> results;
+    worker.set_state(pipeline, GST_STATE_READY, this,
+                     [&results](bool succeeded) {
+        results.append(succeeded);
+    });
+    // The file is only opened when going to PAUSED
+    worker.set_state(pipeline, GST_STATE_PAUSED, this,
+                     [&results](bool succeeded) {
+        results.append(succeeded);
+    });
+    worker.wait(pipeline);
+    QTRY_COMPARE(results, QVector<bool>({ true, false }));
+
+    worker.set_state(pipeline, GST_STATE_NULL);
+    worker.wait(pipeline);
+    gst_object_unref(pipeline);
+}
+
+/* One session is stuck in a slow teardown, while the others keep changing
+ * state: they must neither wait for it, nor find the main loop blocked. */
+void TestPipelineWorker::benchmarkConcurrentSessions()
+{
+    PipelineWorker worker(2);
+    QVector<GstElement*> sessions;
+    for (int i = 0; i < sessionCount; i++) {
+        sessions.append(gst_pipeline_new(nullptr));
+    }
+
+    QBENCHMARK {
+        worker.run(sessions[0], []() { QThread::msleep(slowTeardownMs); });
+
+        QElapsedTimer timer;
+        timer.start();
+        int completed = 0;
+        for (int i = 1; i < sessionCount; i++) {
+            worker.set_state(sessions[i], GST_STATE_PLAYING);
+            worker.set_state(sessions[i], GST_STATE_PAUSED);
+            worker.run(sessions[i], []() {}, this, [&completed]() {
+                completed++;
+            });
+        }
+        // Returning here at all means that the main thread was not blocked
+        QTRY_COMPARE(completed, sessionCount - 1);
+        QVERIFY(timer.elapsed() < slowTeardownMs);
+
+        worker.wait(sessions[0]);
+    }
+
+    for (GstElement *session: sessions) {
+        worker.set_state(session, GST_STATE_NULL);
+        worker.wait(session);
+        gst_object_unref(session);
+    }
+}
+
+QTEST_GUILESS_MAIN(TestPipelineWorker)
+
+#include "test_pipeline_worker.moc"
@@ -0,0 +1,138 @@
+/*
+ * Copyright © 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "core/media/track.h"
+
+#include <QHash>
+#include <QObject>
+#include <QTest>
+
+using namespace core::ubuntu::media;
+
+class TestTrackId: public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testNull();
+    void testConversion_data();
+    void testConversion();
+    void testInvalidPaths_data();
+    void testInvalidPaths();
+    void testComparison();
+
+    void benchmarkHash();
+};
+
+void TestTrackId::testNull()
+{
+    Track::Id id;
+    QVERIFY(id.isNull());
+    QCOMPARE(id.toString(), QString());
+    QVERIFY(Track::Id::fromString(QString()).isNull());
+
+    id = Track::Id(0, 0);
+    QVERIFY(!id.isNull());
+    id.clear();
+    QVERIFY(id.isNull());
+
+    QVERIFY(!Track::Id::noTrack().isNull());
+    QVERIFY(Track::Id::noTrack() != Track::Id());
+}
+
+void TestTrackId::testConversion_data()
+{
+    QTest::addColumn<Track::Id>("id");
+    QTest::addColumn<QString>("path");
+
+    QTest::newRow("first") << Track::Id(0, 0) <<
+        "/core/ubuntu/media/Service/sessions/0/TrackList/0";
+    QTest::newRow("large") << Track::Id(12, 4000000000U) <<
+        "/core/ubuntu/media/Service/sessions/12/TrackList/4000000000";
+    QTest::newRow("no track") << Track::Id::noTrack() <<
+        "/org/mpris/MediaPlayer2/TrackList/NoTrack";
+}
+
+void TestTrackId::testConversion()
+{
+    QFETCH(Track::Id, id);
+    QFETCH(QString, path);
+
+    QCOMPARE(id.toString(), path);
+    QCOMPARE(Track::Id::fromString(path), id);
+}
+
+void TestTrackId::testInvalidPaths_data()
+{
+    QTest::addColumn<QString>("path");
+
+    QTest::newRow("garbage") << "not a path";
+    QTest::newRow("session") << "/core/ubuntu/media/Service/sessions/3";
+    QTest::newRow("track list") <<
+        "/core/ubuntu/media/Service/sessions/3/TrackList";
+    QTest::newRow("other object") <<
+        "/core/ubuntu/media/Service/sessions/3/Player/1";
+    QTest::newRow("not a number") <<
+        "/core/ubuntu/media/Service/sessions/3/TrackList/one";
+    QTest::newRow("not canonical") <<
+        "/core/ubuntu/media/Service/sessions/03/TrackList/1";
+    QTest::newRow("trailing slash") <<
+        "/core/ubuntu/media/Service/sessions/3/TrackList/1/";
+    QTest::newRow("invalid session") <<
+        "/core/ubuntu/media/Service/sessions/4294967295/TrackList/1";
+}
+
+void TestTrackId::testInvalidPaths()
+{
+    QFETCH(QString, path);
+    QVERIFY(Track::Id::fromString(path).isNull());
+}
+
+void TestTrackId::testComparison()
+{
+    const Track::Id id(1, 2);
+    QCOMPARE(Track::Id(1, 2), id);
+    QVERIFY(Track::Id(2, 1) != id);
+    QVERIFY(Track::Id(1, 3) != id);
+
+    QVERIFY(Track::Id(1, 1) < id);
+    QVERIFY(id < Track::Id(1, 3));
+    QVERIFY(id < Track::Id(2, 0));
+
+    // Same sequence in different sessions
+    QVERIFY(qHash(Track::Id(1, 2)) != qHash(Track::Id(2, 2)));
+}
+
+void TestTrackId::benchmarkHash()
+{
+    const int count = 100000;
+    QHash<Track::Id, int> ids;
+    ids.reserve(count);
+
+    QBENCHMARK {
+        ids.clear();
+        for (int i = 0; i < count; i++) {
+            ids.insert(Track::Id(1, i), i);
+        }
+        for (int i = 0; i < count; i++) {
+            QCOMPARE(ids.value(Track::Id(1, i), -1), i);
+        }
+    }
+}
+
+QTEST_GUILESS_MAIN(TestTrackId)
+
+#include "test_track_id.moc"
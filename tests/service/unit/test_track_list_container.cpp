@@ -0,0 +1,265 @@
+/*
+ * Copyright © 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "core/media/track_list_container.h"
+
+#include <QObject>
+#include <QRandomGenerator>
+#include <QTest>
+
+using namespace core::ubuntu::media;
+
+namespace {
+
+const int largeListSize = 100000;
+
+Track::Id trackId(int n)
+{
+    return Track::Id(0, n);
+}
+
+const Track::Id a = trackId(1);
+const Track::Id b = trackId(2);
+const Track::Id c = trackId(3);
+const Track::Id d = trackId(4);
+const Track::Id e = trackId(5);
+
+TrackList::Container makeList(int size)
+{
+    TrackList::Container list;
+    for (int i = 0; i < size; i++) {
+        list.append(trackId(i));
+    }
+    return list;
+}
+
+} // namespace
+
+class TestTrackListContainer: public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testEmpty();
+    void testInsert();
+    void testRemove();
+    void testMove_data();
+    void testMove();
+    void testIteration();
+    void testRandomEdits();
+
+    void benchmarkAppend();
+    void benchmarkInsertAtFront();
+    void benchmarkLookup();
+    void benchmarkMove();
+    void benchmarkRemove();
+};
+
+void TestTrackListContainer::testEmpty()
+{
+    TrackList::Container list;
+    QVERIFY(list.isEmpty());
+    QCOMPARE(list.count(), 0);
+    QCOMPARE(list.indexOf(trackId(0)), -1);
+    QVERIFY(!list.contains(trackId(0)));
+    QVERIFY(list.begin() == list.end());
+    QVERIFY(!list.remove(trackId(0)));
+}
+
+void TestTrackListContainer::testInsert()
+{
+    TrackList::Container list;
+    list.append(b);
+    list.insert(0, a);
+    list.append(d);
+    list.insert(2, c);
+    // Out of range positions are clamped
+    list.insert(100, e);
+
+    const QVector<Track::Id> expected { a, b, c, d, e };
+    QCOMPARE(list.toVector(), expected);
+    QCOMPARE(list.first(), a);
+    QCOMPARE(list.last(), e);
+    for (int i = 0; i < expected.count(); i++) {
+        QCOMPARE(list.indexOf(expected[i]), i);
+        QCOMPARE(list.at(i), expected[i]);
+    }
+}
+
+void TestTrackListContainer::testRemove()
+{
+    TrackList::Container list(QVector<Track::Id> { a, b, c, d });
+
+    QVERIFY(list.remove(b));
+    QVERIFY(!list.remove(b));
+    QCOMPARE(list.toVector(), (QVector<Track::Id> { a, c, d }));
+    QCOMPARE(list.indexOf(d), 2);
+
+    QVERIFY(list.remove(a));
+    QVERIFY(list.remove(d));
+    QCOMPARE(list.toVector(), (QVector<Track::Id> { c }));
+
+    list.clear();
+    QVERIFY(list.isEmpty());
+}
+
+void TestTrackListContainer::testMove_data()
+{
+    QTest::addColumn<int>("from");
+    QTest::addColumn<int>("to");
+
+    QTest::newRow("forward") << 1 << 3;
+    QTest::newRow("backward") << 3 << 0;
+    QTest::newRow("to end") << 0 << 4;
+    QTest::newRow("no-op") << 2 << 2;
+}
+
+void TestTrackListContainer::testMove()
+{
+    QFETCH(int, from);
+    QFETCH(int, to);
+
+    QVector<Track::Id> expected { a, b, c, d, e };
+    TrackList::Container list(expected);
+
+    list.move(from, to);
+    expected.move(from, to);
+    QCOMPARE(list.toVector(), expected);
+}
+
+void TestTrackListContainer::testIteration()
+{
+    const QVector<Track::Id> expected { a, b, c, d, e };
+    TrackList::Container list(expected);
+
+    QVector<Track::Id> forward;
+    for (const Track::Id &id: list) {
+        forward.append(id);
+    }
+    QCOMPARE(forward, expected);
+
+    QVector<Track::Id> backward;
+    for (auto it = list.end(); it != list.begin();) {
+        --it;
+        backward.prepend(*it);
+    }
+    QCOMPARE(backward, expected);
+
+    // Copies are independent
+    TrackList::Container copy(list);
+    copy.remove(c);
+    QCOMPARE(list.count(), 5);
+    QCOMPARE(copy.count(), 4);
+}
+
+void TestTrackListContainer::testRandomEdits()
+{
+    QRandomGenerator random(42);
+    QVector<Track::Id> expected;
+    TrackList::Container list;
+
+    for (int i = 0; i < 5000; i++) {
+        const int size = expected.count();
+        switch (size == 0 ? 0 : random.bounded(4)) {
+        case 0:
+        case 1: {
+            const int pos = random.bounded(size + 1);
+            list.insert(pos, trackId(i));
+            expected.insert(pos, trackId(i));
+            break;
+        }
+        case 2: {
+            const int pos = random.bounded(size);
+            QVERIFY(list.remove(expected[pos]));
+            expected.remove(pos);
+            break;
+        }
+        case 3: {
+            const int from = random.bounded(size);
+            const int to = random.bounded(size);
+            list.move(from, to);
+            expected.move(from, to);
+            break;
+        }
+        }
+
+        if (!expected.isEmpty()) {
+            const int pos = random.bounded(expected.count());
+            QCOMPARE(list.indexOf(expected[pos]), pos);
+        }
+    }
+
+    QCOMPARE(list.toVector(), expected);
+}
+
+void TestTrackListContainer::benchmarkAppend()
+{
+    QBENCHMARK {
+        TrackList::Container list = makeList(largeListSize);
+        QCOMPARE(list.count(), largeListSize);
+    }
+}
+
+void TestTrackListContainer::benchmarkInsertAtFront()
+{
+    QBENCHMARK {
+        TrackList::Container list;
+        for (int i = 0; i < largeListSize; i++) {
+            list.insert(0, trackId(i));
+        }
+        QCOMPARE(list.first(), trackId(largeListSize - 1));
+    }
+}
+
+void TestTrackListContainer::benchmarkLookup()
+{
+    const TrackList::Container list = makeList(largeListSize);
+
+    QBENCHMARK {
+        for (int i = 0; i < largeListSize; i += 7) {
+            QCOMPARE(list.indexOf(trackId(i)), i);
+        }
+    }
+}
+
+void TestTrackListContainer::benchmarkMove()
+{
+    TrackList::Container list = makeList(largeListSize);
+    QRandomGenerator random(42);
+
+    QBENCHMARK {
+        for (int i = 0; i < largeListSize; i++) {
+            list.move(random.bounded(largeListSize),
+                      random.bounded(largeListSize));
+        }
+    }
+    QCOMPARE(list.count(), largeListSize);
+}
+
+void TestTrackListContainer::benchmarkRemove()
+{
+    QBENCHMARK {
+        TrackList::Container list = makeList(largeListSize);
+        for (int i = 0; i < largeListSize; i += 2) {
+            list.remove(trackId(i));
+        }
+        QCOMPARE(list.count(), largeListSize / 2);
+    }
+}
+
+QTEST_GUILESS_MAIN(TestTrackListContainer)
+
+#include "test_track_list_container.moc"
@@ -0,0 +1,245 @@
+/*
+ * Copyright © 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "core/media/track_list_implementation.h"
+
+#include <QObject>
+#include <QSharedPointer>
+#include <QSignalSpy>
+#include <QTest>
+#include <QVector>
+
+#include <algorithm>
+
+using namespace core::ubuntu::media;
+
+namespace {
+
+QUrl trackUri(int n)
+{
+    return QUrl::fromLocalFile(QString("/music/track%1.ogg").arg(n));
+}
+
+QVariantMap metaDataFor(const QUrl &uri)
+{
+    return {{ "xesam:title", "Title of " + uri.fileName() }};
+}
+
+class FakeExtractor: public Engine::MetaDataExtractor
+{
+public:
+    struct Request {
+        QUrl uri;
+        Callback callback;
+    };
+
+    void meta_data_for_track_with_uri(const QUrl &uri,
+                                      const Callback &cb) override {
+        // Files in the metadata store are reported right away
+        if (cached) {
+            cb(metaDataFor(uri));
+            return;
+        }
+        requests.append({ uri, cb });
+    }
+
+    QUrl complete(int index = 0) {
+        const Request request = requests.takeAt(index);
+        request.callback(metaDataFor(request.uri));
+        return request.uri;
+    }
+
+    QVector<Request> requests;
+    bool cached = false;
+};
+
+} // namespace
+
+class TestTrackListPrefetch: public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+
+    void testOrder();
+    void testShuffleOrder();
+    void testRemoteTracks();
+    void testThrottle();
+    void testRemovedTrack();
+    void testCoalescedNotification();
+
+private:
+    QSharedPointer<FakeExtractor> m_extractor;
+};
+
+void TestTrackListPrefetch::initTestCase()
+{
+    qputenv("MEDIA_HUB_METADATA_PREFETCH", "1");
+    qRegisterMetaType<QVector<Track::Id>>();
+}
+
+void TestTrackListPrefetch::init()
+{
+    m_extractor = QSharedPointer<FakeExtractor>::create();
+}
+
+void TestTrackListPrefetch::testOrder()
+{
+    TrackListImplementation trackList(m_extractor);
+    QVector<QUrl> uris;
+    for (int i = 0; i < 7; i++) {
+        uris.append(trackUri(i));
+    }
+    trackList.add_tracks_with_uri_at(uris,
+                                     TrackListImplementation::afterEmptyTrack());
+    trackList.go_to(trackList.tracks().at(3));
+
+    // The tracks closest to the current one come first
+    const QVector<int> expected { 3, 4, 2, 5, 1, 6, 0 };
+    for (int i: expected) {
+        QTRY_COMPARE(m_extractor->requests.count(), 1);
+        QCOMPARE(m_extractor->complete(), trackUri(i));
+    }
+    QTest::qWait(50);
+    QCOMPARE(m_extractor->requests.count(), 0);
+
+    const Track::Id &id = trackList.tracks().at(5);
+    QCOMPARE(trackList.query_meta_data_for_track(id).toMap(),
+             metaDataFor(trackUri(5)));
+}
+
+void TestTrackListPrefetch::testShuffleOrder()
+{
+    TrackListImplementation trackList(m_extractor);
+    QVector<QUrl> uris;
+    for (int i = 0; i < 7; i++) {
+        uris.append(trackUri(i));
+    }
+    trackList.add_tracks_with_uri_at(uris,
+                                     TrackListImplementation::afterEmptyTrack());
+    trackList.go_to(trackList.tracks().at(3));
+    trackList.setShuffle(true);
+
+    /* Only the current track has been drawn: the prefetch must not draw the
+     * others, so they follow in list order */
+    const QVector<int> expected { 3, 0, 1, 2, 4, 5, 6 };
+    for (int i: expected) {
+        QTRY_COMPARE(m_extractor->requests.count(), 1);
+        QCOMPARE(m_extractor->complete(), trackUri(i));
+    }
+    QTest::qWait(50);
+    QCOMPARE(m_extractor->requests.count(), 0);
+}
+
+void TestTrackListPrefetch::testRemoteTracks()
+{
+    TrackListImplementation trackList(m_extractor);
+    trackList.add_tracks_with_uri_at({
+        QUrl("http://example.com/stream.mp3"),
+        trackUri(1),
+    }, TrackListImplementation::afterEmptyTrack());
+
+    // Remote streams are left to the playbin
+    QTRY_COMPARE(m_extractor->requests.count(), 1);
+    QCOMPARE(m_extractor->complete(), trackUri(1));
+    QTest::qWait(50);
+    QCOMPARE(m_extractor->requests.count(), 0);
+}
+
+void TestTrackListPrefetch::testThrottle()
+{
+    TrackListImplementation trackList(m_extractor);
+    trackList.setPrefetchThrottled(true);
+    QVERIFY(trackList.prefetchThrottled());
+    trackList.add_tracks_with_uri_at({ trackUri(0), trackUri(1) },
+                                     TrackListImplementation::afterEmptyTrack());
+    QTest::qWait(50);
+    QCOMPARE(m_extractor->requests.count(), 0);
+
+    trackList.setPrefetchThrottled(false);
+    QTRY_COMPARE(m_extractor->requests.count(), 1);
+
+    // Requests in flight complete, but no new one is started
+    trackList.setPrefetchThrottled(true);
+    m_extractor->complete();
+    QTest::qWait(50);
+    QCOMPARE(m_extractor->requests.count(), 0);
+
+    trackList.setPrefetchThrottled(false);
+    QTRY_COMPARE(m_extractor->requests.count(), 1);
+}
+
+void TestTrackListPrefetch::testRemovedTrack()
+{
+    TrackListImplementation trackList(m_extractor);
+    QSignalSpy metadataChanged(&trackList,
+                               &TrackListImplementation::tracksMetadataChanged);
+    trackList.add_tracks_with_uri_at({ trackUri(0), trackUri(1), trackUri(2) },
+                                     TrackListImplementation::afterEmptyTrack());
+    QTRY_COMPARE(m_extractor->requests.count(), 1);
+    QCOMPARE(m_extractor->requests[0].uri, trackUri(0));
+
+    // The results for removed tracks are dropped
+    trackList.remove_track(trackList.tracks().at(0));
+    trackList.remove_track(trackList.tracks().at(0));
+    m_extractor->complete();
+    QCOMPARE(m_extractor->requests.count(), 1);
+    QCOMPARE(m_extractor->requests[0].uri, trackUri(2));
+    m_extractor->complete();
+
+    QVERIFY(metadataChanged.wait());
+    QCOMPARE(metadataChanged.count(), 1);
+    const auto ids = metadataChanged[0][0].value<QVector<Track::Id>>();
+    QCOMPARE(ids, QVector<Track::Id> { trackList.tracks().at(0) });
+}
+
+void TestTrackListPrefetch::testCoalescedNotification()
+{
+    m_extractor->cached = true;
+    TrackListImplementation trackList(m_extractor);
+    QSignalSpy metadataChanged(&trackList,
+                               &TrackListImplementation::tracksMetadataChanged);
+
+    const int trackCount = 100;
+    QVector<QUrl> uris;
+    for (int i = 0; i < trackCount; i++) {
+        uris.append(trackUri(i));
+    }
+    trackList.add_tracks_with_uri_at(uris,
+                                     TrackListImplementation::afterEmptyTrack());
+
+    QVERIFY(metadataChanged.wait());
+    QCOMPARE(metadataChanged.count(), 1);
+    auto ids = metadataChanged[0][0].value<QVector<Track::Id>>();
+    std::sort(ids.begin(), ids.end());
+    QVector<Track::Id> expected = trackList.tracks().toVector();
+    std::sort(expected.begin(), expected.end());
+    QCOMPARE(ids, expected);
+
+    for (int i = 0; i < trackCount; i++) {
+        const Track::Id &id = trackList.tracks().at(i);
+        QCOMPARE(trackList.query_meta_data_for_track(id).toMap(),
+                 metaDataFor(trackUri(i)));
+    }
+    QVERIFY(!metadataChanged.wait(400));
+}
+
+QTEST_GUILESS_MAIN(TestTrackListPrefetch)
+
+#include "test_track_list_prefetch.moc"
@@ -0,0 +1,236 @@
+/*
+ * Copyright © 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "core/media/track_list_shuffle.h"
+
+#include <QObject>
+#include <QSet>
+#include <QTest>
+
+using namespace core::ubuntu::media;
+
+namespace {
+
+const int largeListSize = 100000;
+
+Track::Id trackId(int n)
+{
+    return Track::Id(0, n);
+}
+
+TrackList::Container makeList(int size)
+{
+    TrackList::Container list;
+    for (int i = 0; i < size; i++) {
+        list.append(trackId(i));
+    }
+    return list;
+}
+
+bool isPermutation(const QVector<Track::Id> &order,
+                   const TrackList::Container &list)
+{
+    QSet<Track::Id> ids;
+    for (const Track::Id &id: order) {
+        ids.insert(id);
+    }
+    if (order.count() != list.count() || ids.count() != list.count()) {
+        return false;
+    }
+    for (const Track::Id &id: list) {
+        if (!ids.contains(id)) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+class TestTrackListShuffle: public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testEmpty();
+    void testPermutation();
+    void testLazyDraw();
+    void testReset();
+    void testPlace();
+    void testAddRemove();
+    void testUniformity();
+
+    void benchmarkToggle();
+    void benchmarkNext();
+};
+
+void TestTrackListShuffle::testEmpty()
+{
+    TrackList::Container list;
+    TrackList::ShuffleOrder order(&list);
+    QCOMPARE(order.count(), 0);
+    QCOMPARE(order.drawnCount(), 0);
+    QCOMPARE(order.place(trackId(0)), -1);
+    QVERIFY(order.toVector().isEmpty());
+
+    order.reset(trackId(0));
+    QCOMPARE(order.drawnCount(), 0);
+}
+
+void TestTrackListShuffle::testPermutation()
+{
+    const TrackList::Container list = makeList(100);
+    TrackList::ShuffleOrder order(&list);
+
+    QVector<Track::Id> drawn;
+    for (int i = 0; i < order.count(); i++) {
+        drawn.append(order.at(i));
+    }
+    QVERIFY(isPermutation(drawn, list));
+    QCOMPARE(order.toVector(), drawn);
+    QVERIFY(drawn != list.toVector());
+}
+
+void TestTrackListShuffle::testLazyDraw()
+{
+    const TrackList::Container list = makeList(1000);
+    TrackList::ShuffleOrder order(&list);
+
+    const Track::Id first = order.first();
+    QCOMPARE(order.drawnCount(), 1);
+    QCOMPARE(order.at(4), order.at(4));
+    QCOMPARE(order.drawnCount(), 5);
+    QCOMPARE(order.indexOf(first), 0);
+
+    // Past half of the list, the rest is drawn at once
+    order.at(list.count() / 2 + 1);
+    QCOMPARE(order.drawnCount(), list.count());
+    QCOMPARE(order.first(), first);
+    QVERIFY(isPermutation(order.toVector(), list));
+}
+
+void TestTrackListShuffle::testReset()
+{
+    const TrackList::Container list = makeList(10);
+    TrackList::ShuffleOrder order(&list);
+    order.toVector();
+
+    order.reset(trackId(3));
+    QCOMPARE(order.drawnCount(), 1);
+    QCOMPARE(order.first(), trackId(3));
+
+    // A reference to one of the drawn tracks is fine
+    const Track::Id second = order.at(1);
+    order.reset(order.at(1));
+    QCOMPARE(order.first(), second);
+
+    // Unknown tracks are ignored
+    order.reset(trackId(100));
+    QCOMPARE(order.drawnCount(), 0);
+    QVERIFY(isPermutation(order.toVector(), list));
+}
+
+void TestTrackListShuffle::testPlace()
+{
+    const TrackList::Container list = makeList(10);
+    TrackList::ShuffleOrder order(&list);
+
+    order.reset(trackId(5));
+    QCOMPARE(order.indexOf(trackId(7)), -1);
+    QCOMPARE(order.place(trackId(7)), 1);
+    QCOMPARE(order.place(trackId(5)), 0);
+    QCOMPARE(order.place(trackId(7)), 1);
+    QCOMPARE(order.place(trackId(100)), -1);
+    QCOMPARE(order.drawnCount(), 2);
+}
+
+void TestTrackListShuffle::testAddRemove()
+{
+    TrackList::Container list = makeList(20);
+    TrackList::ShuffleOrder order(&list);
+
+    for (int i = 0; i < 5; i++) order.at(i);
+    QVector<Track::Id> drawn;
+    for (int i = 0; i < order.drawnCount(); i++) drawn.append(order.at(i));
+
+    for (int i = 20; i < 40; i++) {
+        list.append(trackId(i));
+        order.trackAdded(trackId(i));
+    }
+    list.remove(drawn[2]);
+    order.trackRemoved(drawn[2]);
+    drawn.remove(2);
+
+    // The drawn tracks keep their relative order
+    QVector<Track::Id> kept;
+    for (const Track::Id &id: order.toVector()) {
+        if (drawn.contains(id)) kept.append(id);
+    }
+    QCOMPARE(kept, drawn);
+    QVERIFY(isPermutation(order.toVector(), list));
+}
+
+void TestTrackListShuffle::testUniformity()
+{
+    const int size = 4;
+    const int rounds = 8000;
+    const TrackList::Container list = makeList(size);
+    TrackList::ShuffleOrder order(&list);
+
+    QVector<int> firsts(size, 0);
+    QVector<int> lasts(size, 0);
+    for (int i = 0; i < rounds; i++) {
+        order.reset();
+        firsts[order.first().sequence()]++;
+        lasts[order.last().sequence()]++;
+    }
+
+    // Each track is expected 2000 times; this is over 10 standard deviations
+    for (int i = 0; i < size; i++) {
+        QVERIFY2(qAbs(firsts[i] - rounds / size) < 400,
+                 qPrintable(QString::number(firsts[i])));
+        QVERIFY2(qAbs(lasts[i] - rounds / size) < 400,
+                 qPrintable(QString::number(lasts[i])));
+    }
+}
+
+void TestTrackListShuffle::benchmarkToggle()
+{
+    const TrackList::Container list = makeList(largeListSize);
+    TrackList::ShuffleOrder order(&list);
+
+    QBENCHMARK {
+        order.reset(trackId(largeListSize / 2));
+        QVERIFY(order.at(1) != trackId(largeListSize / 2));
+    }
+    QCOMPARE(order.drawnCount(), 2);
+}
+
+void TestTrackListShuffle::benchmarkNext()
+{
+    const TrackList::Container list = makeList(largeListSize);
+    TrackList::ShuffleOrder order(&list);
+
+    QBENCHMARK {
+        order.reset();
+        for (int i = 0; i < largeListSize; i++) {
+            order.at(i);
+        }
+    }
+    QVERIFY(isPermutation(order.toVector(), list));
+}
+
+QTEST_GUILESS_MAIN(TestTrackListShuffle)
+
+#include "test_track_list_shuffle.moc"
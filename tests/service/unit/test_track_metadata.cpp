@@ -0,0 +1,215 @@
+/*
+ * Copyright © 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "core/media/track.h"
+#include "core/media/xesam.h"
+
+#include <QObject>
+#include <QTest>
+#include <QVector>
+
+#include <malloc.h>
+
+using namespace core::ubuntu::media;
+
+namespace {
+
+const int largeListSize = 50000;
+
+/* Builds the metadata the way the extractor does, with a new string for
+ * every key and value */
+QVariantMap makeMap(int n)
+{
+    return {
+        { QString::fromStdString(xesam::Title::name),
+          QString("Title of track number %1").arg(n) },
+        { QString::fromStdString(xesam::Album::name),
+          QString("Album %1").arg(n / 12) },
+        { QString::fromStdString(xesam::Artist::name),
+          QString("Artist %1").arg(n / 120) },
+        { QString::fromStdString(xesam::Genre::name),
+          QString("Genre %1").arg(n % 8) },
+        { QString::fromStdString(xesam::TrackNumber::name), uint(n % 12 + 1) },
+        { QString::fromStdString(Track::MetaData::TrackLengthKey),
+          qint64(180000000 + n) },
+        { QString::fromStdString(tags::Image::name), true },
+    };
+}
+
+qint64 allocatedBytes()
+{
+#ifdef __GLIBC__
+#if __GLIBC_PREREQ(2, 33)
+    return mallinfo2().uordblks;
+#else
+    return mallinfo().uordblks;
+#endif
+#else
+    return -1;
+#endif
+}
+
+} // namespace
+
+class TestTrackMetaData: public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testEmpty();
+    void testConversion();
+    void testAccessors();
+    void testUnexpectedTypes();
+    void testInterning();
+
+    void benchmarkMemory();
+    void benchmarkCopy();
+};
+
+void TestTrackMetaData::testEmpty()
+{
+    Track::MetaData metaData;
+    QVERIFY(metaData.isEmpty());
+    QVERIFY(metaData.toMap().isEmpty());
+    QVERIFY(!metaData.isSet(xesam::Title::name));
+    QCOMPARE(metaData, Track::MetaData::fromMap(QVariantMap()));
+
+    metaData.setTitle("A title");
+    QVERIFY(!metaData.isEmpty());
+    metaData.clear();
+    QVERIFY(metaData.isEmpty());
+}
+
+void TestTrackMetaData::testConversion()
+{
+    QVariantMap map = makeMap(3);
+    map.insert(QStringLiteral("xesam:comment"), QStringLiteral("Rare tag"));
+    map.insert(QStringLiteral("bitrate"), uint(128000));
+
+    const Track::MetaData metaData = Track::MetaData::fromMap(map);
+    QCOMPARE(metaData.toMap(), map);
+    QCOMPARE(metaData.value("bitrate"), QVariant(uint(128000)));
+    QVERIFY(metaData.contains<xesam::Genre>());
+    QVERIFY(!metaData.contains<xesam::AlbumArtist>());
+
+    // Types are preserved, since they end up on D-Bus
+    const QVariantMap converted = metaData.toMap();
+    QCOMPARE(converted.value(xesam::TrackNumber::name).userType(),
+             int(QMetaType::UInt));
+    QCOMPARE(converted.value(Track::MetaData::TrackLengthKey).userType(),
+             int(QMetaType::LongLong));
+}
+
+void TestTrackMetaData::testAccessors()
+{
+    Track::MetaData metaData;
+    metaData.setTitle("Title");
+    metaData.setArtist("Artist");
+    metaData.setAlbum("Album");
+    metaData.setTrackId("/track/1");
+    metaData.setTrackLength(1234);
+    metaData.setArtUrl(QUrl("file:///art.png"));
+    metaData.setLastUsed("2026-10-17T10:00:00Z");
+
+    QCOMPARE(metaData.title(), QString("Title"));
+    QCOMPARE(metaData.artist(), QString("Artist"));
+    QCOMPARE(metaData.album(), QString("Album"));
+    QCOMPARE(metaData.trackId(), QString("/track/1"));
+    QCOMPARE(metaData.trackLength(), int64_t(1234));
+    QCOMPARE(metaData.artUrl(), QUrl("file:///art.png"));
+    QCOMPARE(metaData.lastUsed(), QString("2026-10-17T10:00:00Z"));
+    QCOMPARE(metaData.value(xesam::Title::name), QVariant("Title"));
+    QVERIFY(metaData.isSet(Track::MetaData::TrackLengthKey));
+
+    metaData.remove(Track::MetaData::TrackLengthKey);
+    QVERIFY(!metaData.isSet(Track::MetaData::TrackLengthKey));
+    QCOMPARE(metaData.trackLength(), int64_t(0));
+    metaData.remove(xesam::Title::name);
+    QVERIFY(metaData.title().isNull());
+    QCOMPARE(metaData.toMap().count(), 5);
+}
+
+void TestTrackMetaData::testUnexpectedTypes()
+{
+    Track::MetaData metaData;
+    metaData.insert(xesam::Artist::name, QStringList { "One", "Two" });
+    QCOMPARE(metaData.value(xesam::Artist::name),
+             QVariant(QStringList { "One", "Two" }));
+    QVERIFY(metaData.artist().isNull());
+
+    // A value of the expected type replaces it
+    metaData.insert(xesam::Artist::name, QStringLiteral("One"));
+    QCOMPARE(metaData.toMap(),
+             QVariantMap({{ xesam::Artist::name, QStringLiteral("One") }}));
+}
+
+void TestTrackMetaData::testInterning()
+{
+    const Track::MetaData first = Track::MetaData::fromMap(makeMap(0));
+    const Track::MetaData second = Track::MetaData::fromMap(makeMap(1));
+    QCOMPARE(first.artist(), second.artist());
+    QCOMPARE(first.artist().constData(), second.artist().constData());
+    QCOMPARE(first.album().constData(), second.album().constData());
+    QVERIFY(first.title().constData() != second.title().constData());
+}
+
+void TestTrackMetaData::benchmarkMemory()
+{
+    if (allocatedBytes() < 0) QSKIP("Heap statistics not available");
+
+    qint64 start = allocatedBytes();
+    QVector<QVariantMap> maps;
+    maps.reserve(largeListSize);
+    for (int i = 0; i < largeListSize; i++) {
+        maps.append(makeMap(i));
+    }
+    const qint64 mapBytes = allocatedBytes() - start;
+
+    start = allocatedBytes();
+    QVector<Track::MetaData> records;
+    records.reserve(largeListSize);
+    for (const QVariantMap &map: maps) {
+        records.append(Track::MetaData::fromMap(map));
+    }
+    const qint64 recordBytes = allocatedBytes() - start;
+
+    qDebug() << "Bytes per track: QVariantMap" << mapBytes / largeListSize <<
+        "MetaData" << recordBytes / largeListSize;
+    QTest::setBenchmarkResult(recordBytes, QTest::BytesAllocated);
+    QVERIFY(recordBytes * 3 < mapBytes);
+}
+
+void TestTrackMetaData::benchmarkCopy()
+{
+    QVector<Track::MetaData> records;
+    records.reserve(largeListSize);
+    for (int i = 0; i < largeListSize; i++) {
+        records.append(Track::MetaData::fromMap(makeMap(i)));
+    }
+
+    // What update_mpris_metadata() does with the current track
+    QBENCHMARK {
+        for (const Track::MetaData &record: records) {
+            Track::MetaData copy(record);
+            copy.setLastUsed(QStringLiteral("2026-10-17T10:00:00Z"));
+        }
+    }
+}
+
+QTEST_GUILESS_MAIN(TestTrackMetaData)
+
+#include "test_track_metadata.moc"
@@ -0,0 +1,90 @@
+/*
+ * Copyright © 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "core/media/util/uri_batch_check.h"
+
+#include <QFile>
+#include <QObject>
+#include <QScopedPointer>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <unistd.h>
+
+using namespace core::ubuntu::media;
+
+class TestUriBatchCheck: public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testFileTypes();
+    void testDestroyedContext();
+};
+
+void TestUriBatchCheck::testFileTypes()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString playable = dir.filePath("song.ogg");
+    QFile file(playable);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.close();
+    const QString unreadable = dir.filePath("secret.ogg");
+    QVERIFY(QFile::copy(playable, unreadable));
+    QVERIFY(QFile::setPermissions(unreadable, QFile::WriteOwner));
+
+    const QVector<QUrl> uris = {
+        QUrl::fromLocalFile(playable),
+        QUrl::fromLocalFile(dir.path()),
+        QUrl::fromLocalFile(dir.filePath("missing.ogg")),
+        QUrl::fromLocalFile(unreadable),
+        QUrl("http://example.com/missing.ogg"),
+    };
+    QVector<bool> results;
+    UriBatchCheck::run(uris, this, [&results](const QVector<bool> &valid) {
+        results = valid;
+    });
+    QTRY_COMPARE(results.count(), uris.count());
+    QCOMPARE(results[0], true);
+    QCOMPARE(results[1], false);
+    QCOMPARE(results[2], false);
+    // Permissions don't apply to root
+    if (geteuid() != 0) QCOMPARE(results[3], false);
+    QCOMPARE(results[4], true);
+}
+
+void TestUriBatchCheck::testDestroyedContext()
+{
+    bool called = false;
+    bool cancelled = false;
+    QScopedPointer<QObject> context(new QObject);
+    UriBatchCheck::run({ QUrl::fromLocalFile("/") }, context.data(),
+                       [&called](const QVector<bool> &) {
+        called = true;
+    }, [&cancelled]() {
+        cancelled = true;
+    });
+    context.reset();
+
+    QTRY_VERIFY(cancelled);
+    QVERIFY(!called);
+}
+
+QTEST_GUILESS_MAIN(TestUriBatchCheck)
+
+#include "test_uri_batch_check.moc"